@@ -41,6 +41,35 @@ def delete_arg_from_arg_list(line, arg, content):
                   r'\g<1>\g<3>', line)
     """
 
+def resolve_buffer_location(arg, module_id_args, arg_map):
+    """ Resolve the HBM bank of a module argument
+
+    When an array is split into multiple memory ports on Intel devices, the
+    bank of each port depends on the module id, e.g.,
+      __attribute__((buffer_location("HBM(2 + idx)")))
+    This function plugs in the module ids and evaluates the bank as
+      __attribute__((buffer_location("HBM3")))
+
+    Parameters
+    ----------
+    arg:
+        the module definition argument
+    module_id_args:
+        a list storing the module id arguments
+    arg_map:
+        maps from module definition args to module call args
+    """
+    m = re.search(r'buffer_location\("HBM\((.+?)\)"\)', arg)
+    if not m:
+        return arg
+    bank = m.group(1)
+    for module_id in module_id_args:
+        bank = re.sub(r'\b' + re.escape(module_id) + r'\b',
+                      arg_map[module_id], bank)
+    bank = int(sympy.sympify(bank))
+    return arg.replace(m.group(0), f'buffer_location("HBM{bank}")')
+
+
 def print_module_def(
         f,
         arg_map,
@@ -197,7 +226,8 @@ def print_module_def(
             new_def_args = []
             for i in range(len(def_args)):
                 if call_args_type[i] != 'module id' and call_args_type[i] != 'fifo':
-                    new_def_args.append(def_args[i])
+                    new_def_args.append(resolve_buffer_location(
+                        def_args[i], module_id_args, arg_map))
             # f.write(prefix + '(')
             # Print the module_name
             print_content.append(prefix)
@@ -384,148 +414,6 @@ def generate_intel_kernel(
             # f.write('/* Module Definition */\n\n')
 
 
-def contains_pipeline_for(pos, lines):
-    """ Examine if there is any for loop with hls_pipeline annotation inside the current for loop
-
-    """
-    n_l_bracket = 0
-    n_r_bracket = 0
-    code_len = len(lines)
-    init_state = 1
-    while pos < code_len and n_r_bracket <= n_l_bracket:
-        if lines[pos].find('{') != -1:
-            n_l_bracket += 1
-        if lines[pos].find('}') != -1:
-            n_r_bracket += 1
-        if lines[pos].find('for') != -1:
-            if init_state:
-                init_state = 0
-            else:
-                if lines[pos + 1].find('hls_pipeline') != -1:
-                    return 1
-        if n_l_bracket == n_r_bracket and not init_state:
-            break
-        pos += 1
-    return 0
-
-
-def insert_xlnx_pragmas(lines):
-    """ Insert HLS pragmas for Xilinx program
-
-    Replace the comments of "// hls_pipeline" and "// hls_unroll" with
-    HLS pragmas
-    For "// hls pipeline", find the previous for loop before hitting any "}".
-    Insert "#pragma HLS PIPELINE II=1" below the for loop.
-    For "// hls unroll", find the previous for loop before hitting the "simd" mark.
-    Insert "#pragma HLS UNROLL" below the for loop.
-    For "// hls_dependence.x", the position is the same with hls_pipeline.
-    Insert "#pragma HLS DEPENDENCE variable=x inter false".
-
-    Parameters
-    ----------
-    lines:
-        contains the codelines of the program
-    """
-    # Handle hls_dependence
-    handle_dep_pragma = 1
-
-    code_len = len(lines)
-    pos = 0
-    while pos < code_len:
-        line = lines[pos]
-        if line.find("// hls_pipeline") != - \
-                1 or line.find("// hls_dependence") != -1:
-            is_pipeline = 0
-            is_dep = 0
-            if line.find('// hls_pipeline') != -1:
-                is_pipeline = 1
-            else:
-                is_dep = 1
-            # Find if there is any other hls_pipeline/hls_dependence annotation
-            # below
-            n_l_bracket = 0
-            n_r_bracket = 0
-            next_pos = pos + 1
-            find_pipeline = 0
-            init_state = 1
-            while next_pos < code_len and n_r_bracket <= n_l_bracket:
-                if is_pipeline and lines[next_pos].find('hls_pipeline') != -1:
-                    find_pipeline = 1
-                    break
-                if is_dep and lines[next_pos].find(
-                        'hls_dependence') != -1 and handle_dep_pragma:
-                    find_pipeline = 1
-                    break
-                if lines[next_pos].find('{') != -1:
-                    n_l_bracket += 1
-                    init_state = 0
-                if lines[next_pos].find('}') != -1:
-                    n_r_bracket += 1
-                if n_l_bracket == n_r_bracket and not init_state:
-                    break
-                next_pos += 1
-            if find_pipeline:
-                pos += 1
-                continue
-
-            # Find the for loop above before hitting any "}"
-            prev_pos = pos - 1
-            find_for = 0
-            n_l_bracket = 0
-            n_r_bracket = 0
-            while prev_pos >= 0:
-                if lines[prev_pos].find('while') != -1:
-                    break
-                if lines[prev_pos].find('{') != -1:
-                    n_l_bracket += 1
-                if lines[prev_pos].find('}') != -1:
-                    n_r_bracket += 1
-                if lines[prev_pos].find('for') != -1:
-                    if n_l_bracket > n_r_bracket:
-                        # check if the pragma is already inserted
-                        if is_pipeline and lines[prev_pos +
-                                                 1].find('#pragma HLS PIPELINE II=1\n') == -1:
-                            find_for = 1
-                        if is_dep and lines[prev_pos + 2].find(
-                                '#pragma HLS DEPENDENCE') == -1 and handle_dep_pragma:
-                            find_for = 1
-                        # check if there is any other for loop with
-                        # hls_pipeline annotation inside
-                        if contains_pipeline_for(prev_pos, lines):
-                            find_for = 0
-                        break
-                prev_pos -= 1
-            if find_for == 1:
-                # insert the pragma right after the for loop
-                indent = lines[prev_pos].find('for')
-                if line.find("hls_pipeline") != -1:
-                    new_line = ' ' * indent + "#pragma HLS PIPELINE II=1\n"
-                else:
-                    line_cp = line
-                    var_name = line_cp.strip().split('.')[-1]
-                    new_line = ' ' * indent + "#pragma HLS DEPENDENCE variable=" + \
-                        var_name + " inter false\n"
-                lines.insert(prev_pos + 1, new_line)
-                del lines[pos + 1]
-        elif line.find("// hls_unroll") != -1:
-            # Find the for loop above before hitting any "simd"
-            prev_pos = pos - 1
-            find_for = 0
-            while prev_pos >= 0 and lines[prev_pos].find('simd') == -1:
-                if lines[prev_pos].find('for') != -1:
-                    find_for = 1
-                    break
-                prev_pos -= 1
-            if find_for == 1:
-                # insert the pragma right after the for loop
-                indent = lines[prev_pos].find('for')
-                new_line = ' ' * indent + "#pragma HLS UNROLL\n"
-                lines.insert(prev_pos + 1, new_line)
-                del lines[pos + 1]
-        pos = pos + 1
-
-    return lines
-
 def insert_catapult_pragmas(lines):
     """ Insert Catapult HLS pragmas for Catapult program
 
@@ -1068,11 +956,8 @@ def xilinx_run(
     # Simplify the expressions
     lines = simplify_expressions(lines)
 
-    # Change the loop iterator type
-    lines = shrink_bit_width(lines, 'xilinx')
-
-    # Insert the HLS pragmas
-    lines = insert_xlnx_pragmas(lines)
+    # The loop iterator types and the HLS pragmas are printed by AutoSA 
+    # directly, see print_for_xilinx in autosa_xilinx_hls_c.cpp.
 
     # Lift the split_buffers
     lines = lift_split_buffers(lines)
@@ -14,6 +14,38 @@ import shutil
 import math
 import argparse
 
+def load_design_summary(design_dir):
+    """ Load the design summary of the design.
+
+    The design summary is generated by AutoSA with the option "--design-summary".
+    Each line is a JSON record with the fields "type" and "data".
+    Returns a dictionary containing the following infomation, or None if the
+    design summary doesn't exist:
+    - loop_info: list
+    - array_info: dict
+    - design_info: dict
+
+    Parameters
+    ----------
+    design_dir: str
+        The design directory
+    """
+    summary_path = f'{design_dir}/design_summary.ndjson'
+    if not os.path.exists(summary_path):
+        return None
+    summary = {'loop_info': [], 'array_info': {}, 'design_info': {}}
+    with open(summary_path, 'r') as f:
+        for line in f:
+            if not line.strip():
+                continue
+            record = json.loads(line)
+            if record['type'] == 'loop_info':
+                summary['loop_info'].append(record['data'])
+            else:
+                summary[record['type']] = record['data']
+
+    return summary
+
 def extract_latency_info(design_dir):
     """ Extract loop information of the design.
 
@@ -28,21 +60,29 @@ def extract_latency_info(design_dir):
     design_dir: str
         The design directory
     """
-    loop_path = f'{design_dir}/latency_est'
-    loop_info_files = os.listdir(loop_path)
     loop_info_all = {}
     module_names = []
 
-    for f_name in loop_info_files:
-        if f_name == 'array_info.json':
-            with open(loop_path + '/' + f_name) as f:
-                array_info = json.load(f)
-        else:
-            with open(loop_path + '/' + f_name) as f:
-                loop_info_module = json.load(f)
-                module_name = loop_info_module['module_name']
-                loop_info_all[module_name] = loop_info_module
-                module_names.append(module_name)
+    summary = load_design_summary(design_dir)
+    if summary:
+        array_info = summary['array_info']
+        for loop_info_module in summary['loop_info']:
+            module_name = loop_info_module['module_name']
+            loop_info_all[module_name] = loop_info_module
+            module_names.append(module_name)
+    else:
+        loop_path = f'{design_dir}/latency_est'
+        loop_info_files = os.listdir(loop_path)
+        for f_name in loop_info_files:
+            if f_name == 'array_info.json':
+                with open(loop_path + '/' + f_name) as f:
+                    array_info = json.load(f)
+            else:
+                with open(loop_path + '/' + f_name) as f:
+                    loop_info_module = json.load(f)
+                    module_name = loop_info_module['module_name']
+                    loop_info_all[module_name] = loop_info_module
+                    module_names.append(module_name)
 
     module_grouped = {}
     # Place inter_trans and intra_trans module under the outer module
@@ -78,6 +118,127 @@ def extract_latency_info(design_dir):
 
     return ret
 
+def extract_loop_latency_from_hls_rpt(rpt):
+    """ Extract the II and depth of the pipelined loops from the HLS rpt.
+
+    Loops with undefined II or depth (e.g., with variable bounds) are skipped.
+
+    Parameters
+    ----------
+    rpt:
+        HLS report in XML format
+    """
+    loops = []
+    for summary in rpt.iter('SummaryOfLoopLatency'):
+        for loop in summary.iter():
+            II = loop.find('PipelineII')
+            depth = loop.find('PipelineDepth')
+            if II is None or depth is None:
+                continue
+            if II.text is None or depth.text is None:
+                continue
+            if not II.text.strip().isnumeric() or not depth.text.strip().isnumeric():
+                continue
+            loops.append({'II': int(II.text), 'depth': int(depth.text)})
+
+    return loops
+
+def extract_hls_loop_latency(design_dir):
+    """ Extract the loop latency of each module of a synthesized design.
+
+    Designs synthesized per module store the results in "hls_latency.json".
+    Otherwise, the HLS reports of the design are parsed.
+    Returns a dict mapping each module to its pipelined loops.
+
+    Parameters
+    ----------
+    design_dir: str
+        The design directory
+    """
+    if os.path.exists(f'{design_dir}/hls_latency.json'):
+        with open(f'{design_dir}/hls_latency.json', 'r') as f:
+            return json.load(f)
+
+    hls_loops = {}
+    hls_rpts_dir = f'{design_dir}/hls_prj/solution1/syn/report'
+    if not os.path.exists(hls_rpts_dir):
+        return hls_loops
+    hls_rpt_names = [r for r in os.listdir(hls_rpts_dir) if r.endswith('_csynth.xml')]
+    for r in hls_rpt_names:
+        with open(hls_rpts_dir + '/' + r, 'r') as f:
+            root = ET.parse(f).getroot()
+        module_name = r[:-11]
+        # For duplicate modules, get rid of the digits suffix.
+        while module_name[-1].isdigit():
+            module_name = module_name[:-1]
+        # It is possible the module is wrapped.
+        if module_name.endswith('_wrapper'):
+            module_name = module_name[:-8]
+        hls_loops[module_name] = extract_loop_latency_from_hls_rpt(root)
+
+    return hls_loops
+
+def get_stmt_class(module_name, module_prop, array_info):
+    """ Return the statement class of the module used for latency calibration.
+
+    I/O modules are classified by the access direction. PE modules are
+    classified by the data types and the SIMD width.
+
+    Parameters
+    ----------
+    module_name: str
+        The module name
+    module_prop: dict
+        The module properties from the loop info
+    array_info: dict
+        The array info of the design
+    """
+    if module_name.startswith('PE'):
+        ele_types = sorted(set([array_info[a]['ele_type'].replace(' ', '_') \
+                                for a in array_info]))
+        simd = module_prop.get('simd', 1)
+        return f'PE_{"_".join(ele_types)}_simd{simd}'
+    if module_prop['in'] == 1:
+        return 'IO_read'
+    else:
+        return 'IO_write'
+
+def train_latency_calibration(designs):
+    """ Fit the II and depth of each statement class.
+
+    The II and depth of the pipelined loops reported by HLS are averaged over
+    all modules of the same statement class.
+
+    Parameters
+    ----------
+    designs: list
+        A list of (latency_info, hls_loops) pairs of the synthesized designs.
+    """
+    samples = {}
+    for latency_info, hls_loops in designs:
+        array_info = latency_info['array_info']
+        for module_name, module_loop_info in latency_info['loop_infos'].items():
+            if 'dummy' in module_name or module_name not in hls_loops:
+                continue
+            stmt_class = get_stmt_class(module_name, \
+                module_loop_info['module_prop'], array_info)
+            if stmt_class not in samples:
+                samples[stmt_class] = []
+            samples[stmt_class] += hls_loops[module_name]
+
+    calib = {}
+    for stmt_class in samples:
+        loops = samples[stmt_class]
+        if len(loops) == 0:
+            continue
+        calib[stmt_class] = {
+            'II': mean([loop['II'] for loop in loops]),
+            'depth': mean([loop['depth'] for loop in loops]),
+            'n': len(loops)
+        }
+
+    return calib
+
 def convert_latency_infos_to_df(latency_infos):
     """ Convert the latency infos into a dataframe.
 
@@ -224,6 +385,11 @@ def predict_module_latency_xilinx(loop_struct, config):
     """ Predict the module latency for Xilinx FPGAs.
 
     """
+    if 'module_prop' in loop_struct:
+        # Pipelined loops are only charged the fill at each entry when the
+        # module is generated with --loop-flatten, where the pipelined loops
+        # left unflattened are the ones the pass could not merge.
+        config['loop_flatten'] = loop_struct['module_prop'].get('loop_flatten', 0)
     latency = config['latency']
     if "loop" in loop_struct:
         config['under_loop'] = 1
@@ -246,10 +412,26 @@ def predict_module_latency_xilinx(loop_struct, config):
         config['context'][iterator] = {}
         config['context'][iterator]['lb'] = lb_n
         config['context'][iterator]['ub'] = ub_n
-        if config['under_unroll'] == 0:
+        # Loops flattened into a single pipelined loop pay the pipeline fill
+        # and flush once for the total trip count of the nest.
+        if 'flatten' in loop_info:
+            config['flatten_levels'] = int(loop_info['flatten'])
+        flattened = config['flatten_levels'] > 0
+        if flattened:
+            config['flatten_levels'] -= 1
+        child = loop['child']
+        # Otherwise, with loop flattening enabled, a pipelined loop that was
+        # not flattened (an imperfect nest) pays them at each entry.
+        pipeline_entry = config.get('loop_flatten', 0) == 1 and not flattened and \
+            config['under_unroll'] == 0 and \
+            config['module_type'] != 1 and "mark" in child and \
+            child['mark']['mark_name'] == 'hls_pipeline'
+        if pipeline_entry:
+            outer_latency = latency
+            config['latency'] = ub_n - lb_n + 1
+        elif config['under_unroll'] == 0:
             latency = latency * (ub_n - lb_n + 1)
             config['latency'] = latency
-        child = loop['child']
         # if it is an outer module, we will need to update loop_prefix at each loop level.
         if config['module_type'] == 1:
             if config['loop_prefix'] == 'Loop':
@@ -265,6 +447,8 @@ def predict_module_latency_xilinx(loop_struct, config):
         else:
             config['last_for']['under_coalesce'] = 0
         predict_module_latency_xilinx(child, config)
+        if pipeline_entry:
+            config['latency'] = outer_latency * config['latency']
     elif "mark" in loop_struct:
         mark = loop_struct['mark']
         mark_name = mark['mark_name']
@@ -280,6 +464,7 @@ def predict_module_latency_xilinx(loop_struct, config):
     elif "user" in loop_struct:
         user = loop_struct['user']
         user_expr = user['user_expr']
+        under_unroll = config['under_unroll']
         config['under_unroll'] = 0
         config['under_coalesce'] = 0
         if config['module_type'] == 1:
@@ -294,6 +479,15 @@ def predict_module_latency_xilinx(loop_struct, config):
         # Set II and depth to 1 by default.
         II = 1
         depth = 1
+        # The SIMD lanes of reduction statements are combined by a reduction tree,
+        # which deepens the pipeline.
+        if under_unroll == 1:
+            depth += config['reduce_tree_depth']
+        # Use the II and depth fitted from the HLS reports if available.
+        # The fitted depth already covers the reduction tree.
+        if config['calib'] and config['stmt_class'] in config['calib']:
+            II = config['calib'][config['stmt_class']]['II']
+            depth = config['calib'][config['stmt_class']]['depth']
         #print(latency, user_expr)
         if user_expr.find('dram') != -1:
             # This is a DRAM stmt, we will plug in the estimated model.
@@ -434,10 +628,11 @@ def predict_module_latency_xilinx(loop_struct, config):
         latency = latency * max(block_latency, 1)
         config['latency'] = latency
 
-def predict_design_latency(latency_info, cycle=5, early_stop=-1):
+def predict_design_latency(latency_info, cycle=5, early_stop=-1, calib=None):
     """ Predict the latency for a single design.
 
-    We assume that the II and depth for each stmt to be one.
+    We assume that the II and depth for each stmt to be one, unless a
+    calibration fitted from the HLS reports of the training samples is given.
 
     Parameters
     ----------
@@ -447,10 +642,14 @@ def predict_design_latency(latency_info, cycle=5, early_stop=-1):
         The cycle time. (in ns)
     early_stop: int
         The baseline latency. If set -1, early stop is disabled.
+    calib: dict
+        The II and depth of each statement class. If None, II and depth are
+        set to one.
     """
     latency_all = {}
     config = {}
     config['cycle'] = cycle
+    config['calib'] = calib
     module_grouped = latency_info['module_grouped']
     array_info = latency_info['array_info']
     loop_infos = latency_info['loop_infos']
@@ -482,9 +681,13 @@ def predict_design_latency(latency_info, cycle=5, early_stop=-1):
         config['under_coalesce'] = 0
         config['under_serialize'] = 0
         config['under_loop'] = 0
+        config['reduce_tree_depth'] = 0
+        config['flatten_levels'] = 0
         config['last_for'] = {}
         config['array_info'] = array_info
         config['module_name'] = module_name
+        config['stmt_class'] = get_stmt_class(module_name, \
+            loop_infos[module_name]['module_prop'], array_info)
         # 0: default 1: outer 2: inter_trans 3: intra_trans
         config['module_type'] = 0
 
@@ -503,6 +706,8 @@ def predict_design_latency(latency_info, cycle=5, early_stop=-1):
             sub_module_name = module['inter_trans']
             config['module_name'] = sub_module_name
             module_loop_info = loop_infos[sub_module_name]
+            config['stmt_class'] = get_stmt_class(sub_module_name, \
+                module_loop_info['module_prop'], array_info)
             predict_module_latency_xilinx(module_loop_info, config)
             inter_trans_latency = config['latency']
 
@@ -514,6 +719,8 @@ def predict_design_latency(latency_info, cycle=5, early_stop=-1):
             sub_module_name = module['intra_trans']
             config['module_name'] = sub_module_name
             module_loop_info = loop_infos[sub_module_name]
+            config['stmt_class'] = get_stmt_class(sub_module_name, \
+                module_loop_info['module_prop'], array_info)
             predict_module_latency_xilinx(module_loop_info, config)
             intra_trans_latency = config['latency']
 
@@ -523,7 +730,16 @@ def predict_design_latency(latency_info, cycle=5, early_stop=-1):
             #print(intra_trans_latency)
             ## debug
 
-            if module_loop_info['module_prop']['double_buffer'] == 1:
+            if module_loop_info['module_prop'].get('L3_buffer', 0) == 1:
+                # The L3 buffer holds a whole L3 tile. The first tile is
+                # filled before anything is forwarded, and the last one is
+                # drained after the loading stops, so neither overlaps.
+                if module_loop_info['module_prop']['double_buffer'] == 1:
+                    module_latency = inter_trans_latency + intra_trans_latency + \
+                        (outer_latency - 1) * max(inter_trans_latency, intra_trans_latency)
+                else:
+                    module_latency = outer_latency * (inter_trans_latency + intra_trans_latency)
+            elif module_loop_info['module_prop']['double_buffer'] == 1:
                 module_latency = outer_latency * max(inter_trans_latency, intra_trans_latency)
                 if module_loop_info['module_prop']['in'] == 1:
                     module_latency += intra_trans_latency
@@ -539,6 +755,8 @@ def predict_design_latency(latency_info, cycle=5, early_stop=-1):
             latency_all[module_name] = module_latency
         else:
             module_loop_info = loop_infos[module_name]
+            config['reduce_tree_depth'] = \
+                module_loop_info['module_prop'].get('reduce_tree_depth', 0)
             #print(config['module_name'])
             predict_module_latency_xilinx(module_loop_info, config)
             latency_all[module_name] = config['latency']
@@ -21,6 +21,7 @@ from statistics import mean
 import copy
 import logging
 import functools
+import hashlib
 import shutil
 import datetime
 from pathlib import Path
@@ -58,7 +59,7 @@ def generate_loop_candidates(loops, config, stage):
       codegen breakdown.
     - Latency hiding: the loop candidates should be left-inclusive and right-exclusive.
       Similarly, making it right-exclusive to avoid possible single PE case.
-    - SIMD, L2 array partitioning: both left- and right-inclusive
+    - SIMD, L2/L3 array partitioning: both left- and right-inclusive
     Note: for both latency hiding and SIMD, if we choose tiling factor as 1, the
     corresponding stage will be skipeed in AutoSA.
 
@@ -81,6 +82,7 @@ def generate_loop_candidates(loops, config, stage):
         'space_time',
         'array_part',
         'array_part_L2',
+        'array_part_L3',
         'latency_hiding',
         'SIMD_vectorization']:
         raise NameError(f'Stage {stage} is not defined.')
@@ -272,6 +274,8 @@ def train_resource_models_xilinx(config):
     These designs are grouped by kernels.
     Then, it trains a resource model for each kernel using linear regression.
     The trained models are placed in /training/resource_models/
+    If the resource library is enabled, it also trains the models of each module
+    type shared across kernels, which are placed in the library of the board.
 
     """
     tmp_dir = config['tmp_dir']
@@ -294,6 +298,7 @@ def train_resource_models_xilinx(config):
     if os.path.exists(work_dir):
         shutil.rmtree(work_dir)
     os.mkdir(work_dir)
+    design_infos_all = []
     for kernel in training_samples:
         # Create the directory
         cur_work_dir = f'{work_dir}/{kernel}'
@@ -305,19 +310,117 @@ def train_resource_models_xilinx(config):
             design_info = res_model.extract_design_info(design_dir, 1)
             design_infos.append(design_info)
             config['logger'].info(design_dir)
+        design_infos_all += design_infos
         # Convert the design infos to a dataframe
         modules, fifos, df = res_model.convert_design_infos_to_df(design_infos)
         # Train the models
         config['logger'].info(f'Train the resource models for {kernel}...')
         res_model.train(df, modules, fifos, design_infos, cur_work_dir, config['logger'])
 
+    # Train the module type models in the resource library
+    lib_dir = get_resource_lib_dir(config)
+    if lib_dir:
+        Path(lib_dir).mkdir(parents=True, exist_ok=True)
+        config['logger'].info(f'Train the resource library at {lib_dir}...')
+        res_model.train_module_type_models(design_infos_all, lib_dir, config['logger'])
+
+def get_resource_lib_dir(config):
+    """ Return the directory of the resource library of the board.
+
+    The library holds the resource models of each module type shared across
+    kernels. It is placed under the temporary directory unless "path" is
+    specified. Returns None if the library is disabled.
+    """
+    lib = config['setting']['synth'].get('resource_lib', None)
+    if not lib or not lib['enable']:
+        return None
+    if 'path' in lib:
+        lib_root = lib['path']
+    else:
+        lib_root = f'{config["tmp_dir"]}/optimizer/resource_libs'
+    return f'{lib_root}/{config["board"]}'
+
+def get_board_name(hw_info, hw_info_path):
+    """ Return the name of the board described by the hardware info.
+
+    The name is taken from the "board" field if present, then from the suffix
+    of the hw_info file (e.g., "hw_info.json.u250"). Otherwise, it is built
+    from the resource amounts, so that boards with different resources never
+    share a resource library.
+    """
+    if 'board' in hw_info:
+        return hw_info['board']
+    name = os.path.basename(hw_info_path)
+    if name.startswith('hw_info.json.'):
+        return name[len('hw_info.json.'):]
+    return '_'.join([f'{res}{hw_info[res]}' for res in sorted(hw_info)])
+
 @timer
 def train_latency_models_xilinx(config):
-    """ Train the latency model
-
-    Note: We will assume all loops with II = 1 and depth = 1.
+    """ Train the latency model for Xilinx program.
+
+    The latency model assumes II = 1 and depth = 1 for all statements by default.
+    This function collects the II and depth of the pipelined loops from the HLS
+    reports of the synthesized designs, and fits them for each statement class,
+    i.e., I/O read, I/O write, and PE compute of each data type and SIMD width.
+    The designs are grouped by kernels.
+    The calibrations are placed in /training/latency_models/
     """
-    return
+    tmp_dir = config['tmp_dir']
+    config['work_dir'] = f'{tmp_dir}/optimizer/synth'
+    jobs = os.listdir(config['work_dir'])
+    training_samples = {}
+    for job in jobs:
+        job_dir = f'{config["work_dir"]}/{job}'
+        kernels = os.listdir(job_dir)
+        for kernel in kernels:
+            kernel_dir = f'{job_dir}/{kernel}'
+            designs = os.listdir(kernel_dir)
+            if kernel not in training_samples:
+                training_samples[kernel] = []
+            for design in designs:
+                design_dir = f'{kernel_dir}/{design}/output'
+                training_samples[kernel].append(design_dir)
+    # Fit the calibration for each kernel
+    work_dir = f'{tmp_dir}/optimizer/training/latency_models'
+    if os.path.exists(work_dir):
+        shutil.rmtree(work_dir)
+    os.mkdir(work_dir)
+    for kernel in training_samples:
+        cur_work_dir = f'{work_dir}/{kernel}'
+        os.mkdir(cur_work_dir)
+        designs = []
+        for design_dir in training_samples[kernel]:
+            latency_info = lat_model.extract_latency_info(design_dir)
+            hls_loops = lat_model.extract_hls_loop_latency(design_dir)
+            designs.append((latency_info, hls_loops))
+        config['logger'].info(f'Train the latency models for {kernel}...')
+        calib = lat_model.train_latency_calibration(designs)
+        for stmt_class in calib:
+            config['logger'].info(f'{stmt_class}: II={calib[stmt_class]["II"]:.2f} '
+                                  f'depth={calib[stmt_class]["depth"]:.2f} '
+                                  f'({calib[stmt_class]["n"]} loops)')
+        with open(f'{cur_work_dir}/latency_calib.json', 'w') as f:
+            json.dump(calib, f, indent=4)
+
+def load_latency_calib(config, kernel_id):
+    """ Load the latency calibration of the kernel.
+
+    The calibrations are cached in the config. Returns None if the latency
+    models are not trained.
+    """
+    if 'latency_calib' not in config:
+        config['latency_calib'] = {}
+    if kernel_id not in config['latency_calib']:
+        calib_path = f'{config["tmp_dir"]}/optimizer/training/latency_models/' \
+                     f'kernel{kernel_id}/latency_calib.json'
+        calib = None
+        if os.path.exists(calib_path):
+            with open(calib_path, 'r') as f:
+                calib = json.load(f)
+        config['latency_calib'][kernel_id] = calib
+
+    return config['latency_calib'][kernel_id]
 
 def execute_autosa_cmd(config):
     """ Compose the AutoSA command and run.
@@ -383,9 +486,7 @@ def save_design_files(config):
     """
     # Load the kernel id
     design_dir = f'{config["work_dir"]}/output'
-    with open(f'{design_dir}/resource_est/design_info.json', 'r') as f:
-        design_info = json.load(f)
-    kernel_id = design_info['kernel_id']
+    kernel_id = res_model.extract_design_info(design_dir)['kernel_id']
     if not os.path.exists(f'{config["work_dir"]}/kernel{kernel_id}'):
         os.mkdir(f'{config["work_dir"]}/kernel{kernel_id}')
     prj_path = f'{config["work_dir"]}/kernel{kernel_id}'
@@ -414,6 +515,7 @@ def clear_design_files(config):
     execute_sys_cmd(f'rm {config["work_dir"]}/output/latency_est/*', config)
     execute_sys_cmd(f'rm {config["work_dir"]}/output/resource_est/*', config)
     execute_sys_cmd(f'rm {config["work_dir"]}/output/src/*', config)
+    execute_sys_cmd(f'rm -f {config["work_dir"]}/output/design_summary.ndjson', config)
 
 def explore_design(config):
     """ Explore the final design.
@@ -442,13 +544,17 @@ def explore_design(config):
         }
         config['monitor']['last_design'] = cur_design
         design_dir = f'{config["work_dir"]}/output'
+        # Extract the design info
+        design_info = res_model.extract_design_info(design_dir, 0)
+        kernel_id = design_info['kernel_id']
         if config['setting']['search']['metric'] == 'latency':
             #start_time = time.perf_counter()
             # Predict the latency
             latency_info = lat_model.extract_latency_info(design_dir)
             latency = lat_model.predict_design_latency(
                 latency_info, config['setting']['search']['cycle_period'],
-                config['search_results']['opt']['latency'])
+                config['search_results']['opt']['latency'],
+                load_latency_calib(config, kernel_id))
             #runtime = time.perf_counter() - start_time
             #print(f'resource runtime: {runtime}')
             if config['search_results']['opt']['found']:
@@ -463,15 +569,14 @@ def explore_design(config):
 
         # Predict the resource usage
         #start_time = time.perf_counter()
-        design_info = res_model.extract_design_info(design_dir, 0)
         modules, fifos, df = res_model.convert_design_infos_to_df([design_info])
-        kernel_id = design_info['kernel_id']
         # Resource model path
         res_model_path = f'{tmp_dir}/optimizer/training/resource_models/kernel{kernel_id}'
         res = res_model.predict_design_resource_usage(
             df, modules, fifos, design_info,
             res_model_path,
-            config['setting']['search']['resource_target'])
+            config['setting']['search']['resource_target'],
+            get_resource_lib_dir(config))
         cur_design['resource'] = res
 
         if not res_model.resource_valid(res, config['hw_info'], \
@@ -740,7 +845,7 @@ def explore_array_part_L2(config):
                 config['autosa_config']['array_part_L2']['enable'] = array_part_L2_en
                 config['sa_sizes'] = sa_sizes
                 return
-            explore_latency_hiding(config)
+            explore_array_part_L3(config)
             # Revert the changes
             config['autosa_config']['array_part_L2']['enable'] = array_part_L2_en
             config['sa_sizes'] = sa_sizes
@@ -757,10 +862,54 @@ def explore_array_part_L2(config):
                     config['logger'].error(f'CMD failed with error code {ret}')
                     config['sa_sizes'] = sa_sizes
                     continue
-                explore_latency_hiding(config)
+                explore_array_part_L3(config)
                 config['sa_sizes'] = sa_sizes
     else:
+        explore_array_part_L3(config)
+
+
+def explore_array_part_L3(config):
+    """ Explore the stage of third-level array partitioning.
+
+    This stage is only visited when three-level buffering is enabled. AutoSA
+    dumps the L2 array partitioning tile loops, the number of iterations
+    of one L2 array partition ("inner_volume") and the total element size
+    of the arrays ("ele_bytes"), which are used to prune the L3 tiles whose
+    buffers exceed the on-chip memory.
+    """
+    if not config['autosa_config']['array_part_L3']['enable'] or \
+        config['autosa_config']['array_part_L3']['mode'] != 'manual':
+        explore_latency_hiding(config)
+        return
+
+    # Fetch the tuning info
+    with open(f'{config["work_dir"]}/output/tuning.json') as f:
+        tuning = json.load(f)
+    if 'array_part_L3' not in tuning:
+        # This stage is skipped by AutoSA, we will also skip it
+        explore_latency_hiding(config)
+        return
+    loops = tuning['array_part_L3']['tilable_loops']
+    loops_pool = generate_loop_candidates(loops, config, 'array_part_L3')
+    if config['setting'][config['mode']]['pruning']['array_part_L3']['enable']:
+        config['tuning'] = tuning
+        loops_pool = opt_prune.array_part_L3_loops_pruning(loops_pool, config)
+
+    if len(loops_pool) == 0:
+        # No L3 tile fits on-chip, use one L2 array partition per L3 tile.
+        loops_pool = [[1 for l in loops]]
+    for loop in loops_pool:
+        sa_sizes = config['sa_sizes'].copy()
+        config['sa_sizes'].append(
+            f'kernel[]->array_part_L3{str(loop).replace(" ", "")}')
+        config['cmds'][3] = generate_sa_sizes_cmd(config['sa_sizes'])
+        ret = execute_autosa_cmd(config)
+        if ret != 0:
+            config['logger'].error(f'CMD failed with error code {ret}')
+            config['sa_sizes'] = sa_sizes
+            continue
         explore_latency_hiding(config)
+        config['sa_sizes'] = sa_sizes
 
 
 def explore_array_part_single_job(loops, config, work_dir, is_multi_process=0):
@@ -913,10 +1062,12 @@ def explore_space_time(config):
             explore_array_part(config)
         else:
             n_kernel = tuning['space_time']['n_kernel']
+            # Explore the promising kernels first
+            kernel_ids = tuning['space_time'].get('rank', list(range(n_kernel)))
 
             # Iterate through different kernels
             #for kernel_id in [0]:
-            for kernel_id in range(n_kernel):
+            for kernel_id in kernel_ids:
                 config['logger'].info(f'Search kernel {kernel_id}...')
                 sa_sizes = config['sa_sizes'].copy()
                 config['sa_sizes'].append(f'kernel[]->space_time[{kernel_id}]')
@@ -978,6 +1129,9 @@ def synth_train_samples_single_job(config, job_id):
         designs = os.listdir(path)
         for design in designs:
             prj_path = f'{path}/{design}/output'
+            if os.path.exists(f'{prj_path}/resource_est/module_synth.json'):
+                # The modules are already synthesized one by one
+                continue
             # Copy the HLS TCL script to the project
             ret = execute_sys_cmd(
                 f'cp {autosa_prj_path}/autosa_scripts/hls_scripts/hls_script_synth.tcl {prj_path}/hls_script.tcl',
@@ -988,6 +1142,201 @@ def synth_train_samples_single_job(config, job_id):
             ret = execute_sys_cmd('vivado_hls -f hls_script.tcl', config)
             os.chdir(cwd)
 
+def split_module_defs(lines):
+    """ Split the kernel file into the common prefix and the module definitions.
+
+    Each module definition is enclosed by a pair of "/* Module Definition */"
+    comments in the generated kernel file.
+
+    Parameters
+    ----------
+    lines: list
+        contains the codelines of the kernel file
+
+    Returns
+    -------
+    prefix: str
+        codelines before the first module definition
+    module_defs: dict
+        module name -> module definition, in the order of definition
+    """
+    prefix = []
+    module_defs = {}
+    module_def = []
+    inside = False
+    first = True
+    for line in lines:
+        if line.find('/* Module Definition */') != -1:
+            if inside:
+                text = ''.join(module_def)
+                m = re.search(r'void (\w+)\s*\(', text)
+                if m:
+                    module_defs[m.group(1)] = text
+                module_def = []
+            inside = not inside
+            first = False
+            continue
+        if inside:
+            module_def.append(line)
+        elif first:
+            prefix.append(line)
+
+    return ''.join(prefix), module_defs
+
+def build_module_synth_unit(module_name, module_defs):
+    """ Build the source code to synthesize the module standalone.
+
+    The module definition is preceded by the definitions of all the modules
+    it calls, directly or indirectly, in the order of definition.
+
+    Parameters
+    ----------
+    module_name: str
+        name of the module to synthesize
+    module_defs: dict
+        module name -> module definition
+    """
+    used = {module_name}
+    pending = [module_name]
+    while pending:
+        body = module_defs[pending.pop()]
+        for callee in module_defs:
+            if callee not in used and re.search(r'\b' + callee + r'\s*[<(]', body):
+                used.add(callee)
+                pending.append(callee)
+
+    return ''.join([module_defs[m] for m in module_defs if m in used])
+
+def synth_module_single_job(config, tasks):
+    """ Launch HLS synthesis of the distinct modules for each single process
+
+    Each task is a (module name, cache directory) pair. The resource usage
+    and the loop latency extracted from the HLS report are stored in
+    "resource.json" and "latency.json" under the cache directory.
+    """
+    config['logger'] = logging.getLogger('AutoSA-Optimizer')
+    for module_name, cache_dir in tasks:
+        cwd = os.getcwd()
+        os.chdir(cache_dir)
+        ret = execute_sys_cmd('vivado_hls -f hls_script.tcl', config)
+        os.chdir(cwd)
+        rpt_path = f'{cache_dir}/hls_prj/solution1/syn/report/{module_name}_csynth.xml'
+        if ret != 0 or not os.path.exists(rpt_path):
+            config['logger'].error(f'HLS synthesis of module {module_name} failed')
+            continue
+        with open(rpt_path, 'r') as f:
+            root = ET.parse(f).getroot()
+        res = res_model.extract_resource_info_from_hls_rpt(root)
+        loops = lat_model.extract_loop_latency_from_hls_rpt(root)
+        with open(f'{cache_dir}/latency.json', 'w') as f:
+            json.dump(loops, f, indent=4)
+        with open(f'{cache_dir}/resource.json', 'w') as f:
+            json.dump(res, f, indent=4)
+
+@timer
+def synth_train_modules(config, design_dirs, num_proc):
+    """ Synthesize the modules of the training samples with a synthesis cache.
+
+    Most modules repeat across the sampled designs with identical definitions.
+    We hash each module definition together with the code it depends on,
+    i.e., the type definitions, the pragmas and the modules it calls, and
+    synthesize each distinct module only once.
+    The results are kept under "optimizer/synth_cache" and reused by later
+    training runs. The resource usage of the modules of each design is written
+    to "resource_est/module_synth.json", which is loaded by
+    "extract_design_info". The loop latency of the modules is written to
+    "hls_latency.json" for training the latency models.
+
+    Designs using C++ templates for the modules cannot be synthesized per module
+    and are returned to be synthesized as a whole.
+
+    Note that each module is synthesized as the HLS top, so the numbers also
+    include the interface logic of the module ports, which is absent when the
+    module is inlined in the whole design. The resource models trained on
+    these numbers tend to overestimate the small modules.
+
+    Parameters
+    ----------
+    config: dict
+        Global configuration.
+    design_dirs: list
+        The output directories of the sampled designs.
+    num_proc: int
+        Number of processes.
+    """
+    autosa_prj_path = os.environ['AUTOSA_ROOT']
+    cache_root = f'{config["tmp_dir"]}/optimizer/synth_cache'
+    Path(cache_root).mkdir(exist_ok=True)
+    with open(f'{autosa_prj_path}/autosa_scripts/hls_scripts/hls_script_synth.tcl') as f:
+        tcl = f.read()
+    tcl = re.sub(r'add_files -tb .*\n', '', tcl)
+    tcl = tcl.replace('add_files src/kernel_kernel.cpp', 'add_files src/module.cpp')
+
+    design_modules = {}
+    fallback_dirs = []
+    tasks = {}
+    for design_dir in design_dirs:
+        with open(f'{design_dir}/src/kernel_kernel.cpp', 'r') as f:
+            prefix, module_defs = split_module_defs(f.readlines())
+        with open(f'{design_dir}/src/kernel_kernel.h', 'r') as f:
+            header = f.read()
+        modules = res_model.extract_design_info(design_dir)['modules']
+        if any(module_defs[m].lstrip().startswith('template') for m in module_defs):
+            fallback_dirs.append(design_dir)
+            continue
+        design_modules[design_dir] = {}
+        for module in modules:
+            # The module could be wrapped.
+            top = module if module in module_defs else f'{module}_wrapper'
+            if top not in module_defs:
+                continue
+            src = prefix + build_module_synth_unit(top, module_defs)
+            module_tcl = tcl.replace('set_top kernel0', f'set_top {top}')
+            key = hashlib.sha1((header + src + module_tcl).encode()).hexdigest()
+            cache_dir = f'{cache_root}/{key}'
+            design_modules[design_dir][module] = cache_dir
+            if key in tasks or (os.path.exists(f'{cache_dir}/resource.json') and \
+                                os.path.exists(f'{cache_dir}/latency.json')):
+                continue
+            Path(f'{cache_dir}/src').mkdir(parents=True, exist_ok=True)
+            with open(f'{cache_dir}/src/kernel_kernel.h', 'w') as f:
+                f.write(header)
+            with open(f'{cache_dir}/src/module.cpp', 'w') as f:
+                f.write(src)
+            with open(f'{cache_dir}/hls_script.tcl', 'w') as f:
+                f.write(module_tcl)
+            tasks[key] = (top, cache_dir)
+
+    n_module = sum([len(design_modules[d]) for d in design_modules])
+    config['logger'].info(f'Synthesize {len(tasks)} distinct modules out of {n_module} modules...')
+    tasks = list(tasks.values())
+    if len(tasks) > 0:
+        chunk_size = int(np.ceil(float(len(tasks)) / num_proc))
+        task_chunks = [tasks[i: i + chunk_size] for i in range(0, len(tasks), chunk_size)]
+        pool = multiprocessing.Pool(processes=num_proc)
+        logger = config['logger']
+        config['logger'] = None
+        pool.starmap(synth_module_single_job, [(config, chunk) for chunk in task_chunks])
+        config['logger'] = logger
+
+    # Collect the results for each design
+    for design_dir in design_modules:
+        module_res = {}
+        module_loops = {}
+        for module, cache_dir in design_modules[design_dir].items():
+            if os.path.exists(f'{cache_dir}/resource.json'):
+                with open(f'{cache_dir}/resource.json', 'r') as f:
+                    module_res[module] = json.load(f)
+            if os.path.exists(f'{cache_dir}/latency.json'):
+                with open(f'{cache_dir}/latency.json', 'r') as f:
+                    module_loops[module] = json.load(f)
+        with open(f'{design_dir}/resource_est/module_synth.json', 'w') as f:
+            json.dump(module_res, f, indent=4)
+        with open(f'{design_dir}/hls_latency.json', 'w') as f:
+            json.dump(module_loops, f, indent=4)
+
+    return fallback_dirs
+
 @timer
 def generate_train_samples(config):
     """ Generate the training samples.
@@ -1073,6 +1422,19 @@ def synth_train_samples(config):
             ret = execute_sys_cmd(
                 f'cp -r {design_path} {new_design_path}', config)
 
+    # Synthesize each distinct module once
+    if config['setting']['synth'].get('module_cache', 0):
+        design_dirs = []
+        for job_id in range(len(task_chunks)):
+            for task in task_chunks[job_id]:
+                design = task[1].rsplit('/', 1)[-1]
+                design_dirs.append(
+                    f'{config["work_dir"]}/job{job_id}/{task[0]}/{design}/output')
+        fallback_dirs = synth_train_modules(config, design_dirs, num_proc)
+        if len(fallback_dirs) == 0:
+            return
+        config['logger'].info(f'{len(fallback_dirs)} designs use module templates and are synthesized as a whole')
+
     # Execute the HLS synthesis
     pool = multiprocessing.Pool(processes=num_proc)
     config['logger'].info(f'Launch HLS synthesis with {num_proc} processes...')
@@ -1112,9 +1474,9 @@ def train_xilinx(config):
     config['logger'].info('Train resource models...')
     train_resource_models_xilinx(config)
 
-    ## Train the latency models
-    # config['logger'].info('Train latency models...')
-    # train_latency_models_xilinx(config) # TODO
+    # Train the latency models
+    config['logger'].info('Train latency models...')
+    train_latency_models_xilinx(config)
 
 def get_default_pruning_policy(mode):
     """ Return the default search pruning policy.
@@ -1145,6 +1507,11 @@ def get_sample_policy(mode, n_random=2):
                 "n": n_random,
                 "loop_limit": -1
             },
+            "array_part_L3": {
+                "mode": "random",
+                "n": n_random,
+                "loop_limit": -1
+            },
             "latency_hiding": {
                 "mode": "random",
                 "n": n_random,
@@ -1168,6 +1535,11 @@ def get_sample_policy(mode, n_random=2):
                 "n": -1,
                 "loop_limit": -1
             },
+            "array_part_L3": {
+                "mode": "exhaustive",
+                "n": -1,
+                "loop_limit": -1
+            },
             "latency_hiding": {
                 "mode": "exhaustive",
                 "n": -1,
@@ -1552,6 +1924,8 @@ def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir):
         The default working directory.
       hw_info: dict
         The hardware configuration.
+      board: str
+        The board name derived from the hardware configuration.
       logger:
         The default logger.
       cmds: list
@@ -1564,6 +1938,8 @@ def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir):
         A list of AutoSA tiling factors.
       two_level_buffer: boolean
         Is two_level_buffer enabled.
+      three_level_buffer: boolean
+        Is three_level_buffer enabled.
       hbm: boolean
         Is HBM enabled.
       kernel_file_path: str
@@ -1596,7 +1972,11 @@ def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir):
         config['work_dir'] = f'{tmp_dir}/optimizer/search/job0'
     with open(hw_info) as f:
         config['hw_info'] = json.load(f)
-    config['cmds'] = [cmd]
+    config['board'] = get_board_name(config['hw_info'], hw_info)
+    # Collect the estimation info of each design in a single design summary.
+    # The designs of a job share the output directory, where the dependence
+    # cache lets the repeated AutoSA invocations skip the dependence analysis.
+    config['cmds'] = [cmd + ' --autosa-design-summary --autosa-dep-cache']
     config['cmds'].append(
         f'--autosa-config={config["work_dir"]}/autosa_config.json')
     config['cmds'].append(f'--autosa-output-dir={config["work_dir"]}/output')
@@ -1614,6 +1994,10 @@ def init_config(setting, verbose, hw_info, cmd, training, search, tmp_dir):
         config['two_level_buffer'] = 1
     else:
         config['two_level_buffer'] = 0
+    if cmd.find('three-level-buffer') != -1:
+        config['three_level_buffer'] = 1
+    else:
+        config['three_level_buffer'] = 0
     if cmd.find('hbm') != -1:
         config['hbm'] = 1
     else:
@@ -1702,6 +2086,9 @@ def xilinx_run(cmd, hw_info, setting, training, search, verbose, tmp_dir):
                      "array_part": {"enable": 1, "mode": "manual"},
                      "array_part_L2": {
         "enable": config['two_level_buffer'],
+        "mode": "manual"},
+                     "array_part_L3": {
+        "enable": config['three_level_buffer'],
         "mode": "manual"},
         "latency": {"enable": 1, "mode": "manual"},
         "simd": {"enable": 1, "mode": "manual"},
@@ -66,6 +66,44 @@ def array_part_L2_loops_pruning(loops, config):
     return pruned_loops
 
 
+def array_part_L3_loops_pruning(loops, config):
+    """ Apply pruning on L3 array partitioning candidate loops.
+
+    The L3 buffers hold the data of one L3 tile. Following the array
+    partitioning model in AutoSA, each array is accessed by a face of the
+    tile and is double buffered. We drop the candidates whose L3 buffers
+    exceed the URAM (or BRAM18K if there is no URAM) of the device.
+
+    Parameters
+    ----------
+    loops: list
+        A list of candidate loops
+    config:
+        Global configuration
+    """
+    pruned_loops = []
+    tuning = config['tuning']['array_part_L3']
+    inner_volume = tuning['inner_volume']
+    if inner_volume <= 0:
+        return loops
+    hw_info = config['hw_info']
+    if hw_info.get('URAM', 0) > 0:
+        budget = hw_info['URAM'] * 36864
+    else:
+        budget = hw_info['BRAM18K'] * 2304
+    for loop in loops:
+        volume = inner_volume
+        for l in loop:
+            volume *= l
+        n = len(loop)
+        face = volume ** ((n - 1) / n) if n > 1 else 1
+        if 2 * face * tuning['ele_bytes'] > budget:
+            continue
+        pruned_loops.append(loop)
+
+    return pruned_loops
+
+
 def latency_hiding_loops_pruning(loops, config):
     """ Apply pruning on latency hiding candidate loops.
 
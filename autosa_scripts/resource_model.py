@@ -14,6 +14,7 @@ import shutil
 import math
 import pprint
 import argparse
+from latency_model import load_design_summary
 
 # Helper functions to predict certain modules
 def BRAM_predict_HLS(dw, depth, use_18K=0):
@@ -134,6 +135,8 @@ def extract_design_info(design_dir, synth=0):
     """ Extract the design infomation.
 
     Load the design_info.json and design_info.dat under the diretory 'resource_est'.
+    If the design summary exists, the design info is loaded from it instead of
+    design_info.json.
     If synth is set to 1, load the HLS reports.
     Return a dictionary that contains all the information above.
     - FF: int
@@ -164,9 +167,13 @@ def extract_design_info(design_dir, synth=0):
         Is the design synthesized or not.
     """
     # Load the design info
-    f_dir = f'{design_dir}/resource_est/design_info.json'
-    with open(f_dir, 'r') as f:
-        design_info = json.load(f)
+    summary = load_design_summary(design_dir)
+    if summary:
+        design_info = summary['design_info']
+    else:
+        f_dir = f'{design_dir}/resource_est/design_info.json'
+        with open(f_dir, 'r') as f:
+            design_info = json.load(f)
     design_info['fifos'] = {}
     f_dir = f'{design_dir}/resource_est/design_info.dat'
     with open(f_dir, 'r') as f:
@@ -191,7 +198,30 @@ def extract_design_info(design_dir, synth=0):
             design_info['modules'][module_name]['module_cnt'] = module_cnt
             if module_cnt == 0 and module_name in design_info['modules']:
                 design_info['modules'].pop(module_name)
-    if synth:
+    module_synth_path = f'{design_dir}/resource_est/module_synth.json'
+    if synth and os.path.exists(module_synth_path):
+        # The modules are synthesized one by one with the synthesis cache.
+        # The resource usage of the whole design is not available.
+        with open(module_synth_path, 'r') as f:
+            module_res = json.load(f)
+        for module in design_info['modules']:
+            res = module_res.get(module, None)
+            if res:
+                design_info['modules'][module]['FF'] = res['FF']
+                if "local_buffers" in design_info['modules'][module]:
+                    local_buffers = design_info['modules'][module]['local_buffers']
+                    for local_buffer in local_buffers:
+                        if local_buffer['mem_type'] == 'FF':
+                            design_info['modules'][module]['FF'] -= \
+                                FF_array_predict_HLS(local_buffer['port_width'], \
+                                                     local_buffer['buffer_depth'])
+            for r in ['LUT', 'BRAM18K', 'URAM', 'DSP']:
+                design_info['modules'][module][r] = res[r] if res else None
+            if not res:
+                design_info['modules'][module]['FF'] = None
+        for r in ['FF', 'LUT', 'BRAM18K', 'URAM', 'DSP']:
+            design_info[r] = None
+    elif synth:
         # Load the HLS project              
         hls_rpts = {}
         hls_prj_dir = f'{design_dir}/hls_prj'
@@ -432,22 +462,182 @@ def df_feature_extract(df, module):
 
     return df
 
-def get_feature_set(module):
+def get_feature_set(module, transferable=0):
     """ Exatract the feature set for the resource models.
 
     Parameters
     ----------
     module: str
-        Module name.
+        Module name, or module type for the models shared across kernels.
+    transferable: int
+        If set to 1, add the features describing the module type, i.e., the
+        data width and the buffer depth of the I/O modules.
     """
     feature_set = []
     if 'IO' in module:
         feature_set.append(f'{module}_data_pack_inter')
         feature_set.append(f'{module}_data_pack_inter/{module}_data_pack_intra')
+        if transferable:
+            feature_set.append(f'{module}_data_width')
+            feature_set.append(f'{module}_buffer_depth')
     else:
         feature_set.append(f'{module}_unroll')
     return feature_set
 
+def get_module_type(module, module_info):
+    """ Return the type of the module, which is shared across kernels.
+
+    I/O modules are typed by the I/O level, the direction and the sub-module
+    kind, e.g., "A_IO_L2_in_inter_trans" is typed as "IO_L2_in_inter_trans".
+    PE modules are typed by the data types.
+
+    Parameters
+    ----------
+    module: str
+        Module name.
+    module_info: dict
+        Module information.
+    """
+    if 'IO' in module:
+        # Strip the array name
+        return module[module.find('IO_L'):]
+    if 'dummy' in module:
+        return 'PE_dummy'
+    module_type = 'PE'
+    for ele_type in sorted(set(module_info.get('ele_types', []))):
+        module_type += '_' + ele_type.replace(' ', '_')
+    if 'boundary' in module:
+        module_type += '_boundary'
+    return module_type
+
+def extract_module_type_features(module_info, module_type):
+    """ Extract the features of the module for the module type models.
+
+    Parameters
+    ----------
+    module_info: dict
+        Module information.
+    module_type: str
+        Module type.
+    """
+    features = {}
+    if 'IO' in module_type:
+        features[f'{module_type}_data_pack_inter'] = module_info['data_pack_inter']
+        features[f'{module_type}_data_pack_intra'] = module_info['data_pack_intra']
+        features[f'{module_type}_data_width'] = \
+            module_info['data_pack_inter'] * module_info['ele_size'] * 8
+        buffer_depth = 0
+        if 'local_buffers' in module_info:
+            for local_buffer in module_info['local_buffers']:
+                buffer_depth += local_buffer['buffer_depth']
+        features[f'{module_type}_buffer_depth'] = buffer_depth
+    else:
+        features[f'{module_type}_unroll'] = module_info['unroll']
+    return features
+
+def convert_design_infos_to_module_type_dfs(design_infos):
+    """ Convert the design infos into a dataframe for each module type.
+
+    Each row of the dataframe is a module of a design.
+
+    Parameters
+    ----------
+    design_infos: list
+        A list containing all design informations.
+    """
+    samples = {}
+    for design_info in design_infos:
+        for module, module_info in design_info['modules'].items():
+            if module.find('wrapper') != -1:
+                continue
+            module_type = get_module_type(module, module_info)
+            sample = extract_module_type_features(module_info, module_type)
+            for r in ['FF', 'LUT', 'DSP']:
+                sample[f'{module_type}_{r}'] = module_info.get(r, None)
+            if module_type not in samples:
+                samples[module_type] = []
+            samples[module_type].append(sample)
+
+    return {module_type: pd.DataFrame(samples[module_type]) for module_type in samples}
+
+def train_module_type_models(design_infos, lib_dir, logger):
+    """ Train the resource models for each module type.
+
+    The samples are merged with the samples from other kernels kept in the
+    library, so that the models generalize across kernels.
+    BRAM18K and URAM are predicted analytically and are not trained.
+
+    Parameters
+    ----------
+    design_infos: list
+        A list containing all design informations.
+    lib_dir: str
+        Directory of the resource library.
+    logger:
+        Logger.
+    """
+    dfs = convert_design_infos_to_module_type_dfs(design_infos)
+    for module_type in dfs:
+        df = dfs[module_type]
+        sample_file = f'{lib_dir}/{module_type}_samples.csv'
+        if os.path.isfile(sample_file):
+            df = pd.concat([pd.read_csv(sample_file), df], ignore_index=True)
+        df = df.drop_duplicates().reset_index(drop=True)
+        df.to_csv(sample_file, index=False)
+
+        logger.info(f'Training resource model for module type: {module_type} ({df.shape[0]} samples)')
+        df = df_feature_extract(df, module_type)
+        feature_set = get_feature_set(module_type, 1)
+        for r in ['FF', 'LUT', 'DSP']:
+            pred_set = [f'{module_type}_{r}']
+            df_r = df.loc[:, feature_set + pred_set].dropna()
+            if df_r.shape[0] == 0:
+                continue
+            model = LinearRegression()
+            model.fit(df_r.loc[:, feature_set].to_numpy(), df_r.loc[:, pred_set].to_numpy())
+            joblib.dump(model, f'{lib_dir}/{module_type}_{r}_model.pkl')
+            y_pred = model.predict(df_r.loc[:, feature_set].to_numpy())
+            logger.info(f'{r} Mean Absolute Percentage Error: '
+                        f'{mean_absolute_percentage_error(df_r.loc[:, pred_set].to_numpy(), y_pred)}')
+
+def predict_module_resource_usage(df, module, module_info, r, prj_dir, lib_dir=None):
+    """ Predict the usage of the resource type "r" for a single module.
+
+    The model trained for the module of the kernel is used if available.
+    Otherwise, the model of the module type in the resource library is used.
+    Returns None if neither model exists.
+
+    Parameters
+    ----------
+    df: dataframe
+        A dataframe storing the information for the current design.
+    module: str
+        Module name.
+    module_info: dict
+        Module information.
+    r: str
+        Resource type.
+    prj_dir: str
+        Directory to the resource models.
+    lib_dir: str
+        Directory to the resource library.
+    """
+    joblib_file = f'{prj_dir}/{module}_{r}_model.pkl'
+    if os.path.isfile(joblib_file):
+        model = joblib.load(joblib_file)
+        X = df.loc[:, get_feature_set(module)]
+        return np.asscalar(model.predict(X.to_numpy()))
+    if lib_dir:
+        module_type = get_module_type(module, module_info)
+        joblib_file = f'{lib_dir}/{module_type}_{r}_model.pkl'
+        if os.path.isfile(joblib_file):
+            model = joblib.load(joblib_file)
+            df_type = pd.DataFrame([extract_module_type_features(module_info, module_type)])
+            df_type = df_feature_extract(df_type, module_type)
+            X = df_type.loc[:, get_feature_set(module_type, 1)]
+            return np.asscalar(model.predict(X.to_numpy()))
+    return None
+
 def train(df, modules, fifos, design_infos, work_dir, logger):
     """ Train the resource models for each module.
 
@@ -617,7 +807,7 @@ def train(df, modules, fifos, design_infos, work_dir, logger):
                     local_buffers = design_info['modules'][module]['local_buffers']
                     for local_buffer in local_buffers:
                         if local_buffer['mem_type'] == 'URAM':
-                            BRAM_usage += URAM_array_predict_HLS(local_buffer['port_width'], \
+                            URAM_usage += URAM_array_predict_HLS(local_buffer['port_width'], \
                                 local_buffer['buffer_depth'], local_buffer['partition_number'])
                 y_pred_module[cnt] = URAM_usage
                 cnt += 1
@@ -647,6 +837,10 @@ def train(df, modules, fifos, design_infos, work_dir, logger):
     for index, row in df_test.iterrows():
         #print(index)
         design_info = design_infos[index]
+        if design_info['FF'] is None:
+            # The modules are synthesized one by one with the synthesis cache,
+            # and the resource usage of the whole design is not available.
+            continue
         df_design = df_test.loc[[index], :]
         res = predict_design_resource_usage(df_design, modules, fifos, design_info, work_dir)                 
 
@@ -666,6 +860,9 @@ def train(df, modules, fifos, design_infos, work_dir, logger):
         BRAM18K_design_mape.append(BRAM18K_mape)
         URAM_design_mape.append(URAM_mape)
 
+    if not FF_design_mape:
+        logger.info('Design-level resource usage is not available, skip the design-level validation.')
+        return
     logger.info('======== Design-Level Resource Model Validation Results ========')
     logger.info('FF Mean Absoulate Percentage Error (Arith. Mean): %.2f%%' %(mean(FF_design_mape)))
     logger.info('LUT Mean Absoulate Percentage Error (Arith. Mean): %.2f%%' %(mean(LUT_design_mape)))
@@ -674,7 +871,7 @@ def train(df, modules, fifos, design_infos, work_dir, logger):
     logger.info('URAM Mean Absoulate Percentage Error (Arith. Mean): %.2f%%' %(mean(URAM_design_mape)))    
 
 def predict_design_resource_usage(df, modules, fifos, design_info, prj_dir, \
-    target=['FF', 'LUT', 'DSP', 'BRAM18K', 'URAM']):
+    target=['FF', 'LUT', 'DSP', 'BRAM18K', 'URAM'], lib_dir=None):
     """ Predict the resource usage for a single design on Xilinx platforms
 
     Parameters
@@ -691,6 +888,9 @@ def predict_design_resource_usage(df, modules, fifos, design_info, prj_dir, \
         Directory to the resource models.    
     target: list
         Resource types to predict.
+    lib_dir: str
+        Directory to the resource library. The module type models in the
+        library are used for the modules without models of the kernel.
     """
     resource = {'FF': 0, 'LUT': 0, 'DSP': 0, 'BRAM18K': 0, 'URAM': 0}    
     resource_all = {}
@@ -715,17 +915,15 @@ def predict_design_resource_usage(df, modules, fifos, design_info, prj_dir, \
     for module in modules:
         if module in design_info['modules']:
             df = df_feature_extract(df, module)
-            module_feature_set = get_feature_set(module)
+            module_info = design_info['modules'][module]
 
             FF = 0
             if 'FF' in target:
                 # FF
-                X = df.loc[:, module_feature_set]
-                model_name = module + '_FF_model'
-                joblib_file = prj_dir + '/' + model_name + '.pkl'
-                if os.path.isfile(joblib_file):
-                    model = joblib.load(joblib_file)
-                    FF = np.asscalar(model.predict(X.to_numpy()))
+                FF = predict_module_resource_usage(df, module, module_info, 'FF', prj_dir, lib_dir)
+                if FF is None:
+                    FF = 0
+                else:
                     # Add back the FF arrays if existing
                     if "local_buffers" in design_info['modules'][module]:
                         local_buffers = design_info['modules'][module]['local_buffers']
@@ -736,22 +934,16 @@ def predict_design_resource_usage(df, modules, fifos, design_info, prj_dir, \
             LUT = 0
             if 'LUT' in target:
                 # LUT
-                X = df.loc[:, module_feature_set]
-                model_name = module + '_LUT_model'
-                joblib_file = prj_dir + '/' + model_name + '.pkl'
-                if os.path.isfile(joblib_file):
-                    model = joblib.load(joblib_file)
-                    LUT = np.asscalar(model.predict(X.to_numpy()))
+                LUT = predict_module_resource_usage(df, module, module_info, 'LUT', prj_dir, lib_dir)
+                if LUT is None:
+                    LUT = 0
 
             DSP = 0
             if 'DSP' in target:
                 # DSP
-                X = df.loc[:, module_feature_set]
-                model_name = module + '_DSP_model'
-                joblib_file = prj_dir + '/' + model_name + '.pkl'
-                if os.path.isfile(joblib_file):
-                    model = joblib.load(joblib_file)
-                    DSP = np.asscalar(model.predict(X.to_numpy()))
+                DSP = predict_module_resource_usage(df, module, module_info, 'DSP', prj_dir, lib_dir)
+                if DSP is None:
+                    DSP = 0
 
             BRAM = 0
             if 'BRAM18K' in target:
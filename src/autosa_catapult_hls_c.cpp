@@ -1355,11 +1355,19 @@ static __isl_give isl_printer *print_module_core_header_catapult(
   int inter, int boundary, int serialize, int types)
 {
   int n = isl_id_list_n_id(module->inst_ids);
+  int use_template = prog->scop->options->autosa->use_cplusplus_template;
 
+  /* With C++ templates, the module identifiers are the template 
+   * arguments of the run function, i.e., inst.run<...>(...).
+   */
+  if (types && use_template)
+    p = print_module_template_params(p, n);
   p = isl_printer_start_line(p);  
   if (types)
     p = isl_printer_print_str(p, "void ");
   p = isl_printer_print_str(p, "CCS_BLOCK(run)");
+  if (!types && use_template)
+    p = print_module_template_args(p, n);
   p = isl_printer_print_str(p, "(");
   if (!types) {
     p = isl_printer_end_line(p);
@@ -1376,18 +1384,17 @@ static __isl_give isl_printer *print_module_core_header_catapult(
   return p;
 }
 
-/* Print out variable declarations on Xilinx platforms.
- * The local variable can be mapped to different memory resources:
- * FF, LUTRAM, BRAM, URAM.
+/* Print out variable declarations on Catapult HLS.
+ * Double buffers are not declared as ping/pong variables. Catapult builds
+ * them from the stage replication of the channels between the inter_trans
+ * and intra_trans blocks, which is set in the TCL file.
  */
 static __isl_give isl_printer *print_module_var_catapult(
     __isl_take isl_printer *p,
-    struct autosa_kernel_var *var, int double_buffer,
+    struct autosa_kernel_var *var,
     struct autosa_hw_module *module)
 {
   int j;
-  int use_memory = 0; // 0: FF 1: LUTRAM 2: BRAM 3: URAM
-  use_memory = extract_memory_type(module, var, module->options->autosa->uram);
 
   p = isl_printer_start_line(p);
   if (var->array->local_array->is_sparse && module->type != PE_MODULE) {
@@ -1405,8 +1412,6 @@ static __isl_give isl_printer *print_module_var_catapult(
   }
   p = isl_printer_print_str(p, " ");
   p = isl_printer_print_str(p, var->name);
-  if (double_buffer)
-    p = isl_printer_print_str(p, "_ping");
   for (j = 0; j < isl_vec_size(var->size); ++j)
   {
     isl_val *v;
@@ -1420,41 +1425,6 @@ static __isl_give isl_printer *print_module_var_catapult(
   p = isl_printer_print_str(p, ";");
   p = isl_printer_end_line(p);
 
-  /* Print pong buffer */
-  if (double_buffer)
-  {
-    p = isl_printer_start_line(p);
-    if (var->array->local_array->is_sparse) {
-      p = isl_printer_print_str(p, var->array->name);
-      p = isl_printer_print_str(p, "_s_t");      
-      p = isl_printer_print_int(p, var->n_lane);      
-    } else {
-      if (var->n_lane == 1)
-        p = isl_printer_print_str(p, var->array->type);
-      else {
-        p = isl_printer_print_str(p, var->array->name);        
-        p = isl_printer_print_str(p, "_t");
-        p = isl_printer_print_int(p, var->n_lane);
-      }
-    }
-    p = isl_printer_print_str(p, " ");
-    p = isl_printer_print_str(p, var->name);
-    if (double_buffer)
-      p = isl_printer_print_str(p, "_pong");
-    for (j = 0; j < isl_vec_size(var->size); ++j)
-    {
-      isl_val *v;
-
-      p = isl_printer_print_str(p, "[");
-      v = isl_vec_get_element_val(var->size, j);
-      p = isl_printer_print_val(p, v);
-      isl_val_free(v);
-      p = isl_printer_print_str(p, "]");
-    }
-    p = isl_printer_print_str(p, ";");
-    p = isl_printer_end_line(p);
-  }
-
   return p;
 }
 
@@ -1468,7 +1438,7 @@ static __isl_give isl_printer *print_module_vars_catapult(
   if (inter == -1)
   {
     for (i = 0; i < module->n_var; ++i)
-      p = print_module_var_catapult(p, &module->var[i], module->double_buffer, module);
+      p = print_module_var_catapult(p, &module->var[i], module);
   }  
 
   return p;
@@ -3056,6 +3026,13 @@ int generate_autosa_catapult_hls_c(isl_ctx *ctx, struct ppcg_options *options,
   hls.ctx = ctx;
   hls.output_dir = options->autosa->output_dir;
   hls.hcl = options->autosa->hcl;
+  if (options->autosa->double_buffer_style == 0) {
+    /* Double buffers are built from ping-pong channels between the 
+     * inter_trans and intra_trans blocks, which follows the for-loop style.
+     */
+    printf("[AutoSA] Warning: Double buffer style 0 is not supported by Catapult HLS. Style 1 is used instead.\n");
+    options->autosa->double_buffer_style = 1;
+  }
   hls_open_files(&hls, input);
 
   r = generate_sa(ctx, input, hls.host_c, options, &print_hw, &hls);
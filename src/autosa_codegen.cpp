@@ -3751,6 +3751,15 @@ static __isl_give struct autosa_hw_module **sa_io_module_gen(
         if (i == outermost)
           is_buffer = 1;
       }
+      if (gen->options->autosa->three_level_buffer)
+      {
+        /* When three-level buffering is enabled, the second-level buffer is
+         * moved one level down and the outermost I/O module holds the 
+         * third-level buffer.
+         */
+        if (i == outermost - 1 && group->io_buffers[i - 1]->tile)
+          is_buffer = 1;
+      }
       if (gen->options->autosa->lower_int_io_L1_buffer)
       {
         if (i == outermost) 
@@ -3859,6 +3868,15 @@ static __isl_give struct autosa_hw_module **sa_io_module_gen(
         if (i == outermost)
           is_buffer = 1;
       }
+      if (gen->options->autosa->three_level_buffer)
+      {
+        /* When three-level buffering is enabled, the second-level buffer is
+         * moved one level down and the outermost I/O module holds the 
+         * third-level buffer.
+         */
+        if (i == outermost - 1 && group->io_buffers[i - 1]->tile)
+          is_buffer = 1;
+      }
 
       /* Generate the I/O module. */
       if (i >= innermost && i <= outermost)
@@ -4603,6 +4621,8 @@ static __isl_give isl_schedule_node *tile_simd_sparse(
 /* Insert a "hls_unroll" mark after the "simd" mark.
  * The loop will be eventually unrolled.
  * The "hls_unroll" mark is placed under the band node.
+ * If the SIMD lanes are to be combined by a reduction tree, the mark 
+ * carries the kernel, which is used when printing the loop.
  */
 static __isl_give isl_schedule_node *insert_unroll_mark(
   __isl_take isl_schedule_node *node, void *user)
@@ -4618,7 +4638,8 @@ static __isl_give isl_schedule_node *insert_unroll_mark(
     if (!strcmp(isl_id_get_name(id), "simd"))
     {
       isl_id *hls_id;
-      hls_id = isl_id_alloc(ctx, "hls_unroll", NULL);
+      hls_id = isl_id_alloc(ctx, "hls_unroll",
+                  autosa_kernel_simd_reduce_tree_depth(kernel) > 0 ? kernel : NULL);
       
       if (kernel->options->target == AUTOSA_TARGET_CATAPULT_HLS_C) {
         /* The hls_unroll will be inserted above the loop. */
@@ -4641,6 +4662,9 @@ static __isl_give isl_schedule_node *insert_unroll_mark(
 
 /* Insert a context node at "node" introducing the PE identifiers 
  * along with their bounds, which are stored in kernel->sa_grid_size.
+ * If only part of the PE grid is active, e.g., for triangular iteration 
+ * domains, and --prune-idle-pe is set, the context is further restricted 
+ * to the active PEs so that the code of the idle PEs is pruned.
  */
 static __isl_give isl_schedule_node *insert_context(struct autosa_kernel *kernel,
                                                     __isl_take isl_schedule_node *node)
@@ -4650,11 +4674,84 @@ static __isl_give isl_schedule_node *insert_context(struct autosa_kernel *kernel
   context = isl_set_universe(isl_set_get_space(kernel->context));
   context = add_bounded_parameters_dynamic(context,
                                            kernel->sa_grid_size, kernel->pe_ids);
+  if (kernel->options->autosa->prune_idle_pe &&
+      kernel->pe_active && kernel->pe_util >= 0 && kernel->pe_util < 1)
+  {
+    context = isl_set_intersect(context, isl_set_copy(kernel->pe_active));
+    context = isl_set_coalesce(context);
+  }
   node = isl_schedule_node_insert_context(node, context);
 
   return node;
 }
 
+/* Compute the set of active PEs, i.e., the values of the PE identifiers 
+ * (represented as parameters) of the PEs that execute at least one 
+ * domain element in "domain". Store the result in kernel->pe_active 
+ * and the ratio between the number of active PEs and the size of the 
+ * PE grid in kernel->pe_util.
+ * The ratio is only computed if the PE grid is of fixed size.
+ */
+static void extract_sa_active_pes(struct autosa_kernel *kernel,
+                                  __isl_take isl_union_set *domain)
+{
+  isl_set *active;
+  isl_set *grid;
+  isl_pw_qpolynomial *card;
+  isl_val *n_active;
+  double n_grid = 1;
+
+  domain = isl_union_set_intersect(domain,
+                                   isl_union_set_copy(kernel->pe_filter));
+  active = isl_union_set_params(domain);
+  active = isl_set_coalesce(active);
+  kernel->pe_active = isl_set_copy(active);
+  kernel->pe_util = -1;
+
+  for (int i = 0; i < kernel->n_sa_dim; i++)
+  {
+    isl_pw_aff *size = isl_multi_pw_aff_get_pw_aff(kernel->sa_grid_size, i);
+    if (!isl_pw_aff_is_cst(size) || isl_pw_aff_n_piece(size) != 1)
+    {
+      isl_pw_aff_free(size);
+      isl_set_free(active);
+      return;
+    }
+    isl_val *val = isl_pw_aff_max_val(size);
+    n_grid *= isl_val_get_d(val);
+    isl_val_free(val);
+  }
+
+  /* Convert the PE identifiers to set dimensions. */
+  grid = isl_set_from_params(active);
+  grid = isl_set_add_dims(grid, isl_dim_set, kernel->n_sa_dim);
+  for (int i = 0; i < kernel->n_sa_dim; i++)
+  {
+    isl_id *id = isl_id_list_get_id(kernel->pe_ids, i);
+    int pos = isl_set_find_dim_by_id(grid, isl_dim_param, id);
+    isl_id_free(id);
+    if (pos < 0)
+    {
+      isl_set_free(grid);
+      return;
+    }
+    grid = isl_set_equate(grid, isl_dim_param, pos, isl_dim_set, i);
+    grid = isl_set_project_out(grid, isl_dim_param, pos, 1);
+  }
+  if (isl_set_dim(grid, isl_dim_param) > 0)
+  {
+    isl_set_free(grid);
+    return;
+  }
+
+  card = isl_set_card(grid);
+  n_active = isl_pw_qpolynomial_eval(card,
+                                     isl_point_zero(isl_space_params_alloc(kernel->ctx, 0)));
+  if (isl_val_is_rat(n_active) && n_grid > 0)
+    kernel->pe_util = isl_val_get_d(n_active) / n_grid;
+  isl_val_free(n_active);
+}
+
 /* Create the local buffer variables inside the PE.
  * Specifically, we will also scan through all IO groups for the array,
  * find the lcm of all the data packing factors to set as the array partitioning
@@ -4925,7 +5022,10 @@ static __isl_give struct autosa_hw_module *sa_pe_module_gen(struct autosa_gen *g
                                             kernel->n_sa_dim, "p");
   kernel->pe_filter = set_schedule_modulo(node, kernel->pe_ids,
                                           kernel->sa_dim);
-  kernel->sa_grid_size = extract_sa_grid_size(kernel, domain);
+  kernel->sa_grid_size = extract_sa_grid_size(kernel, isl_union_set_copy(domain));
+  extract_sa_active_pes(kernel, domain);
+  if (gen->options->autosa->verbose && kernel->pe_util >= 0)
+    printf("[AutoSA] PE utilization: %.2f\n", kernel->pe_util);
 
   /* Add the statements for I/O groups with exterior I/O at the user 
    * statement level. 
@@ -9074,6 +9174,33 @@ static __isl_give isl_ast_node *create_io_leaf(struct autosa_kernel *kernel,
   return isl_ast_node_set_annotation(node, id);
 }
 
+/* Does the innermost input dimension of "pma" only affect the last 
+ * output dimension, with a unit coefficient?
+ * That is, do consecutive values of the innermost input dimension
+ * map to consecutive array elements in the row-major layout?
+ */
+static int is_contiguous_access(__isl_keep isl_pw_multi_aff *pma)
+{
+  int n_in = isl_pw_multi_aff_dim(pma, isl_dim_in);
+  int n_out = isl_pw_multi_aff_dim(pma, isl_dim_out);
+  int contiguous = n_in > 0 && n_out > 0;
+
+  for (int i = 0; contiguous && i < n_out; i++)
+  {
+    isl_pw_aff *pa = isl_pw_multi_aff_get_pw_aff(pma, i);
+    if (i == n_out - 1)
+    {
+      isl_local_space *ls;
+      ls = isl_local_space_from_space(isl_pw_aff_get_domain_space(pa));
+      pa = isl_pw_aff_sub(pa, isl_pw_aff_var_on_domain(ls, isl_dim_set, n_in - 1));
+    }
+    contiguous = isl_pw_aff_involves_dims(pa, isl_dim_in, n_in - 1, 1) == isl_bool_false;
+    isl_pw_aff_free(pa);
+  }
+
+  return contiguous;
+}
+
 static __isl_give isl_ast_node *create_drain_merge_leaf(struct autosa_kernel *kernel,
                                                         struct autosa_drain_merge_func *func, __isl_take isl_ast_node *node,
                                                         __isl_keep isl_ast_build *build)
@@ -9108,6 +9235,18 @@ static __isl_give isl_ast_node *create_drain_merge_leaf(struct autosa_kernel *ke
   /* L -> A */
   pma2 = isl_pw_multi_aff_pullback_pw_multi_aff(pma2,
                                                 isl_pw_multi_aff_copy(pma));
+  /* If the innermost loop walks through consecutive elements, 
+   * the loop can be printed as a block copy. 
+   */
+  stmt->u.dm.contiguous_iter = NULL;
+  if (is_contiguous_access(pma2))
+  {
+    isl_space *sched_space = isl_ast_build_get_schedule_space(build);
+    int n = isl_space_dim(sched_space, isl_dim_set);
+    stmt->u.dm.contiguous_iter = strdup(
+        isl_space_get_dim_name(sched_space, isl_dim_set, n - 1));
+    isl_space_free(sched_space);
+  }
   expr = isl_ast_build_access_from_pw_multi_aff(build, pma2);
   isl_pw_multi_aff_free(pma);
 
@@ -10461,6 +10600,114 @@ static void loop_coalesce_optimize(struct autosa_hw_module *module)
   }
 }
 
+/* Return the number of loops in the perfect loop nest rooted at the for node 
+ * "node" that ends at a pipelined loop, i.e., a loop followed by an 
+ * "hls_pipeline" mark without any other "hls_pipeline" mark further inside.
+ * All the loops in the nest should have constant bounds and only marks 
+ * may appear between the loops, so that the nest can be printed as 
+ * a single pipelined loop.
+ * Return 0 if "node" is not the root of such a nest with at least two loops.
+ */
+static int extract_flatten_nest_depth(__isl_keep isl_ast_node *node)
+{
+  int depth = 0;
+
+  node = isl_ast_node_copy(node);
+  while (isl_ast_node_get_type(node) == isl_ast_node_for)
+  {
+    long first, last, stride;
+    int pipeline = 0, unroll = 0;
+    isl_ast_node *body;
+
+    if (isl_ast_node_for_is_degenerate(node) ||
+        isl_ast_node_for_get_const_range(node, &first, &last, &stride) != 
+          isl_bool_true)
+      break;
+    depth++;
+    body = isl_ast_node_for_get_body(node);
+    isl_ast_node_free(node);
+    while (isl_ast_node_get_type(body) == isl_ast_node_mark)
+    {
+      isl_id *id = isl_ast_node_mark_get_id(body);
+      isl_ast_node *child = isl_ast_node_mark_get_node(body);
+      if (!strcmp(isl_id_get_name(id), "hls_pipeline"))
+      {
+        pipeline = isl_ast_node_has_mark(child, "hls_pipeline") == 
+                   isl_bool_false;
+      }
+      else if (!strcmp(isl_id_get_name(id), "hls_unroll"))
+      {
+        unroll = 1;
+      }
+      isl_id_free(id);
+      isl_ast_node_free(body);
+      body = child;
+    }
+    node = body;
+    if (pipeline)
+    {
+      isl_ast_node_free(node);
+      return depth > 1 ? depth : 0;
+    }
+    if (unroll)
+      break;
+  }
+  isl_ast_node_free(node);
+
+  return 0;
+}
+
+/* If the for node "node" is the root of a perfect loop nest that can be 
+ * flattened, record the number of loops in the nest in the node annotation.
+ * The loops inside the nest are printed as part of the flattened loop 
+ * and are not visited.
+ */
+static isl_bool loop_flatten_update(__isl_keep isl_ast_node *node, void *user)
+{
+  struct autosa_ast_node_userinfo *info;
+  isl_id *id;
+  int n;
+
+  if (isl_ast_node_get_type(node) != isl_ast_node_for)
+    return isl_bool_true;
+
+  n = extract_flatten_nest_depth(node);
+  if (n == 0)
+    return isl_bool_true;
+
+  id = isl_ast_node_get_annotation(node);
+  if (!id)
+    return isl_bool_true;
+  info = (struct autosa_ast_node_userinfo *)isl_id_get_user(id);
+  isl_id_free(id);
+  if (!info)
+    return isl_bool_true;
+  info->n_flatten_loop = n;
+
+  return isl_bool_false;
+}
+
+/* This function will mark the perfect loop nests with constant bounds 
+ * around the pipelined loops to be printed as single pipelined loops 
+ * later in the generated HLS C code.
+ * Each flattened nest pays the pipeline fill and flush only once, instead 
+ * of once per entry of the innermost loop.
+ * We will examine all the AST trees to be printed for this module.
+ */
+static void loop_flatten_optimize(struct autosa_hw_module *module)
+{
+  isl_ast_node *trees[] = {module->device_tree, module->inter_tree,
+                           module->intra_tree, module->boundary_outer_tree,
+                           module->boundary_inter_tree, module->boundary_tree};
+
+  for (int i = 0; i < 6; i++)
+  {
+    if (trees[i])
+      isl_ast_node_foreach_descendant_top_down(trees[i], 
+          &loop_flatten_update, NULL);
+  }
+}
+
 struct loop_guards_update_data {
   /* Indicates if we are checking the outermost loop bands. */
   isl_bool outer_for;
@@ -10855,6 +11102,12 @@ isl_stat sa_filter_buffer_io_module_generate_code(struct autosa_gen *gen,
   {
     loop_coalesce_optimize(module);
   }
+  /* Perform loop flattening optimization. */
+  if (gen->options->target == AUTOSA_TARGET_XILINX_HLS_C &&
+      gen->options->autosa->loop_flatten)
+  {
+    loop_flatten_optimize(module);
+  }
   if (gen->options->target == AUTOSA_TARGET_CATAPULT_HLS_C) 
   {    
     loop_guards_optimize(module);    
@@ -10947,6 +11200,12 @@ isl_stat sa_module_generate_code(struct autosa_gen *gen,
   {
     loop_coalesce_optimize(module);
   }
+  /* Perform loop flattening optimization. */
+  if (gen->options->target == AUTOSA_TARGET_XILINX_HLS_C &&
+      gen->options->autosa->loop_flatten)
+  {
+    loop_flatten_optimize(module);
+  }
   /* Mark the loop guards. */
   if (gen->options->target == AUTOSA_TARGET_CATAPULT_HLS_C) 
   {
@@ -1,6 +1,7 @@
 /* Define functions for communication management. */
 
 #include <isl/ilp.h>
+#include <unistd.h>
 
 #include "autosa_schedule_tree.h"
 #include "autosa_utils.h"
@@ -41,6 +42,8 @@ struct autosa_group_data
   isl_union_map *pe_sched;
   /* A union map representation of the entire kernel schedule. */
   isl_union_map *full_sched;
+  /* The I/O grouping cache entry of the current design. */
+  cJSON *group_cache;
 };
 
 /* Return the prefix schedule at "node" as a relation
@@ -480,6 +483,8 @@ isl_bool can_tile(__isl_keep isl_map *access,
 
 struct check_contraction_data {
   bool legal;
+  /* Are all the loops between the PE mark and the accesses parallel? */
+  bool parallel;
   struct autosa_array_ref_group *group;
   struct autosa_kernel *kernel;
   isl_union_map *prefix;
@@ -525,8 +530,10 @@ static isl_bool check_stmt_contain_acc(__isl_keep isl_set *set, void *user)
   return isl_bool_true;
 }
 
-/* Check if the pe_group is mapped to a single register.
- * Specifically, check for each array access in the current pe_group, 
+/* Compute the innermost common schedule position of all the array accesses
+ * in the current pe_group, below the PE mark. The prefix schedule at this 
+ * position is stored in data->prefix.
+ * In addition, check for each array access in the current pe_group, 
  * if all the loops above the array access and below the PE mark are
  * parallel loops.
  */
@@ -577,7 +584,7 @@ static __isl_give isl_schedule_node *check_contraction(
         int dim = isl_schedule_node_band_n_member(tmp_node);
         for (int i = 0; i < dim; i++) {
           if (!isl_schedule_node_band_member_get_coincident(tmp_node, i)) {
-            data->legal = false;
+            data->parallel = false;
             break;
           }
         }
@@ -648,10 +655,101 @@ static __isl_give isl_schedule_node *check_contraction(
   return node;
 }
 
+/* Return the prefix schedule "prefix" of dimension "depth" truncated to 
+ * its outer "n" dimensions.
+ */
+static __isl_give isl_union_pw_multi_aff *truncate_prefix_schedule(
+  __isl_keep isl_union_pw_multi_aff *prefix, int depth, int n)
+{
+  isl_multi_union_pw_aff *mupa;
+
+  mupa = isl_multi_union_pw_aff_from_union_pw_multi_aff(
+            isl_union_pw_multi_aff_copy(prefix));
+  mupa = isl_multi_union_pw_aff_drop_dims(mupa, isl_dim_set, n, depth - n);
+
+  return isl_union_pw_multi_aff_from_multi_union_pw_aff(mupa);
+}
+
+/* Return the relation between the statement instances in "access" that 
+ * access the same array element and share the same prefix schedule "prefix".
+ */
+static __isl_give isl_union_map *same_element_same_prefix(
+  __isl_keep isl_union_map *access, __isl_keep isl_union_map *prefix)
+{
+  isl_union_map *same_elem, *same_prefix;
+
+  same_elem = isl_union_map_apply_range(isl_union_map_copy(access),
+                isl_union_map_reverse(isl_union_map_copy(access)));
+  same_prefix = isl_union_map_apply_range(isl_union_map_copy(prefix),
+                  isl_union_map_reverse(isl_union_map_copy(prefix)));
+
+  return isl_union_map_intersect(same_elem, same_prefix);
+}
+
+/* Contract the local buffer of the pe_group using the live ranges of 
+ * the array elements.
+ * An array element is live from its first access to its last access inside 
+ * the PE. If all the live ranges are contained in a single iteration of 
+ * the outer "k" schedule dimensions, the local buffer only needs to hold 
+ * the footprint of one such iteration, i.e., it is reallocated at depth "k".
+ * We start from the innermost common position of all the accesses 
+ * (data->depth) and look for the deepest "k" below the PE mark 
+ * ("pe_depth") that satisfies the condition. 
+ * If found, data->prefix, data->prefix_upma, and data->depth are updated
+ * to the prefix schedule at depth "k".
+ *
+ * Two instances accessing the same element in the same PE iteration 
+ * (same prefix at "pe_depth") must share the same prefix at depth "k".
+ */
+static bool contract_by_live_range(__isl_keep isl_union_map *access,
+  __isl_keep isl_union_map *pe_sched, int pe_depth, 
+  struct check_contraction_data *data)
+{
+  isl_union_map *live;
+
+  live = same_element_same_prefix(access, pe_sched);
+  for (int k = data->depth; k > pe_depth; k--) {
+    isl_union_pw_multi_aff *prefix_upma;
+    isl_union_map *prefix, *same_prefix;
+    isl_bool is_subset;
+
+    prefix_upma = truncate_prefix_schedule(data->prefix_upma, data->depth, k);
+    prefix = isl_union_map_from_union_pw_multi_aff(
+                isl_union_pw_multi_aff_copy(prefix_upma));
+    same_prefix = same_element_same_prefix(access, prefix);
+    is_subset = isl_union_map_is_subset(live, same_prefix);
+    isl_union_map_free(same_prefix);
+    if (is_subset == isl_bool_true) {
+      isl_union_map_free(data->prefix);
+      isl_union_pw_multi_aff_free(data->prefix_upma);
+      data->prefix = prefix;
+      data->prefix_upma = prefix_upma;
+      data->depth = k;
+      isl_union_map_free(live);
+      return true;
+    }
+    isl_union_map_free(prefix);
+    isl_union_pw_multi_aff_free(prefix_upma);
+    if (is_subset < 0)
+      break;
+  }
+  isl_union_map_free(live);
+
+  return false;
+}
+
 /* Compute the tiling of the group at the PE level.
- * If array_contraction is enabled, check if all loops under the PE mark
- * and before the SIMD marks are parallel loops. 
- * If so, contract the local tile to a single register.
+ * If array_contraction is enabled, we try to shrink the local buffer.
+ * With local reduction, if all loops under the PE mark and before 
+ * the SIMD marks are parallel loops, the local tile is contracted to 
+ * a single register.
+ * Otherwise, we use the live ranges of the array elements to find the 
+ * deepest schedule position under the PE mark to allocate the buffer 
+ * (see contract_by_live_range). 
+ * Without local reduction, the values of arrays that are not local to the 
+ * scop might be live into or out of the PE (through the I/O and drain 
+ * modules at the PE level), therefore, only arrays local to the scop 
+ * are contracted.
  */
 static isl_stat compute_group_bounds_core_pe(struct autosa_kernel *kernel,
                                              struct autosa_array_ref_group *group, struct autosa_group_data *data)
@@ -687,20 +785,37 @@ static isl_stat compute_group_bounds_core_pe(struct autosa_kernel *kernel,
                                                  group->array->n_index);
 
     /* Check if array contraction is possible. */
-    if (kernel->options->autosa->local_reduce && kernel->options->autosa->array_contraction) {      
+    if (kernel->options->autosa->array_contraction &&
+        (kernel->options->autosa->local_reduce ||
+         (kernel->options->autosa->local_array_contraction && group->array->local))) {
+      int pe_depth;
+
       contract_data.group = group;
       contract_data.kernel = kernel;
       contract_data.legal = true;
+      contract_data.parallel = true;
       contract_data.prefix = NULL;
       contract_data.prefix_upma = NULL;
       contract_data.depth = -1;      
       node = isl_schedule_get_root(kernel->schedule);
       node = autosa_tree_move_down_to_pe(node, kernel->core);
+      pe_depth = isl_schedule_node_get_schedule_depth(node);
       //DBGSCHDNODE(stdout, node, isl_schedule_node_get_ctx(node));
       node = isl_schedule_node_map_descendant_bottom_up(node, &check_contraction, &contract_data);
       isl_schedule_node_free(node);      
       //std::cout << contract_data.legal << std::endl;
       //std::cout << contract_data.depth << std::endl;
+      if (!contract_data.prefix) {
+        contract_data.legal = false;
+      } else if (!(kernel->options->autosa->local_reduce && contract_data.parallel)) {
+        contract_data.legal = contract_by_live_range(access, data->pe_sched, 
+                                                     pe_depth, &contract_data);
+        if (!contract_data.legal)
+          isl_union_pw_multi_aff_free(contract_data.prefix_upma);
+      }
+      if (contract_data.legal && kernel->options->autosa->verbose)
+        printf("[AutoSA] Contract the local buffer of array %s at schedule depth %d.\n",
+               group->array->name, contract_data.depth);
     }
     
     if (contract_data.legal) {
@@ -1168,6 +1283,8 @@ static int share_io(struct autosa_array_ref_group *group1,
  * then merge the two groups into one.
  * TODO: If "compute_bounds" is set, then call compute_group_bounds
  * on the merged groups.
+ * If "merges" is not NULL, each merge is recorded as a pair [i, j] in it,
+ * which can be replayed by replay_group_io.
  *
  * Return the updated number of groups.
  * Return -1 on error.
@@ -1177,7 +1294,7 @@ static int group_io(struct autosa_kernel *kernel,
                     int (*share)(struct autosa_array_ref_group *group1,
                                  struct autosa_array_ref_group *group2),
                     int compute_bounds,
-                    struct autosa_group_data *data)
+                    struct autosa_group_data *data, cJSON *merges)
 {
   int i, j;
 
@@ -1188,6 +1305,12 @@ static int group_io(struct autosa_kernel *kernel,
       if (!share(groups[i], groups[j]))
         continue;
 
+      if (merges)
+      {
+        int merge[2] = {i, j};
+        cJSON_AddItemToArray(merges, cJSON_CreateIntArray(merge, 2));
+      }
+
       groups[i] = join_groups_and_free(groups[i], groups[j]);
       if (j != n - 1)
         groups[j] = groups[n - 1];
@@ -1212,9 +1335,51 @@ static int group_io(struct autosa_kernel *kernel,
  */
 static int group_share_io(struct autosa_kernel *kernel,
                           int n, struct autosa_array_ref_group **groups,
-                          struct autosa_group_data *data)
+                          struct autosa_group_data *data, cJSON *merges)
 {
-  return group_io(kernel, n, groups, &share_io, 0, data);
+  return group_io(kernel, n, groups, &share_io, 0, data, merges);
+}
+
+/* Replay the merges recorded by group_io in "merges" on "groups".
+ * Return the updated number of groups.
+ * Return -1 if the record doesn't match the groups, in which case 
+ * "groups" is left untouched.
+ */
+static int replay_group_io(int n, struct autosa_array_ref_group **groups,
+                           cJSON *merges)
+{
+  cJSON *merge;
+  int m = n;
+
+  if (!cJSON_IsArray(merges))
+    return -1;
+  cJSON_ArrayForEach(merge, merges)
+  {
+    if (cJSON_GetArraySize(merge) != 2)
+      return -1;
+    int i = cJSON_GetArrayItem(merge, 0)->valueint;
+    int j = cJSON_GetArrayItem(merge, 1)->valueint;
+    if (i < 0 || j <= i || j >= m)
+      return -1;
+    m--;
+  }
+
+  cJSON_ArrayForEach(merge, merges)
+  {
+    int i = cJSON_GetArrayItem(merge, 0)->valueint;
+    int j = cJSON_GetArrayItem(merge, 1)->valueint;
+
+    groups[i] = join_groups_and_free(groups[i], groups[j]);
+    if (j != n - 1)
+      groups[j] = groups[n - 1];
+    groups[n - 1] = NULL;
+    n--;
+
+    if (!groups[i])
+      return -1;
+  }
+
+  return n;
 }
 
 /* Perform interior I/O elimination.
@@ -1256,6 +1421,69 @@ static isl_stat autosa_interior_io_eliminate(
   return isl_stat_ok;
 }
 
+/* Convert the I/O transformation matrix "mat" to a JSON array of rows. */
+static cJSON *io_trans_mat_to_json(__isl_keep isl_mat *mat)
+{
+  cJSON *rows = cJSON_CreateArray();
+
+  for (int r = 0; r < isl_mat_rows(mat); r++)
+  {
+    cJSON *row = cJSON_CreateArray();
+    for (int c = 0; c < isl_mat_cols(mat); c++)
+    {
+      isl_val *val = isl_mat_get_element_val(mat, r, c);
+      cJSON_AddItemToArray(row, cJSON_CreateNumber(isl_val_get_num_si(val)));
+      isl_val_free(val);
+    }
+    cJSON_AddItemToArray(rows, row);
+  }
+
+  return rows;
+}
+
+/* Read back a "space_dim" x "space_dim" I/O transformation matrix 
+ * stored by io_trans_mat_to_json in "rows".
+ * Return NULL if "rows" is NULL, has a different shape, or if its 
+ * last row doesn't match the I/O direction "dir".
+ */
+static __isl_give isl_mat *io_trans_mat_from_json(isl_ctx *ctx, cJSON *rows,
+                                                  __isl_keep isl_vec *dir, int space_dim)
+{
+  isl_mat *mat;
+  int r = 0;
+  cJSON *row;
+
+  if (!cJSON_IsArray(rows) || cJSON_GetArraySize(rows) != space_dim)
+    return NULL;
+  mat = isl_mat_alloc(ctx, space_dim, space_dim);
+  cJSON_ArrayForEach(row, rows)
+  {
+    if (!cJSON_IsArray(row) || cJSON_GetArraySize(row) != space_dim)
+      return isl_mat_free(mat);
+    for (int c = 0; c < space_dim; c++)
+    {
+      cJSON *item = cJSON_GetArrayItem(row, c);
+      if (!cJSON_IsNumber(item))
+        return isl_mat_free(mat);
+      mat = isl_mat_set_element_si(mat, r, c, item->valueint);
+    }
+    r++;
+  }
+  for (int c = 0; c < space_dim; c++)
+  {
+    isl_val *val = c < isl_vec_size(dir) ? isl_vec_get_element_val(dir, c) : 
+                                           isl_val_zero(ctx);
+    isl_val *cached = isl_mat_get_element_val(mat, space_dim - 1, c);
+    isl_bool eq = isl_val_eq(val, cached);
+    isl_val_free(val);
+    isl_val_free(cached);
+    if (eq != isl_bool_true)
+      return isl_mat_free(mat);
+  }
+
+  return mat;
+}
+
 /* The "node" points to the current space band.
  * We will cluster it using the direction "dir".
  * Specifically, following the space-time transformation using projection and 
@@ -1269,11 +1497,15 @@ static isl_stat autosa_interior_io_eliminate(
  * where PdT = 0.
  * 
  * This new transformation matrix is applied to the space band.
+ * If "cached" is not NULL, it is the transformation matrix recorded for the 
+ * same band by a previous run (see autosa_io_clustering), which is used 
+ * directly if its shape matches the band and its last row equals "dir".
  * We will return the transformaton matrix in "io_trans_mat" and "io_trans_ma".
  */
 static __isl_give isl_schedule_node *io_cluster(
     __isl_take isl_schedule_node *node,
-    __isl_keep isl_vec *dir, isl_mat **io_trans_mat, isl_multi_aff **io_trans_ma)
+    __isl_keep isl_vec *dir, cJSON *cached,
+    isl_mat **io_trans_mat, isl_multi_aff **io_trans_ma)
 {
   isl_multi_union_pw_aff *mupa;
   isl_mat *trans_mat, *d_mat, *null_mat;
@@ -1287,6 +1519,9 @@ static __isl_give isl_schedule_node *io_cluster(
   ctx = isl_schedule_node_get_ctx(node);
 
   /* Build the transformation matrix. */
+  trans_mat = io_trans_mat_from_json(ctx, cached, dir, space_dim);
+  if (trans_mat)
+    goto apply;
   trans_mat = isl_mat_alloc(ctx, space_dim, space_dim);
   d_mat = isl_mat_alloc(ctx, 1, space_dim);
   for (int i = 0; i < isl_vec_size(dir); i++)
@@ -1312,6 +1547,9 @@ static __isl_give isl_schedule_node *io_cluster(
     trans_mat = isl_mat_set_element_val(trans_mat, isl_mat_cols(null_mat), i,
                                         isl_vec_get_element_val(dir, i));
   }
+  isl_mat_free(null_mat);
+
+apply:
   *io_trans_mat = trans_mat;
 
   /* Convert the transformation matrix to multi_aff. */
@@ -1343,8 +1581,6 @@ static __isl_give isl_schedule_node *io_cluster(
   /* Insert the new partial schedule. */
   node = isl_schedule_node_insert_partial_schedule(node, mupa);
 
-  isl_mat_free(null_mat);
-
   return node;
 }
 
@@ -2009,10 +2245,14 @@ isl_bool is_io_module_valid(
  * Y
  * |
  * "PE" mark
+ *
+ * If "cluster" is not NULL, it holds the transformation matrices of the 
+ * clustering levels, from the innermost to the outermost. The recorded 
+ * matrices are reused, and the missing ones are computed and appended.
  */
 static isl_stat compute_io_group_schedule(
     struct autosa_kernel *kernel, struct autosa_array_ref_group *group,
-    struct autosa_gen *gen)
+    struct autosa_gen *gen, cJSON *cluster)
 {
   isl_printer *p_str;
   char *io_str;
@@ -2079,7 +2319,11 @@ static isl_stat compute_io_group_schedule(
 //#ifdef _DEBUG
 //    DBGVEC(stdout, dir, isl_schedule_node_get_ctx(node));
 //#endif
-    node = io_cluster(node, dir, &io_trans_mat_i, &io_trans_ma_i);
+    cJSON *cached = cluster ? 
+        cJSON_GetArrayItem(cluster, space_dim - 1 - i) : NULL;
+    node = io_cluster(node, dir, cached, &io_trans_mat_i, &io_trans_ma_i);
+    if (cluster && !cached)
+      cJSON_AddItemToArray(cluster, io_trans_mat_to_json(io_trans_mat_i));
     isl_vec_free(dir);
 
     if (io_level == 1)
@@ -3433,7 +3677,7 @@ static __isl_give isl_schedule_node *update_int_io_L1_depth(__isl_take isl_sched
         struct autosa_io_info *io_info = ref->io_info[k];
         if (io_info->io_type == group->io_type && 
             !isl_vec_cmp(io_info->dir, group->dir)) {
-          if (is_dep_carried_by_node(io_info->dep->isl_dep, node_tmp)) {
+          if (is_dep_carried_by_node(io_info->dep->isl_dep, node_tmp, data->kernel->scop)) {
             ///* Insert the I/O buffer below the current node */
             //insert_node = isl_schedule_node_copy(node_tmp);
             //insert_node = isl_schedule_node_child(insert_node, 0);
@@ -3906,6 +4150,51 @@ static isl_stat hoist_L2_io_buffer(
   return isl_stat_ok;
 }
 
+/* This function is used when three-level buffering is enabled.
+ * The L2 I/O buffer computed at the outermost I/O module is moved to the
+ * I/O module one level below, and a new L3 buffer is allocated at the 
+ * outermost I/O module, underneath the "array_L3" mark. 
+ * The L3 buffer holds the data of one L3 tile and is reused by all the L2 
+ * tiles inside it. It is implemented with URAM.
+ *
+ * We need at least three I/O levels to place both buffers. Otherwise, or if
+ * the I/O module below already owns a buffer, the group keeps the two-level
+ * buffering.
+ */
+static isl_stat insert_L3_io_buffer(
+  struct autosa_kernel *kernel,
+  struct autosa_array_ref_group *group,
+  struct autosa_gen *gen)
+{
+  struct autosa_io_buffer *cur_buffer, *nxt_buffer;
+  int io_level = group->io_level;
+  isl_schedule_node *node;
+
+  if (io_level < 3)
+    return isl_stat_ok;
+  cur_buffer = group->io_buffers[io_level - 1];
+  nxt_buffer = group->io_buffers[io_level - 2];
+  if (!cur_buffer->tile || nxt_buffer->tile)
+    return isl_stat_ok;
+
+  /* Move the L2 buffer one level down. */
+  nxt_buffer->tile = cur_buffer->tile;
+  cur_buffer->tile = NULL;
+
+  /* Allocate the L3 buffer. */
+  node = isl_schedule_get_root(group->io_schedule);
+  node = autosa_tree_move_down_to_mark(node, kernel->core, "array_L3");
+  node = isl_schedule_node_child(node, 0);
+  if (group->group_type == AUTOSA_DRAIN_GROUP)
+    compute_group_bounds_drain_at_node(kernel, group, node, cur_buffer);
+  else if (group->group_type == AUTOSA_IO_GROUP)
+    compute_group_bounds_io_at_node(kernel, group, node, cur_buffer);
+  autosa_array_ref_group_compute_tiling(cur_buffer->tile, group);
+  isl_schedule_node_free(node);
+
+  return isl_stat_ok;
+}
+
 /* Return the prefix I/O schedule at io_level "level". */
 static __isl_give isl_union_map *get_io_schedule_at_level(
     __isl_keep isl_schedule *sched, int level)
@@ -4100,8 +4389,37 @@ static int group_array_references_io(struct autosa_kernel *kernel,
   /* Populate the groups. */
   n = populate_array_references_io(local, groups, data);
 
-  /* Group references that share the same I/O direction and I/O type. */
-  n = group_share_io(kernel, n, groups, data);
+  /* Group references that share the same I/O direction and I/O type. 
+   * If the grouping of the same design has been cached, replay it.
+   */
+  int n_group = -1;
+  cJSON *entry = NULL;
+  if (data->group_cache)
+  {
+    entry = cJSON_GetObjectItemCaseSensitive(data->group_cache, local->array->name);
+    cJSON *n_json = cJSON_GetObjectItemCaseSensitive(entry, "n");
+    if (cJSON_IsNumber(n_json) && n_json->valueint == n)
+      n_group = replay_group_io(n, groups,
+                                cJSON_GetObjectItemCaseSensitive(entry, "merges"));
+  }
+  if (n_group >= 0)
+  {
+    n = n_group;
+  }
+  else
+  {
+    cJSON *merges = data->group_cache ? cJSON_CreateArray() : NULL;
+    int n_ref_group = n;
+    n = group_share_io(kernel, n, groups, data, merges);
+    if (data->group_cache)
+    {
+      entry = cJSON_CreateObject();
+      cJSON_AddNumberToObject(entry, "n", n_ref_group);
+      cJSON_AddItemToObject(entry, "merges", merges);
+      cJSON_DeleteItemFromObjectCaseSensitive(data->group_cache, local->array->name);
+      cJSON_AddItemToObject(data->group_cache, local->array->name, entry);
+    }
+  }
 
   /* Perform interior I/O elimination. */
   for (i = 0; i < n; ++i)
@@ -4412,20 +4730,74 @@ static void compute_group_tilings_drain(struct autosa_kernel *kernel)
   }
 }
 
-/* Update the I/O schedules by I/O module clustering. */
+/* Return the JSON array named "name" in the I/O grouping cache entry 
+ * "entry", creating it if it doesn't exist yet.
+ * Return NULL if "entry" is NULL.
+ */
+static cJSON *io_group_cache_get_array(cJSON *entry, const char *name)
+{
+  cJSON *item;
+
+  if (!entry)
+    return NULL;
+  item = cJSON_GetObjectItemCaseSensitive(entry, name);
+  if (!cJSON_IsArray(item))
+  {
+    cJSON_DeleteItemFromObjectCaseSensitive(entry, name);
+    item = cJSON_CreateArray();
+    cJSON_AddItemToObject(entry, name, item);
+  }
+
+  return item;
+}
+
+/* Update the I/O schedules by I/O module clustering.
+ * If the I/O grouping cache is enabled, the clustering transformations of 
+ * each group are recorded under "io_clusters" (one array per I/O group) and 
+ * "drain_cluster" in the cache entry of the array, and are replayed when 
+ * they are found.
+ */
 static isl_stat autosa_io_clustering(struct autosa_kernel *kernel,
                                      struct autosa_gen *gen, struct autosa_group_data *data)
 {
   for (int i = 0; i < kernel->n_array; i++)
   {
     struct autosa_local_array_info *local = &kernel->array[i];
+    cJSON *entry = NULL, *io_clusters;
+
+    if (data->group_cache)
+    {
+      entry = cJSON_GetObjectItemCaseSensitive(data->group_cache, local->array->name);
+      if (!entry)
+      {
+        entry = cJSON_CreateObject();
+        cJSON_AddItemToObject(data->group_cache, local->array->name, entry);
+      }
+    }
+    io_clusters = io_group_cache_get_array(entry, "io_clusters");
     for (int j = 0; j < local->n_io_group; j++)
     {
-      compute_io_group_schedule(kernel, local->io_groups[j], gen);
+      cJSON *cluster = NULL;
+      if (io_clusters)
+      {
+        cluster = cJSON_GetArrayItem(io_clusters, j);
+        if (!cluster)
+        {
+          cluster = cJSON_CreateArray();
+          cJSON_AddItemToArray(io_clusters, cluster);
+        }
+        else if (!cJSON_IsArray(cluster))
+        {
+          cluster = cJSON_CreateArray();
+          cJSON_ReplaceItemInArray(io_clusters, j, cluster);
+        }
+      }
+      compute_io_group_schedule(kernel, local->io_groups[j], gen, cluster);
     }
     if (local->drain_group)
     {
-      compute_io_group_schedule(kernel, local->drain_group, gen);
+      compute_io_group_schedule(kernel, local->drain_group, gen,
+                                io_group_cache_get_array(entry, "drain_cluster"));
     }
   }
   return isl_stat_ok;
@@ -4446,6 +4818,8 @@ static isl_stat autosa_io_buffer_allocate(struct autosa_kernel *kernel,
         {
           /* Seek the opportunity to hoist up the L2 I/O buffers. */
           hoist_L2_io_buffer(kernel, local->io_groups[j], gen, data);
+          if (gen->options->autosa->three_level_buffer)
+            insert_L3_io_buffer(kernel, local->io_groups[j], gen);
         }      
         if (gen->options->autosa->local_reduce && local->io_groups[j]->attached_drain_group)
         {
@@ -4471,6 +4845,8 @@ static isl_stat autosa_io_buffer_allocate(struct autosa_kernel *kernel,
       if (gen->options->autosa->two_level_buffer)
       {
         hoist_L2_io_buffer(kernel, local->drain_group, gen, data);
+        if (gen->options->autosa->three_level_buffer)
+          insert_L3_io_buffer(kernel, local->drain_group, gen);
       }
     }
   }
@@ -4526,6 +4902,183 @@ static isl_stat autosa_io_data_pack(struct autosa_kernel *kernel,
   return isl_stat_ok;
 }
 
+/* Return the path of the I/O grouping cache file. */
+static char *io_group_cache_path(struct autosa_gen *gen)
+{
+  isl_printer *p_str;
+  char *path;
+
+  p_str = isl_printer_to_str(gen->ctx);
+  p_str = isl_printer_print_str(p_str, gen->options->autosa->output_dir);
+  p_str = isl_printer_print_str(p_str, "/io_group_cache.json");
+  path = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+
+  return path;
+}
+
+/* Load the I/O grouping cache from the output directory.
+ * Return an empty cache if the file doesn't exist.
+ */
+static cJSON *load_io_group_cache(struct autosa_gen *gen)
+{
+  FILE *f;
+  char *path, *buffer = NULL;
+  long length;
+  cJSON *cache = NULL;
+
+  path = io_group_cache_path(gen);
+  f = fopen(path, "rb");
+  free(path);
+  if (f)
+  {
+    fseek(f, 0, SEEK_END);
+    length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buffer = (char *)malloc(length + 1);
+    if (buffer)
+    {
+      buffer[length] = '\0';
+      int r = fread(buffer, 1, length, f);
+    }
+    fclose(f);
+  }
+  if (buffer)
+  {
+    cache = cJSON_Parse(buffer);
+    free(buffer);
+  }
+  if (!cJSON_IsObject(cache))
+  {
+    cJSON_Delete(cache);
+    cache = cJSON_CreateObject();
+  }
+
+  return cache;
+}
+
+/* Save the entry "entry" of the design "key" to the I/O grouping cache 
+ * in the output directory.
+ * Several AutoSA processes of a design space exploration may share the 
+ * same output directory. To limit lost updates, the cache file is reloaded 
+ * right before the update, and only the entry of the current design is 
+ * replaced. The content is written to a temporary file private to this 
+ * process, which is then renamed to the cache file, such that readers never 
+ * see a partially written cache.
+ */
+static void save_io_group_cache(struct autosa_gen *gen, const char *key, 
+                                cJSON *entry)
+{
+  FILE *fp;
+  char *path, *tmp_path, *content;
+  cJSON *cache;
+  isl_printer *p_str;
+
+  cache = load_io_group_cache(gen);
+  cJSON_DeleteItemFromObjectCaseSensitive(cache, key);
+  cJSON_AddItemToObject(cache, key, cJSON_Duplicate(entry, 1));
+  content = cJSON_Print(cache);
+  cJSON_Delete(cache);
+
+  path = io_group_cache_path(gen);
+  p_str = isl_printer_to_str(gen->ctx);
+  p_str = isl_printer_print_str(p_str, path);
+  p_str = isl_printer_print_str(p_str, ".");
+  p_str = isl_printer_print_int(p_str, (int)getpid());
+  p_str = isl_printer_print_str(p_str, ".tmp");
+  tmp_path = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+
+  fp = fopen(tmp_path, "w");
+  if (fp)
+  {
+    fprintf(fp, "%s", content);
+    if (fclose(fp) != 0 || rename(tmp_path, path) != 0)
+      remove(tmp_path);
+  }
+  free(content);
+  free(tmp_path);
+  free(path);
+}
+
+/* Return the key of the current design in the I/O grouping cache.
+ * The I/O grouping and clustering depend on the program, the space-time
+ * transformation, the array partitioning, and every option read by
+ * sa_io_construct_optimize that changes the groups, the I/O directions,
+ * the I/O levels or the buffers (e.g., --int-io-dir, --two-level-buffer,
+ * --three-level-buffer, --hbm, --io-module-embedding, --local-reduce,
+ * --host-serialize, --data-pack-sizes).
+ * The key is the 64-bit FNV-1a hash of the textual representation of 
+ * the iteration domain and the tagged accesses of the program, these options,
+ * the space-time id and the partial schedules of the bands between the 
+ * "kernel" mark and the "array" mark, which encode the array partitioning 
+ * tiling factors.
+ */
+static char *io_group_cache_key(struct autosa_kernel *kernel)
+{
+  isl_schedule_node *node;
+  isl_printer *p_str;
+  struct ppcg_scop *scop = kernel->prog->scop;
+  struct autosa_options *options = kernel->options->autosa;
+  char *str;
+  char key[17];
+  unsigned long long hash = 14695981039346656037ULL;
+
+  p_str = isl_printer_to_str(kernel->ctx);
+  p_str = isl_printer_print_union_set(p_str, scop->domain);
+  p_str = isl_printer_print_str(p_str, "|");
+  p_str = isl_printer_print_union_map(p_str, scop->tagged_reads);
+  p_str = isl_printer_print_str(p_str, "|");
+  p_str = isl_printer_print_union_map(p_str, scop->tagged_may_writes);
+  p_str = isl_printer_print_str(p_str, "|");
+  int opts[] = {options->int_io_dir, options->two_level_buffer,
+                options->three_level_buffer, options->hbm,
+                options->io_module_embedding, options->local_reduce,
+                options->lower_int_io_L1_buffer, options->host_serialize,
+                options->use_local_memory, options->max_local_memory,
+                options->array_contraction, options->local_array_contraction,
+                options->data_pack};
+  for (int i = 0; i < sizeof(opts) / sizeof(opts[0]); ++i)
+  {
+    p_str = isl_printer_print_int(p_str, opts[i]);
+    p_str = isl_printer_print_str(p_str, ",");
+  }
+  if (options->data_pack_sizes)
+    p_str = isl_printer_print_str(p_str, options->data_pack_sizes);
+  p_str = isl_printer_print_str(p_str, "|kernel");
+  p_str = isl_printer_print_int(p_str, kernel->space_time_id);
+
+  node = isl_schedule_get_root(kernel->schedule);
+  node = autosa_tree_move_down_to_array(node, kernel->core);
+  while (!is_marked(node, "kernel") && isl_schedule_node_has_parent(node))
+  {
+    node = isl_schedule_node_parent(node);
+    if (isl_schedule_node_get_type(node) == isl_schedule_node_band)
+    {
+      isl_multi_union_pw_aff *mupa =
+          isl_schedule_node_band_get_partial_schedule(node);
+      p_str = isl_printer_print_str(p_str, "|");
+      p_str = isl_printer_print_multi_union_pw_aff(p_str, mupa);
+      isl_multi_union_pw_aff_free(mupa);
+    }
+  }
+  isl_schedule_node_free(node);
+  str = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+  if (!str)
+    return NULL;
+
+  for (int i = 0; str[i]; ++i)
+  {
+    hash ^= (unsigned char)str[i];
+    hash *= 1099511628211ULL;
+  }
+  free(str);
+  snprintf(key, sizeof(key), "%016llx", hash);
+
+  return strdup(key);
+}
+
 /* Group references of all arrays in "kernel".
  * Each array is associated with three types of groups:
  * PE group: Assign the local buffers inside PEs.
@@ -4561,6 +5114,28 @@ isl_stat sa_io_construct_optimize(struct autosa_kernel *kernel, struct autosa_ge
   data.full_sched = isl_union_map_flat_range_product(data.full_sched,
                                                      isl_schedule_node_get_subtree_schedule_union_map(node));
   data.schedule = kernel->schedule;
+  data.group_cache = NULL;
+
+  /* Load the I/O grouping cache. */
+  cJSON *group_cache = NULL;
+  char *group_cache_key = NULL;
+  if (gen->options->autosa->io_group_cache)
+    group_cache_key = io_group_cache_key(kernel);
+  if (group_cache_key)
+  {
+    group_cache = load_io_group_cache(gen);
+    data.group_cache = cJSON_GetObjectItemCaseSensitive(group_cache, group_cache_key);
+    if (data.group_cache)
+    {
+      if (gen->options->autosa->verbose)
+        printf("[AutoSA] Reuse the cached I/O grouping and clustering.\n");
+    }
+    else
+    {
+      data.group_cache = cJSON_CreateObject();
+      cJSON_AddItemToObject(group_cache, group_cache_key, data.group_cache);
+    }
+  }
 
   /* Create the default array reference groups (PPCG heritage). */
   for (int i = 0; i < kernel->n_array; i++)
@@ -4600,6 +5175,15 @@ isl_stat sa_io_construct_optimize(struct autosa_kernel *kernel, struct autosa_ge
   /* I/O module clustering */
   autosa_io_clustering(kernel, gen, &data);
 
+  /* Update the I/O grouping cache. */
+  if (group_cache)
+  {
+    save_io_group_cache(gen, group_cache_key, data.group_cache);
+    cJSON_Delete(group_cache);
+    free(group_cache_key);
+    data.group_cache = NULL;
+  }
+
   /* Local reduce */
   if (gen->options->autosa->local_reduce) 
   {
@@ -4663,6 +5247,7 @@ isl_stat sa_io_construct_optimize(struct autosa_kernel *kernel, struct autosa_ge
   {
     /* Disable the two-level buffering when host data serialization is enabled. */
     gen->options->autosa->two_level_buffer = 0;
+    gen->options->autosa->three_level_buffer = 0;
     printf("[AutoSA] Warning: Two-level buffering is disabled because host data serialization is enabled.\n");
   }
   if (gen->options->autosa->host_serialize && gen->options->autosa->hbm)
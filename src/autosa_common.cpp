@@ -1,5 +1,6 @@
 /* Defines functions used for AutoSA structs. */
 
+#include <math.h>
 #include <isl/id.h>
 #include <cJSON/cJSON.h>
 
@@ -23,6 +24,7 @@ void *autosa_kernel_free(struct autosa_kernel *kernel)
   isl_union_set_free(kernel->core);
   isl_set_free(kernel->context);
   isl_multi_pw_aff_free(kernel->sa_grid_size);
+  isl_set_free(kernel->pe_active);
   isl_union_set_free(kernel->arrays);
   isl_union_pw_multi_aff_free(kernel->copy_schedule);
   isl_space_free(kernel->space);
@@ -88,6 +90,8 @@ struct autosa_kernel *autosa_kernel_copy(struct autosa_kernel *kernel)
   kernel_dup->time_w = kernel->time_w;
   kernel_dup->type = kernel->type;
   kernel_dup->sa_grid_size = isl_multi_pw_aff_copy(kernel->sa_grid_size);
+  kernel_dup->pe_active = isl_set_copy(kernel->pe_active);
+  kernel_dup->pe_util = kernel->pe_util;
   kernel_dup->sizes = isl_union_map_copy(kernel->sizes);
   kernel_dup->used_sizes = isl_union_map_copy(kernel->used_sizes);
   kernel_dup->id = kernel->id;
@@ -98,6 +102,7 @@ struct autosa_kernel *autosa_kernel_copy(struct autosa_kernel *kernel)
   kernel_dup->array = kernel->array;
   kernel_dup->copy_schedule = isl_union_pw_multi_aff_copy(kernel->copy_schedule);
   kernel_dup->copy_schedule_dim = kernel->copy_schedule_dim;
+  kernel_dup->simd_reduction = kernel->simd_reduction;
   kernel_dup->space = isl_space_copy(kernel->space);
   kernel_dup->tree = isl_ast_node_copy(kernel->tree);
   kernel_dup->n_var = kernel->n_var;
@@ -150,6 +155,8 @@ struct autosa_kernel *autosa_kernel_from_schedule(__isl_take isl_schedule *sched
   kernel->time_w = 0;
   kernel->type = 0;
   kernel->sa_grid_size = NULL;
+  kernel->pe_active = NULL;
+  kernel->pe_util = -1;
   kernel->sizes = NULL;
   kernel->used_sizes = NULL;
   kernel->id = 0;
@@ -177,6 +184,7 @@ struct autosa_kernel *autosa_kernel_from_schedule(__isl_take isl_schedule *sched
   kernel->host_domain = NULL;
   kernel->domain = NULL;
   kernel->single_statement = 0;
+  kernel->simd_reduction = 0;
   kernel->sparse = 0;
   kernel->vec_len = 0;
   kernel->n_nzero = 0;
@@ -210,6 +218,8 @@ struct autosa_kernel *autosa_kernel_alloc(isl_ctx *ctx, struct ppcg_scop *scop)
   kernel->time_w = 0;
   kernel->type = 0;
   kernel->sa_grid_size = NULL;
+  kernel->pe_active = NULL;
+  kernel->pe_util = -1;
   kernel->sizes = NULL;
   kernel->used_sizes = NULL;
   kernel->id = 0;
@@ -237,6 +247,7 @@ struct autosa_kernel *autosa_kernel_alloc(isl_ctx *ctx, struct ppcg_scop *scop)
   kernel->host_domain = NULL;
   kernel->domain = NULL;
   kernel->single_statement = 0;  
+  kernel->simd_reduction = 0;
   kernel->sparse = 0;
   kernel->vec_len = 0;
   kernel->n_nzero = 0;
@@ -455,6 +466,42 @@ void *autosa_dep_free(__isl_take struct autosa_dep *dep)
   return NULL;
 }
 
+struct autosa_dep_dis_table *autosa_dep_dis_table_alloc(isl_ctx *ctx)
+{
+  struct autosa_dep_dis_table *table;
+
+  table = (struct autosa_dep_dis_table *)calloc(1, sizeof(struct autosa_dep_dis_table));
+  if (!table)
+    return NULL;
+  table->ctx = ctx;
+
+  return table;
+}
+
+void *autosa_dep_dis_table_free(struct autosa_dep_dis_table *table)
+{
+  if (!table)
+    return NULL;
+
+  for (int i = 0; i < table->n_entry; i++)
+  {
+    struct autosa_dep_dis_entry *entry = table->entries[i];
+    isl_multi_union_pw_aff_free(entry->sched);
+    for (int j = 0; j < entry->n_dep; j++)
+      isl_vec_free(entry->dis[j]);
+    free(entry->dis);
+    free(entry->computed);
+    free(entry);
+  }
+  free(table->entries);
+  for (int i = 0; i < table->n_dep; i++)
+    isl_basic_map_free(table->deps[i]);
+  free(table->deps);
+  free(table);
+
+  return NULL;
+}
+
 /****************************************************************
  * AutoSA iterator
  ****************************************************************/
@@ -1354,6 +1401,180 @@ struct autosa_stmt *extract_stmts(isl_ctx *ctx, struct ppcg_scop *scop,
   return stmts;
 }
 
+/* Is "a" an access expression that accesses the same element as "b"? */
+static int is_same_access_expr(__isl_keep pet_expr *a, __isl_keep pet_expr *b)
+{
+  isl_multi_pw_aff *index_a, *index_b;
+  isl_bool equal;
+
+  if (pet_expr_get_type(a) != pet_expr_access ||
+      pet_expr_get_type(b) != pet_expr_access)
+    return 0;
+
+  index_a = pet_expr_access_get_index(a);
+  index_b = pet_expr_access_get_index(b);
+  equal = isl_multi_pw_aff_plain_is_equal(index_a, index_b);
+  isl_multi_pw_aff_free(index_a);
+  isl_multi_pw_aff_free(index_b);
+
+  return equal == isl_bool_true;
+}
+
+/* Return the operand of the right-hand side "rhs" of an assignment that 
+ * reads the same element as the left-hand side "lhs", if "rhs" combines 
+ * this operand with an associative operator, i.e.,
+ *
+ *   lhs = lhs + x, lhs = x + lhs, lhs = lhs - x,
+ *   lhs = lhs * x, lhs = x * lhs,
+ *   lhs = max(lhs, x), lhs = min(x, lhs), ...
+ *
+ * Return NULL otherwise.
+ * If "op" is not NULL, it is set to the operator that combines the 
+ * partial results of the reduction.
+ */
+static __isl_give pet_expr *extract_reduction_operand(
+  __isl_keep pet_expr *rhs, __isl_keep pet_expr *lhs, const char **op)
+{
+  int n_arg;
+  const char *combine;
+
+  if (pet_expr_get_type(rhs) == pet_expr_op)
+  {
+    enum pet_op_type type = pet_expr_op_get_type(rhs);
+    if (type != pet_op_add && type != pet_op_sub && type != pet_op_mul)
+      return NULL;
+    n_arg = pet_expr_get_n_arg(rhs);
+    if (n_arg != 2)
+      return NULL;
+    /* Subtraction is only associative in its first operand. */
+    if (type == pet_op_sub)
+      n_arg = 1;
+    combine = type == pet_op_mul ? "*" : "+";
+  }
+  else if (pet_expr_get_type(rhs) == pet_expr_call)
+  {
+    const char *name = pet_expr_call_get_name(rhs);
+    if (strcmp(name, "max") && strcmp(name, "min") &&
+        strcmp(name, "fmax") && strcmp(name, "fmin"))
+      return NULL;
+    n_arg = pet_expr_get_n_arg(rhs);
+    if (n_arg != 2)
+      return NULL;
+    combine = name;
+  }
+  else
+  {
+    return NULL;
+  }
+
+  for (int i = 0; i < n_arg; i++)
+  {
+    pet_expr *arg = pet_expr_get_arg(rhs, i);
+    if (is_same_access_expr(arg, lhs))
+    {
+      if (op)
+        *op = combine;
+      return arg;
+    }
+    pet_expr_free(arg);
+  }
+
+  return NULL;
+}
+
+/* Is the statement "stmt" a reduction update on a single array element?
+ * That is, the statement body is an expression of the form
+ *
+ *   A[f] op= x, with op in {+, -, *}, or
+ *   A[f] = A[f] op x, with op as an associative operator (see above).
+ *
+ * If so, return the reference identifiers of the written access and the 
+ * access that reads the reduction variable in "write_ref" and "read_ref".
+ * For compound assignments, both references are the same.
+ * If "op" is not NULL, it is set to a newly allocated string holding the 
+ * operator that combines partial results, i.e., "+" (also for subtraction),
+ * "*", or the name of the max/min function.
+ */
+isl_bool autosa_stmt_is_reduction(struct autosa_stmt *stmt,
+                                  __isl_give isl_id **write_ref, __isl_give isl_id **read_ref,
+                                  char **op)
+{
+  pet_expr *expr, *lhs, *read = NULL;
+  isl_bool is_reduction;
+  const char *combine = NULL;
+
+  if (pet_tree_get_type(stmt->stmt->body) != pet_tree_expr)
+    return isl_bool_false;
+
+  expr = pet_tree_expr_get_expr(stmt->stmt->body);
+  if (pet_expr_get_type(expr) != pet_expr_op)
+  {
+    pet_expr_free(expr);
+    return isl_bool_false;
+  }
+
+  lhs = pet_expr_get_arg(expr, 0);
+  if (pet_expr_get_type(lhs) == pet_expr_access)
+  {
+    switch (pet_expr_op_get_type(expr))
+    {
+    case pet_op_add_assign:
+    case pet_op_sub_assign:
+      read = pet_expr_copy(lhs);
+      combine = "+";
+      break;
+    case pet_op_mul_assign:
+      read = pet_expr_copy(lhs);
+      combine = "*";
+      break;
+    case pet_op_assign:
+    {
+      pet_expr *rhs = pet_expr_get_arg(expr, 1);
+      read = extract_reduction_operand(rhs, lhs, &combine);
+      pet_expr_free(rhs);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  is_reduction = read ? isl_bool_true : isl_bool_false;
+  if (read)
+  {
+    if (write_ref)
+      *write_ref = pet_expr_access_get_ref_id(lhs);
+    if (read_ref)
+      *read_ref = pet_expr_access_get_ref_id(read);
+    if (op)
+      *op = strdup(combine);
+    pet_expr_free(read);
+  }
+  pet_expr_free(lhs);
+  pet_expr_free(expr);
+
+  return is_reduction;
+}
+
+/* Return the depth of the balanced reduction tree that combines the SIMD 
+ * lanes of "kernel", i.e., ceil(log2(simd_w)), or 0 if no such tree is 
+ * generated. The tree is only generated for Xilinx HLS C when the SIMD loop 
+ * is a reduction loop.
+ */
+int autosa_kernel_simd_reduce_tree_depth(struct autosa_kernel *kernel)
+{
+  int depth = 0;
+
+  if (!kernel->options->autosa->simd_reduce_tree || !kernel->simd_reduction)
+    return 0;
+  if (kernel->options->target != AUTOSA_TARGET_XILINX_HLS_C || kernel->sparse)
+    return 0;
+  while ((1 << depth) < kernel->simd_w)
+    depth++;
+
+  return depth;
+}
+
 void autosa_kernel_stmt_free(void *user)
 {
   struct autosa_kernel_stmt *stmt = (struct autosa_kernel_stmt *)user;
@@ -1390,6 +1611,7 @@ void autosa_kernel_stmt_free(void *user)
     break;
   case AUTOSA_KERNEL_STMT_DRAIN_MERGE:
     isl_ast_expr_free(stmt->u.dm.index);
+    free(stmt->u.dm.contiguous_iter);
     break;
   case AUTOSA_KERNEL_STMT_HOST_SERIALIZE:
     isl_ast_expr_free(stmt->u.s.index);
@@ -1826,6 +2048,7 @@ struct autosa_ast_node_userinfo *alloc_ast_node_userinfo()
   info->is_first_infinitizable_loop = 0;  
   info->is_dep_free = 0;
   info->n_coalesce_loop = 0;
+  info->n_flatten_loop = 0;
   info->visited = 0;
 
   info->is_guard_start = 0;
@@ -2092,6 +2315,41 @@ error:
   return -1;
 }
 
+/* Return the first external memory port assigned to "array" in "kernel".
+ * If the port is specified in "mem_port_map", it is returned directly.
+ * Otherwise, the arrays are placed on consecutive ports in the order they
+ * appear in the kernel, each array occupying "n_mem_ports" ports.
+ */
+int autosa_array_get_mem_port_base(struct autosa_kernel *kernel,
+                                   struct autosa_array_info *array,
+                                   char *mem_port_map)
+{
+  int base = 0;
+
+  if (mem_port_map) {
+    isl_union_map *umap;
+    int port;
+
+    umap = extract_sizes_from_str(kernel->ctx, mem_port_map);
+    port = read_mem_port_map(umap, array->name);
+    isl_union_map_free(umap);
+    if (port != -1)
+      return port;
+  }
+
+  for (int i = 0; i < kernel->n_array; i++) {
+    struct autosa_local_array_info *local_array = &kernel->array[i];
+    if (local_array->array == array)
+      break;
+    if (autosa_array_is_read_only_scalar(local_array->array) ||
+        !local_array->array->global)
+      continue;
+    base += local_array->n_mem_ports;
+  }
+
+  return base;
+}
+
 int *read_default_hbm_tile_sizes(struct autosa_kernel *sa, int tile_len)
 {
   int n;
@@ -2354,6 +2612,32 @@ error:
   return NULL;
 }
 
+int *read_array_part_L3_tile_sizes(struct autosa_kernel *sa, int tile_len)
+{
+  int *tile_size;
+  isl_set *size;
+
+  tile_size = isl_alloc_array(sa->ctx, int, tile_len);
+  if (!tile_size)
+    return NULL;
+
+  size = extract_sa_sizes(sa->sizes, "array_part_L3");
+  if (isl_set_dim(size, isl_dim_set) < tile_len)
+  {
+    free(tile_size);
+    isl_set_free(size);
+    return NULL;
+  }
+  if (read_sa_sizes_from_set(size, tile_size, tile_len) < 0)
+    goto error;
+  set_sa_used_sizes(sa, "array_part_L3", sa->id, tile_size, tile_len);
+
+  return tile_size;
+error:
+  free(tile_size);
+  return NULL;
+}
+
 int *read_default_array_part_L2_tile_sizes(struct autosa_kernel *sa, int tile_len)
 {
   int n;
@@ -2368,6 +2652,612 @@ int *read_default_array_part_L2_tile_sizes(struct autosa_kernel *sa, int tile_le
   return tile_size;
 }
 
+/****************************************************************
+ * AutoSA auto-mode tile size search
+ ****************************************************************/
+/* Hardware budget and model parameters used by the tile size search in 
+ * the auto mode.
+ * "dsp_per_op" is the number of DSPs used by one operation in the PE.
+ * "pipeline_depth" is the latency of the PE pipeline to be hidden.
+ * "max_util" is the maximal resource utilization ratio.
+ */
+struct autosa_hw_model
+{
+  double dsp;
+  double bram18k;
+  double uram;
+  double dsp_per_op;
+  int pipeline_depth;
+  double max_util;
+};
+
+/* Load the hardware budget from the file specified by --hw-info.
+ * The file uses the same format as autosa_config/hw_info.json, with optional
+ * fields "DSP_per_op", "pipeline_depth", and "max_util".
+ * Without the file, the built-in defaults of Xilinx U250 (the budget of
+ * autosa_config/hw_info.json) are assumed and a warning is printed once.
+ */
+static void load_hw_model(struct autosa_kernel *sa, struct autosa_hw_model *hw)
+{
+  static int warned = 0;
+  FILE *f;
+  char *buffer = NULL;
+  long length;
+  cJSON *hw_info, *item;
+
+  hw->dsp = 12288;
+  hw->bram18k = 5376;
+  hw->uram = 1280;
+  hw->dsp_per_op = 5;
+  hw->pipeline_depth = 8;
+  hw->max_util = 0.8;
+
+  if (!sa->options->autosa->hw_info)
+  {
+    if (!warned)
+    {
+      printf("[AutoSA] Warning: No hardware information file is given by --hw-info. "
+             "Fall back to the built-in defaults of Xilinx U250 (%.0f DSPs, %.0f BRAM18Ks). "
+             "The tile sizes picked in the auto mode rely on rough resource and latency models.\n",
+             hw->dsp, hw->bram18k);
+      warned = 1;
+    }
+    return;
+  }
+  f = fopen(sa->options->autosa->hw_info, "rb");
+  if (!f)
+  {
+    printf("[AutoSA] Error: Can't open hardware information file: %s\n",
+           sa->options->autosa->hw_info);
+    exit(1);
+  }
+  fseek(f, 0, SEEK_END);
+  length = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  buffer = (char *)malloc(length + 1);
+  if (buffer)
+  {
+    buffer[length] = '\0';
+    int r = fread(buffer, 1, length, f);
+  }
+  fclose(f);
+  if (!buffer)
+    return;
+
+  hw_info = cJSON_Parse(buffer);
+  free(buffer);
+  item = cJSON_GetObjectItemCaseSensitive(hw_info, "DSP");
+  if (cJSON_IsNumber(item))
+    hw->dsp = item->valuedouble;
+  item = cJSON_GetObjectItemCaseSensitive(hw_info, "BRAM18K");
+  if (cJSON_IsNumber(item))
+    hw->bram18k = item->valuedouble;
+  item = cJSON_GetObjectItemCaseSensitive(hw_info, "URAM");
+  if (cJSON_IsNumber(item))
+    hw->uram = item->valuedouble;
+  item = cJSON_GetObjectItemCaseSensitive(hw_info, "DSP_per_op");
+  if (cJSON_IsNumber(item))
+    hw->dsp_per_op = item->valuedouble;
+  item = cJSON_GetObjectItemCaseSensitive(hw_info, "pipeline_depth");
+  if (cJSON_IsNumber(item))
+    hw->pipeline_depth = item->valueint;
+  item = cJSON_GetObjectItemCaseSensitive(hw_info, "max_util");
+  if (cJSON_IsNumber(item))
+    hw->max_util = item->valuedouble;
+  cJSON_Delete(hw_info);
+}
+
+/* Return the tiling factors of a loop with the upper bound "ub", i.e., 
+ * the divisors of "ub" in [lb, ub], excluding "ub" itself if "ub_inclusive"
+ * is not set. If "ub" is unknown, the default tile size is used.
+ * The number of factors is returned in "n".
+ */
+static int *get_tile_factors(struct autosa_kernel *sa, int ub, int lb,
+                             int ub_inclusive, int *n)
+{
+  int *factors;
+
+  *n = 0;
+  if (ub <= 0)
+  {
+    factors = (int *)malloc(sizeof(int));
+    factors[(*n)++] = sa->scop->options->autosa->sa_tile_size;
+    return factors;
+  }
+  factors = (int *)malloc(ub * sizeof(int));
+  for (int f = lb; f <= ub; f++)
+  {
+    if (f == ub && !ub_inclusive)
+      break;
+    if (ub % f == 0)
+      factors[(*n)++] = f;
+  }
+  if (*n == 0)
+    factors[(*n)++] = ub;
+
+  return factors;
+}
+
+/* Estimate the number of bytes used by the I/O buffers for an array
+ * partition with "tile_volume" iterations in a "tile_len"-dimensional band.
+ * Each array is assumed to be accessed by a (tile_len - 1)-dimensional
+ * face of the tile and is double buffered.
+ */
+static double estimate_array_part_bytes(struct autosa_kernel *sa,
+                                        double tile_volume, int tile_len)
+{
+  double bytes = 0;
+  double face = tile_len > 1 ? pow(tile_volume, (double)(tile_len - 1) / tile_len) : 1;
+
+  for (int i = 0; i < sa->prog->n_array; i++)
+    bytes += 2 * face * sa->prog->array[i].size;
+
+  return bytes;
+}
+
+/* Estimate the number of BRAM18K used by the I/O buffers for an array
+ * partition with "tile_volume" iterations in a "tile_len"-dimensional band.
+ */
+static double estimate_array_part_bram18k(struct autosa_kernel *sa,
+                                          double tile_volume, int tile_len)
+{
+  return ceil(estimate_array_part_bytes(sa, tile_volume, tile_len) / 2304);
+}
+
+/* Internal data struct used for search_array_part_tile_sizes. */
+struct array_part_search_data
+{
+  struct autosa_kernel *sa;
+  struct autosa_hw_model hw;
+  int tile_len;
+  int *ubs;
+  int *is_space;
+  int *is_parallel;
+  int **factors;
+  int *n_factors;
+  int *cur;
+  int *best;
+  double best_cycles;
+  double best_volume;
+};
+
+/* Evaluate the array partitioning tiling factors in data->cur.
+ * The number of PEs equals the product of the tiling factors of the
+ * space loops. The pipeline latency is hidden by the parallel time loops
+ * first, and then by the parallel space loops, which reduces the number
+ * of PEs. Latency hiding on a parallel space loop with the tiling factor "t"
+ * moves up to t/2 of its iterations inside each PE, such that at least
+ * two PEs are left along the loop, i.e., it hides at most t/2 cycles
+ * (which can be fractional for odd factors, the estimate is kept in
+ * floating point). Loops with t < 2 cannot be folded.
+ * The cycles are estimated as the computation cycles of all array
+ * partitions, each suffering from the fill/drain latency of the array.
+ */
+static void array_part_search_eval(struct array_part_search_data *data)
+{
+  double n_pe = 1, n_tile = 1, volume = 1;
+  double hide_time = 1, hide_space = 1, fill = 0;
+  double stall = 1;
+  double cycles;
+
+  for (int i = 0; i < data->tile_len; i++)
+  {
+    int t = data->cur[i];
+    volume *= t;
+    if (data->ubs[i] > 0)
+      n_tile *= (data->ubs[i] + t - 1) / t;
+    if (data->is_space[i])
+    {
+      n_pe *= t;
+      fill += t;
+      if (data->is_parallel[i] && t >= 2)
+        hide_space *= t / 2.0;
+    }
+    else if (data->is_parallel[i])
+    {
+      hide_time *= t;
+    }
+  }
+
+  if (n_pe * data->hw.dsp_per_op > data->hw.max_util * data->hw.dsp)
+    return;
+  if (estimate_array_part_bram18k(data->sa, volume, data->tile_len) >
+      data->hw.max_util * data->hw.bram18k)
+    return;
+
+  if (hide_time < data->hw.pipeline_depth)
+  {
+    double need = ceil(data->hw.pipeline_depth / hide_time);
+    if (hide_space >= need)
+    {
+      n_pe /= need;
+    }
+    else
+    {
+      n_pe /= hide_space;
+      stall = data->hw.pipeline_depth / (hide_time * hide_space);
+    }
+  }
+
+  cycles = n_tile * (volume / n_pe * stall + fill);
+  if (!data->best || cycles < data->best_cycles ||
+      (cycles == data->best_cycles && volume < data->best_volume))
+  {
+    if (!data->best)
+      data->best = (int *)malloc(data->tile_len * sizeof(int));
+    for (int i = 0; i < data->tile_len; i++)
+      data->best[i] = data->cur[i];
+    data->best_cycles = cycles;
+    data->best_volume = volume;
+  }
+}
+
+static void array_part_search(struct array_part_search_data *data, int pos)
+{
+  if (pos == data->tile_len)
+  {
+    array_part_search_eval(data);
+    return;
+  }
+  for (int i = 0; i < data->n_factors[pos]; i++)
+  {
+    data->cur[pos] = data->factors[pos][i];
+    array_part_search(data, pos + 1);
+  }
+}
+
+/* Search the array partitioning tiling factors of the band "node" in the 
+ * auto mode. All the divisors of the loop bounds are enumerated and the 
+ * factors with the least estimated cycles within the hardware budget are 
+ * selected. Factors of one are excluded to avoid PE arrays with a 
+ * single PE along any dimension.
+ * If no factor fits the budget, the default tile sizes are used.
+ */
+int *search_array_part_tile_sizes(struct autosa_kernel *sa,
+                                  __isl_keep isl_schedule_node *node)
+{
+  struct array_part_search_data data;
+  int tile_len = isl_schedule_node_band_n_member(node);
+  int *tile_size;
+
+  data.sa = sa;
+  load_hw_model(sa, &data.hw);
+  data.tile_len = tile_len;
+  data.ubs = extract_band_upper_bounds(node);
+  data.is_space = (int *)malloc(tile_len * sizeof(int));
+  data.is_parallel = (int *)malloc(tile_len * sizeof(int));
+  data.factors = (int **)malloc(tile_len * sizeof(int *));
+  data.n_factors = (int *)malloc(tile_len * sizeof(int));
+  data.cur = (int *)malloc(tile_len * sizeof(int));
+  data.best = NULL;
+  for (int i = 0; i < tile_len; i++)
+  {
+    data.is_space[i] = isl_schedule_node_band_member_get_space_time(node, i) ==
+                       autosa_loop_space;
+    data.is_parallel[i] = isl_schedule_node_band_member_get_coincident(node, i);
+    data.factors[i] = get_tile_factors(sa, data.ubs[i], 2, 1, &data.n_factors[i]);
+  }
+
+  array_part_search(&data, 0);
+
+  if (data.best)
+  {
+    tile_size = data.best;
+    if (sa->scop->options->autosa->verbose)
+    {
+      printf("[AutoSA] Auto array partitioning: [");
+      for (int i = 0; i < tile_len; i++)
+        printf("%d%s", tile_size[i], i == tile_len - 1 ? "" : ",");
+      printf("], estimated cycles: %.0f\n", data.best_cycles);
+    }
+  }
+  else
+  {
+    printf("[AutoSA] Warning: No array partitioning fits the hardware budget. Use the default tile sizes.\n");
+    tile_size = read_default_array_part_tile_sizes(sa, tile_len);
+  }
+
+  for (int i = 0; i < tile_len; i++)
+    free(data.factors[i]);
+  free(data.factors);
+  free(data.n_factors);
+  free(data.cur);
+  free(data.is_space);
+  free(data.is_parallel);
+  free(data.ubs);
+
+  return tile_size;
+}
+
+/* Internal data struct used for search_array_part_L3_tile_sizes. */
+struct array_part_L3_search_data
+{
+  struct autosa_kernel *sa;
+  int tile_len;
+  int **factors;
+  int *n_factors;
+  int *cur;
+  int *best;
+  double inner_volume;
+  double budget;
+  double best_volume;
+};
+
+static void array_part_L3_search(struct array_part_L3_search_data *data, int pos)
+{
+  if (pos == data->tile_len)
+  {
+    double volume = 1;
+    for (int i = 0; i < data->tile_len; i++)
+      volume *= data->cur[i];
+    if (estimate_array_part_bytes(data->sa, volume * data->inner_volume,
+                                  data->tile_len) > data->budget)
+      return;
+    if (!data->best || volume > data->best_volume)
+    {
+      if (!data->best)
+        data->best = (int *)malloc(data->tile_len * sizeof(int));
+      for (int i = 0; i < data->tile_len; i++)
+        data->best[i] = data->cur[i];
+      data->best_volume = volume;
+    }
+    return;
+  }
+  for (int i = 0; i < data->n_factors[pos]; i++)
+  {
+    data->cur[pos] = data->factors[pos][i];
+    array_part_L3_search(data, pos + 1);
+  }
+}
+
+/* Search the L3 array partitioning tiling factors of the band "node" in 
+ * the auto mode. "node" points to the L2 array partitioning tile band, 
+ * each iteration of which covers one L2 array partition.
+ * A larger L3 tile increases the on-chip data reuse, but the L3 buffers 
+ * hold the data of the whole L3 tile. We select the largest L3 tile whose
+ * L3 buffers, estimated as in estimate_array_part_bytes, fit in the URAM 
+ * budget (36 KB per URAM), or in the BRAM budget if the device has no URAM.
+ * If even the smallest tile doesn't fit, or if the loop bounds are unknown, 
+ * the L3 tile equals the L2 array partition (all factors are one).
+ */
+int *search_array_part_L3_tile_sizes(struct autosa_kernel *sa,
+                                     __isl_keep isl_schedule_node *node)
+{
+  struct array_part_L3_search_data data;
+  struct autosa_hw_model hw;
+  int tile_len = isl_schedule_node_band_n_member(node);
+  int *ubs, *tile_size;
+
+  load_hw_model(sa, &hw);
+  data.sa = sa;
+  data.tile_len = tile_len;
+  data.inner_volume = extract_band_inner_volume(node);
+  data.budget = hw.uram > 0 ? hw.max_util * hw.uram * 36864 :
+                              hw.max_util * hw.bram18k * 2304;
+  data.factors = (int **)malloc(tile_len * sizeof(int *));
+  data.n_factors = (int *)malloc(tile_len * sizeof(int));
+  data.cur = (int *)malloc(tile_len * sizeof(int));
+  data.best = NULL;
+  ubs = extract_band_upper_bounds(node);
+  for (int i = 0; i < tile_len; i++)
+  {
+    if (ubs[i] > 0)
+    {
+      data.factors[i] = get_tile_factors(sa, ubs[i], 1, 1, &data.n_factors[i]);
+    }
+    else
+    {
+      data.factors[i] = (int *)malloc(sizeof(int));
+      data.factors[i][0] = 1;
+      data.n_factors[i] = 1;
+    }
+  }
+
+  if (data.inner_volume > 0)
+    array_part_L3_search(&data, 0);
+
+  if (data.best)
+  {
+    tile_size = data.best;
+    if (sa->scop->options->autosa->verbose)
+    {
+      printf("[AutoSA] Auto L3 array partitioning: [");
+      for (int i = 0; i < tile_len; i++)
+        printf("%d%s", tile_size[i], i == tile_len - 1 ? "" : ",");
+      printf("], estimated L3 buffer size: %.0f bytes\n",
+             estimate_array_part_bytes(sa, data.best_volume * data.inner_volume, tile_len));
+    }
+  }
+  else
+  {
+    printf("[AutoSA] Warning: No L3 array partitioning fits the on-chip memory budget. Use one L2 array partition per L3 tile.\n");
+    tile_size = (int *)malloc(tile_len * sizeof(int));
+    for (int i = 0; i < tile_len; i++)
+      tile_size[i] = 1;
+  }
+
+  for (int i = 0; i < tile_len; i++)
+    free(data.factors[i]);
+  free(data.factors);
+  free(data.n_factors);
+  free(data.cur);
+  free(ubs);
+
+  return tile_size;
+}
+
+/* Search the latency hiding tiling factors in the auto mode.
+ * "ubs" are the upper bounds of the "tile_len" candidate loops and "is_space"
+ * indicates if the candidate loop is a space loop.
+ * Tiling a space loop reduces the number of PEs, therefore, we select the 
+ * factors that minimize the cycles per operation, 
+ * i.e., max(1, pipeline_depth / hidden latency) / #PE, 
+ * with the least number of hidden iterations on ties.
+ */
+int *search_latency_tile_sizes(struct autosa_kernel *sa, int tile_len,
+                               int *ubs, int *is_space)
+{
+  struct autosa_hw_model hw;
+  int **factors, *n_factors, *cur, *tile_size;
+  double n_pe = 1;
+  double best_cost = -1, best_hide = 0;
+  int done = 0;
+
+  load_hw_model(sa, &hw);
+  for (int i = 0; i < sa->n_sa_dim; i++)
+    n_pe *= sa->sa_dim[i];
+
+  tile_size = isl_alloc_array(sa->ctx, int, tile_len);
+  factors = (int **)malloc(tile_len * sizeof(int *));
+  n_factors = (int *)malloc(tile_len * sizeof(int));
+  cur = (int *)calloc(tile_len, sizeof(int));
+  for (int i = 0; i < tile_len; i++)
+  {
+    factors[i] = get_tile_factors(sa, ubs[i], 1, ubs[i] <= 1, &n_factors[i]);
+    tile_size[i] = 1;
+  }
+
+  /* Enumerate all the combinations. */
+  while (!done && tile_len > 0)
+  {
+    double hide = 1, pe = n_pe, cost;
+    for (int i = 0; i < tile_len; i++)
+    {
+      int f = factors[i][cur[i]];
+      hide *= f;
+      if (is_space[i])
+        pe /= f;
+    }
+    cost = (hide < hw.pipeline_depth ? hw.pipeline_depth / hide : 1) / pe;
+    if (best_cost < 0 || cost < best_cost ||
+        (cost == best_cost && hide < best_hide))
+    {
+      best_cost = cost;
+      best_hide = hide;
+      for (int i = 0; i < tile_len; i++)
+        tile_size[i] = factors[i][cur[i]];
+    }
+    for (int i = tile_len - 1; i >= 0; i--)
+    {
+      if (++cur[i] < n_factors[i])
+        break;
+      cur[i] = 0;
+      if (i == 0)
+        done = 1;
+    }
+  }
+
+  if (sa->scop->options->autosa->verbose)
+  {
+    printf("[AutoSA] Auto latency hiding: [");
+    for (int i = 0; i < tile_len; i++)
+      printf("%d%s", tile_size[i], i == tile_len - 1 ? "" : ",");
+    printf("]\n");
+  }
+
+  for (int i = 0; i < tile_len; i++)
+    free(factors[i]);
+  free(factors);
+  free(n_factors);
+  free(cur);
+
+  return tile_size;
+}
+
+/* Return the maximal number of SIMD lanes that fit in the outermost data 
+ * packing width (--data-pack-sizes, 64 bytes by default) of all the arrays 
+ * in "sa", i.e., the width of the external memory ports.
+ */
+static int max_simd_lanes(struct autosa_kernel *sa)
+{
+  isl_union_map *sizes;
+  int max_lanes = -1;
+
+  sizes = extract_sizes_from_str(sa->ctx, sa->options->autosa->data_pack_sizes);
+  for (int i = 0; i < sa->prog->n_array; i++)
+  {
+    struct autosa_array_info *array = &sa->prog->array[i];
+    int *data_pack_ubs;
+    int width = 64;
+    int lanes;
+
+    if (array->n_index == 0 || array->size <= 0)
+      continue;
+    data_pack_ubs = read_data_pack_sizes_array(sizes, array->name);
+    if (data_pack_ubs)
+      width = data_pack_ubs[2];
+    free(data_pack_ubs);
+    lanes = width / array->size;
+    if (lanes < 1)
+      lanes = 1;
+    if (max_lanes < 0 || lanes < max_lanes)
+      max_lanes = lanes;
+  }
+  isl_union_map_free(sizes);
+
+  return max_lanes;
+}
+
+/* Search the SIMD factor in the auto mode.
+ * Among the legal candidate loops, we select the loop and the factor that
+ * maximize the number of operations per cycle, i.e., #PE * SIMD, with the
+ * DSP usage within the hardware budget and the SIMD lanes within the 
+ * packed data width of the arrays (see max_simd_lanes). Loops with higher 
+ * scores are preferred on ties. 
+ * The tiling factors of the rest of the loops are set to zero.
+ */
+int *search_simd_tile_sizes(struct autosa_kernel *sa, int tile_len,
+                            int *ubs, int *legal, float *scores)
+{
+  struct autosa_hw_model hw;
+  int *tile_size;
+  double n_pe = 1;
+  int best_loop = -1, best_factor = 1;
+  int max_lanes;
+
+  load_hw_model(sa, &hw);
+  max_lanes = max_simd_lanes(sa);
+  for (int i = 0; i < sa->n_sa_dim; i++)
+    n_pe *= sa->sa_dim[i];
+
+  tile_size = isl_alloc_array(sa->ctx, int, tile_len);
+  for (int i = 0; i < tile_len; i++)
+  {
+    int n_factors;
+    int *factors;
+
+    tile_size[i] = 0;
+    if (!legal[i])
+      continue;
+    factors = get_tile_factors(sa, ubs[i], 2, 1, &n_factors);
+    for (int j = 0; j < n_factors; j++)
+    {
+      int f = factors[j];
+      if (n_pe * f * hw.dsp_per_op > hw.max_util * hw.dsp)
+        continue;
+      if (max_lanes > 0 && f > max_lanes)
+        continue;
+      if (f > best_factor ||
+          (f == best_factor && best_loop >= 0 && scores[i] > scores[best_loop]))
+      {
+        best_loop = i;
+        best_factor = f;
+      }
+    }
+    free(factors);
+  }
+
+  if (best_loop >= 0)
+  {
+    tile_size[best_loop] = best_factor;
+    if (sa->scop->options->autosa->verbose)
+      printf("[AutoSA] Auto SIMD vectorization: loop %d, factor %d\n",
+             best_loop, best_factor);
+  }
+
+  return tile_size;
+}
+
 /****************************************************************
  * AutoSA latency and resource estimation
  ****************************************************************/
@@ -2391,6 +3281,7 @@ static cJSON *extract_isl_ast_node_for(__isl_keep isl_ast_node *node, cJSON *loo
 
   /* Extract the loop info */
   isl_ast_expr *init, *cond, *inc, *iterator, *arg;
+  isl_id *id;
   init = isl_ast_node_for_get_init(node);
   cond = isl_ast_node_for_get_cond(node);
   inc = isl_ast_node_for_get_inc(node);
@@ -2449,6 +3340,17 @@ static cJSON *extract_isl_ast_node_for(__isl_keep isl_ast_node *node, cJSON *loo
   isl_ast_expr_free(cond);
   isl_ast_expr_free(inc);
 
+  /* The number of loops flattened into a single pipelined loop. */
+  id = isl_ast_node_get_annotation(node);
+  if (id)
+  {
+    struct autosa_ast_node_userinfo *info =
+        (struct autosa_ast_node_userinfo *)isl_id_get_user(id);
+    if (info && info->n_flatten_loop > 1)
+      cJSON_AddNumberToObject(loop_info, "flatten", info->n_flatten_loop);
+    isl_id_free(id);
+  }
+
   cJSON_AddItemToObject(loop, "loop_info", loop_info);
   cJSON_AddItemToObject(loop, "child", loop_child);
 
@@ -2637,14 +3539,81 @@ static cJSON *extract_loop_info_at_ast_node(__isl_keep isl_ast_node *node,
   return NULL;
 }
 
+/* Return the path of the design summary under the output directory.
+ */
+static char *design_summary_path(isl_ctx *ctx, struct autosa_options *options)
+{
+  isl_printer *p_str;
+  char *file_path;
+
+  p_str = isl_printer_to_str(ctx);
+  p_str = isl_printer_print_str(p_str, options->output_dir);
+  p_str = isl_printer_print_str(p_str, "/design_summary.ndjson");
+  file_path = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+
+  return file_path;
+}
+
+/* Create an empty design summary.
+ * The design summary collects the loop structures, the array information and 
+ * the design information used for latency and resource estimation in a single 
+ * file. Each record is printed as one line of minified JSON in the form of 
+ * {"type": type, "data": data}.
+ */
+isl_stat sa_design_summary_init(isl_ctx *ctx, struct autosa_options *options)
+{
+  char *file_path = design_summary_path(ctx, options);
+  FILE *fp = fopen(file_path, "w");
+  if (!fp)
+  {
+    printf("[AutoSA] Error: Cannot open file: %s\n", file_path);
+    exit(1);
+  }
+  free(file_path);
+  fclose(fp);
+
+  return isl_stat_ok;
+}
+
+/* Append the record of "type" with "data" to the design summary.
+ */
+static isl_stat design_summary_append(isl_ctx *ctx,
+  struct autosa_options *options, const char *type, cJSON *data)
+{
+  cJSON *record = cJSON_CreateObject();
+  char *file_path;
+  char *json_str;
+  FILE *fp;
+
+  cJSON_AddStringToObject(record, "type", type);
+  cJSON_AddItemReferenceToObject(record, "data", data);
+  json_str = cJSON_PrintUnformatted(record);
+  cJSON_Delete(record);
+
+  file_path = design_summary_path(ctx, options);
+  fp = fopen(file_path, "a");
+  if (!fp)
+  {
+    printf("[AutoSA] Error: Cannot open file: %s\n", file_path);
+    exit(1);
+  }
+  free(file_path);
+  fprintf(fp, "%s\n", json_str);
+  fclose(fp);
+  free(json_str);
+
+  return isl_stat_ok;
+}
+
 /* Extract the loop structure and detailed information of the hardware module into 
- * a JSON struct. If "print" is set, we will print out the JSON file. 
- * Otherwise, return it as a string.
+ * a JSON struct. If "print" is set, we will print out the JSON file, or append 
+ * it to the design summary if enabled. Otherwise, return it as a string.
  */
 static char *extract_loop_info_from_module(
     struct autosa_gen *gen, __isl_keep isl_ast_node *tree,
-    char *module_name, int double_buffer, int in,
-    int print)
+    char *module_name, int double_buffer, int in, int L3_buffer,
+    int reduce_tree_depth, int simd_w, int print)
 {
   if (!tree)
     return NULL;
@@ -2656,10 +3625,26 @@ static char *extract_loop_info_from_module(
   cJSON_AddStringToObject(loop_struct, "module_name", module_name);
   cJSON_AddNumberToObject(module_props, "double_buffer", double_buffer);  
   cJSON_AddNumberToObject(module_props, "in", in);
+  if (L3_buffer)
+    cJSON_AddNumberToObject(module_props, "L3_buffer", 1);
+  if (gen->options->autosa->loop_flatten)
+    cJSON_AddNumberToObject(module_props, "loop_flatten", 1);
+  if (reduce_tree_depth > 0)
+    cJSON_AddNumberToObject(module_props, "reduce_tree_depth", reduce_tree_depth);
+  if (simd_w > 0)
+    cJSON_AddNumberToObject(module_props, "simd", simd_w);
   cJSON_AddItemToObject(loop_struct, "module_prop", module_props);
   
   extract_loop_info_at_ast_node(tree, loop_struct);
 
+  if (print && gen->options->autosa->design_summary)
+  {
+    design_summary_append(gen->ctx, gen->options->autosa, "loop_info",
+                          loop_struct);
+    cJSON_Delete(loop_struct);
+    return NULL;
+  }
+
   /* Print the JSON file */
   json_str = cJSON_Print(loop_struct);
 
@@ -2700,6 +3685,25 @@ static char *extract_loop_info_from_module(
   }
 }
 
+/* Return 1 if "module" is the outermost I/O module holding the L3 buffer 
+ * allocated by the three-level buffering, i.e., the L2 buffer of its 
+ * group has been moved to the I/O module one level below.
+ */
+static int is_L3_buffer_module(struct autosa_hw_module *module)
+{
+  struct autosa_array_ref_group *group;
+
+  if (!module->options->autosa->three_level_buffer || module->type == PE_MODULE ||
+      !module->is_buffer || module->n_io_group == 0)
+    return 0;
+  group = module->io_groups[0];
+  if (group->io_level < 3 || module->level != group->io_level)
+    return 0;
+
+  return group->io_buffers[group->io_level - 1]->tile && 
+         group->io_buffers[group->io_level - 2]->tile;
+}
+
 /* Extract the loop structure and detailed information of the hardware module into 
  * a JSON struct.
  */
@@ -2708,35 +3712,42 @@ isl_stat sa_extract_loop_info(struct autosa_gen *gen, struct autosa_hw_module *m
   char *module_name = NULL;
   char *json_str = NULL;
   isl_ctx *ctx = gen->ctx;
+  /* The L3 buffer is filled once per L3 tile before it is forwarded. */
+  int L3_buffer = is_L3_buffer_module(module);
+  /* The depth of the SIMD reduction tree adds to the pipeline depth of the PEs. */
+  int reduce_tree_depth = module->type == PE_MODULE ? 
+      autosa_kernel_simd_reduce_tree_depth(module->kernel) : 0;
+  /* The SIMD width classifies the PE statements for latency calibration. */
+  int simd_w = module->type == PE_MODULE ? module->kernel->simd_w : 0;
 
   if (module->is_filter && module->is_buffer)
   {
     /* Parse the loop structure of the intra trans module */
     module_name = concat(ctx, module->name, "intra_trans");
-    json_str = extract_loop_info_from_module(gen, module->intra_tree, module_name, module->double_buffer, module->in, 1);
+    json_str = extract_loop_info_from_module(gen, module->intra_tree, module_name, module->double_buffer, module->in, L3_buffer, 0, 0, 1);
     free(module_name);
 
     /* Parse the loop structure of the inter trans module */
     module_name = concat(ctx, module->name, "inter_trans");
-    json_str = extract_loop_info_from_module(gen, module->inter_tree, module_name, module->double_buffer, module->in, 1);
+    json_str = extract_loop_info_from_module(gen, module->inter_tree, module_name, module->double_buffer, module->in, L3_buffer, 0, 0, 1);
     free(module_name);
 
     if (module->boundary)
     {
       module_name = concat(ctx, module->name, "inter_trans_boundary");
-      json_str = extract_loop_info_from_module(gen, module->boundary_inter_tree, module_name, module->double_buffer, module->in, 1);
+      json_str = extract_loop_info_from_module(gen, module->boundary_inter_tree, module_name, module->double_buffer, module->in, L3_buffer, 0, 0, 1);
       free(module_name);
     }
   }
 
   /* Parse the loop structure of the default module */
-  json_str = extract_loop_info_from_module(gen, module->device_tree, module->name, module->double_buffer, module->in, 1);
+  json_str = extract_loop_info_from_module(gen, module->device_tree, module->name, module->double_buffer, module->in, L3_buffer, reduce_tree_depth, simd_w, 1);
 
   /* Parse the loop structure of the boundary module */
   if (module->boundary)
   {
     module_name = concat(ctx, module->name, "boundary");
-    json_str = extract_loop_info_from_module(gen, module->boundary_tree, module_name, module->double_buffer, module->in, 1);
+    json_str = extract_loop_info_from_module(gen, module->boundary_tree, module_name, module->double_buffer, module->in, L3_buffer, reduce_tree_depth, simd_w, 1);
     free(module_name);
   }
 
@@ -2754,7 +3765,7 @@ isl_stat sa_extract_loop_info(struct autosa_gen *gen, struct autosa_hw_module *m
       p_str = isl_printer_print_str(p_str, "_PE_dummy");
       module_name = isl_printer_get_str(p_str);
       isl_printer_free(p_str);
-      json_str = extract_loop_info_from_module(gen, dummy_module->device_tree, module_name, 0, 0, 1);
+      json_str = extract_loop_info_from_module(gen, dummy_module->device_tree, module_name, 0, 0, 0, 0, 0, 1);
       free(module_name);
     }
   }
@@ -2788,6 +3799,14 @@ isl_stat sa_extract_array_info(struct autosa_kernel *kernel)
     cJSON_AddItemToObject(array_info, array_name, array);
   }
 
+  if (kernel->options->autosa->design_summary)
+  {
+    design_summary_append(kernel->ctx, kernel->options->autosa, "array_info",
+                          array_info);
+    cJSON_Delete(array_info);
+    return isl_stat_ok;
+  }
+
   /* Print out the JSON */
   json_str = cJSON_Print(array_info);
   p_str = isl_printer_to_str(kernel->ctx);
@@ -2820,6 +3839,8 @@ isl_stat sa_extract_array_info(struct autosa_kernel *kernel)
  * - If the buffer uses primitive type (n_lane == 1) and #ele <= 32, use FF
  * - Otherwise, use BRAM
  * Otherwise:
+ * - If the module holds the L3 buffer of the three-level buffering, use URAM,
+ *   for which the L3 tile is sized.
  * - If the module is connected to DRAM, use URAM if URAM is allowed, otherwise
  *   use BRAM.
  * - Otherwise, if memory util > 0.2 use BRAM, else use LUTRAM.
@@ -2874,7 +3895,9 @@ int extract_memory_type(struct autosa_hw_module *module,
   //  }
   //}
   
-  if (module->type != PE_MODULE && module->to_mem == 1) {
+  if (is_L3_buffer_module(module)) {
+    use_memory = 3;
+  } else if (module->type != PE_MODULE && module->to_mem == 1) {
     if (uram)
       use_memory = 3;
     else
@@ -2975,6 +3998,25 @@ static cJSON *extract_design_info_from_module(struct autosa_gen *gen,
     cJSON *fifo_lanes = cJSON_CreateIntArray(fifo_lanes_num, module->n_io_group);
     cJSON_AddItemToObject(info, "fifo_lanes", fifo_lanes);
     free(fifo_lanes_num);
+
+    /* Extract the distinct data types accessed by the PE */
+    cJSON *ele_types = cJSON_CreateArray();
+    for (int i = 0; i < module->n_io_group; i++)
+    {
+      char *type = module->io_groups[i]->array->type;
+      int found = 0;
+      for (int j = 0; j < i; j++)
+      {
+        if (!strcmp(module->io_groups[j]->array->type, type))
+        {
+          found = 1;
+          break;
+        }
+      }
+      if (!found)
+        cJSON_AddItemToArray(ele_types, cJSON_CreateString(type));
+    }
+    cJSON_AddItemToObject(info, "ele_types", ele_types);
   }
   else
   {
@@ -3081,6 +4123,10 @@ isl_stat sa_extract_design_info(struct autosa_gen *gen)
   cJSON *kernel_id = cJSON_CreateNumber(gen->kernel->id);
   cJSON_AddItemToObject(design_info, "kernel_id", kernel_id);
 
+  /* PE utilization */
+  if (gen->kernel->pe_util >= 0)
+    cJSON_AddNumberToObject(design_info, "pe_utilization", gen->kernel->pe_util);
+
   /* module */
   cJSON *modules = cJSON_CreateObject();
   cJSON_AddItemToObject(design_info, "modules", modules);
@@ -3173,6 +4219,14 @@ isl_stat sa_extract_design_info(struct autosa_gen *gen)
     }
   }
 
+  if (gen->options->autosa->design_summary)
+  {
+    design_summary_append(gen->ctx, gen->options->autosa, "design_info",
+                          design_info);
+    cJSON_Delete(design_info);
+    return isl_stat_ok;
+  }
+
   json_str = cJSON_Print(design_info);
   p_str = isl_printer_to_str(gen->ctx);
   p_str = isl_printer_print_str(p_str, gen->options->autosa->output_dir);
@@ -141,6 +141,43 @@ struct autosa_dep
   isl_set *dest_sched_domain;
 };
 
+/* A cached dependence distance table entry.
+ * "sched" is the partial schedule of a band node with the subtree 
+ * contraction applied.
+ * "dis[i]" is the distance vector of the i-th dependence in the table 
+ * under "sched". It is only valid if "computed[i]" is set. It is NULL if 
+ * the dependence is not scheduled by "sched" or the distance is not uniform.
+ */
+struct autosa_dep_dis_entry
+{
+  isl_multi_union_pw_aff *sched;
+  int n_dep;
+  isl_vec **dis;
+  int *computed;
+};
+
+/* Memoized dependence distance vectors, shared by all the passes that 
+ * work on the same scop.
+ * "deps" contains the untagged dependences that have been queried.
+ * "entries" contains one entry for each distinct band partial schedule.
+ * Entries are matched by the schedules of the band members, regardless 
+ * of their order. Loop interchange and band splitting therefore reuse 
+ * the cached results, while tiling or skewing introduces new band members 
+ * and hence a new entry.
+ */
+struct autosa_dep_dis_table
+{
+  isl_ctx *ctx;
+  int n_dep;
+  isl_basic_map **deps;
+  int n_entry;
+  struct autosa_dep_dis_entry **entries;
+
+  /* Statistics */
+  int n_hit;
+  int n_miss;
+};
+
 /* A sequence of "n" names of types.
  */
 struct autosa_types
@@ -189,11 +226,22 @@ struct autosa_kernel
   int space_w;
   int time_w;
   int simd_w;
+  /* Is the SIMD loop a reduction loop? */
+  int simd_reduction;
   int lat_hide_len;
 
   int type; // AUTOSA_SA_TYPE_ASYNC | AUTOSA_SA_TYPE_SYNC
 
   isl_multi_pw_aff *sa_grid_size;
+  /* The PE identifiers (as parameters) of the PEs that execute at least one 
+   * statement instance. It is a subset of the grid bounded by "sa_grid_size", 
+   * e.g., a triangle for LU-class kernels.
+   */
+  isl_set *pe_active;
+  /* Ratio between the number of active PEs and the size of the PE grid. 
+   * -1 if unknown. 
+   */
+  double pe_util;
   /* User specified (array_part/latency_hiding/simd) sizes for each kernel. */
   isl_union_map *sizes;
   /* Effectively used (array_part/latency_hiding/simd) sizes for each kernel. */
@@ -875,6 +923,9 @@ struct autosa_gen
 
   /* The default schedule */
   isl_schedule *schedule;
+  /* Alternative schedules explored in the space-time transformation */
+  isl_schedule **alt_schedules;
+  int n_alt_schedules;
 
   /* The SA module schedule */
   struct autosa_hw_module **hw_modules;
@@ -1004,6 +1055,9 @@ struct autosa_kernel_stmt
     {
       struct autosa_drain_merge_func *func;
       isl_ast_expr *index;
+      /* The iterator of the loop along which consecutive elements 
+       * are copied, NULL if there is no such loop. */
+      char *contiguous_iter;
     } dm;
     struct
     {
@@ -1043,6 +1097,8 @@ struct autosa_ast_node_userinfo
   int is_first_infinitizable_loop;
   int is_dep_free;  
   int n_coalesce_loop;
+  /* Number of loops flattened into this loop. */
+  int n_flatten_loop;
   /* Temporary variable used in AST traversal. */
   bool visited;
   /* Variables for Catapult codegen. */
@@ -1144,6 +1200,9 @@ __isl_give isl_vec *get_dep_dis_at_node(__isl_keep isl_basic_map *dep,
 //    __isl_take isl_schedule_node *node, isl_size level1, isl_size level2);
 __isl_give isl_schedule_node *loop_interchange_at_node(
     __isl_take isl_schedule_node *node, isl_size level1, isl_size level2);
+__isl_give isl_schedule_node *loop_skewing_at_node(
+    __isl_take isl_schedule_node *node, isl_size level, isl_size src_level,
+    int factor, int coincident);
 __isl_give isl_schedule_node *get_outermost_permutable_node(
     __isl_keep isl_schedule *schedule);
 __isl_give isl_schedule_node *get_innermost_permutable_node(
@@ -1169,6 +1228,7 @@ isl_bool isl_schedule_node_is_io_mark(__isl_keep isl_schedule_node *node, int io
 int is_node_under_simd(__isl_keep isl_schedule_node *node);
 int is_node_under_latency(__isl_keep isl_schedule_node *node);
 int *extract_band_upper_bounds(__isl_keep isl_schedule_node *node);
+double extract_band_inner_volume(__isl_keep isl_schedule_node *node);
 __isl_give isl_union_set *set_schedule_eq(
     __isl_keep isl_schedule_node *node, __isl_keep isl_id_list *names);
 __isl_give isl_union_set *set_schedule_neq(
@@ -1180,7 +1240,8 @@ __isl_give isl_schedule_node *sched_pos_setup(__isl_take isl_schedule_node *node
 int get_band_single_schedule_val(__isl_keep isl_schedule_node *node);
 int get_last_sched_dim_val(__isl_keep isl_schedule_node *node);
 __isl_give isl_schedule_node *autosa_atomic_ancestors(__isl_take isl_schedule_node *node);
-int is_dep_carried_by_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *node);
+int is_dep_carried_by_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *node,
+                           struct ppcg_scop *scop);
 __isl_give isl_schedule_node *autosa_node_sink_to_depth(__isl_take isl_schedule_node *node, int depth);
 __isl_give isl_schedule_node *autosa_node_sink_to_mark(__isl_take isl_schedule_node *node, const char *name);
 int is_marked(__isl_keep isl_schedule_node *node, const char *name);
@@ -1188,6 +1249,8 @@ int is_marked(__isl_keep isl_schedule_node *node, const char *name);
 /* Schedule */
 __isl_give isl_schedule *compute_schedule(struct autosa_gen *gen);
 __isl_give isl_schedule *get_schedule(struct autosa_gen *gen);
+isl_schedule **explore_schedules(struct autosa_gen *gen, int *n_schedule);
+__isl_give isl_schedule *hybrid_tile_outer_bands(__isl_take isl_schedule *schedule, struct autosa_gen *gen);
 __isl_give isl_schedule *merge_outer_bands(__isl_give isl_schedule *schedule, struct autosa_gen *gen);
 
 /* AutoSA kernel */
@@ -1204,6 +1267,12 @@ struct autosa_io_buffer *autosa_io_buffer_alloc();
 
 /* AutoSA dep */
 void *autosa_dep_free(__isl_take struct autosa_dep *dep);
+struct autosa_dep_dis_table *autosa_dep_dis_table_alloc(isl_ctx *ctx);
+void *autosa_dep_dis_table_free(struct autosa_dep_dis_table *table);
+__isl_give isl_vec *autosa_dep_dis_table_get(struct autosa_dep_dis_table *table,
+                                             __isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *band);
+__isl_give isl_vec *autosa_get_dep_dis_at_node(struct ppcg_scop *scop,
+                                               __isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *band);
 
 /* AutoSA iterator */
 struct autosa_iter *autosa_iter_free(struct autosa_iter *iter);
@@ -1226,6 +1295,10 @@ struct autosa_stmt *extract_stmts(isl_ctx *ctx, struct ppcg_scop *scop,
                                   __isl_keep isl_union_map *any_to_outer);
 void autosa_kernel_stmt_free(void *user);
 struct autosa_stmt *find_stmt(struct autosa_prog *prog, __isl_keep isl_id *id);
+int autosa_kernel_simd_reduce_tree_depth(struct autosa_kernel *kernel);
+isl_bool autosa_stmt_is_reduction(struct autosa_stmt *stmt,
+                                  __isl_give isl_id **write_ref, __isl_give isl_id **read_ref,
+                                  char **op);
 
 /* AutoSA prog */
 struct autosa_prog *autosa_prog_alloc(isl_ctx *ctx, struct ppcg_scop *scop);
@@ -1259,11 +1332,24 @@ int *read_default_simd_tile_sizes(struct autosa_kernel *kernel, int tile_len);
 int read_space_time_kernel_id(__isl_keep isl_union_map *sizes);
 int *read_array_part_L2_tile_sizes(struct autosa_kernel *kernel, int tile_len);
 int *read_default_array_part_L2_tile_sizes(struct autosa_kernel *kernel, int tile_len);
+int *read_array_part_L3_tile_sizes(struct autosa_kernel *kernel, int tile_len);
+int *search_array_part_tile_sizes(struct autosa_kernel *sa,
+                                  __isl_keep isl_schedule_node *node);
+int *search_array_part_L3_tile_sizes(struct autosa_kernel *sa,
+                                     __isl_keep isl_schedule_node *node);
+int *search_latency_tile_sizes(struct autosa_kernel *sa, int tile_len,
+                               int *ubs, int *is_space);
+int *search_simd_tile_sizes(struct autosa_kernel *sa, int tile_len,
+                            int *ubs, int *legal, float *scores);
 int *read_data_pack_sizes(__isl_keep isl_union_map *sizes, int tile_len);
 int *read_data_pack_sizes_array(__isl_keep isl_union_map *sizes, char *name);
 int read_mem_port_map(__isl_keep isl_union_map *port_map, char *name);
+int autosa_array_get_mem_port_base(struct autosa_kernel *kernel,
+                                   struct autosa_array_info *array,
+                                   char *mem_port_map);
 
 /* AutoSA latency and resource estimation */
+isl_stat sa_design_summary_init(isl_ctx *ctx, struct autosa_options *options);
 isl_stat sa_extract_loop_info(struct autosa_gen *gen, struct autosa_hw_module *module);
 isl_stat sa_extract_array_info(struct autosa_kernel *kernel);
 int extract_memory_type(struct autosa_hw_module *module,
@@ -49,6 +49,9 @@ static void print_intel_host_header(FILE *fp)
   fprintf(fp, "#endif\n");
   fprintf(fp, "#include <CL/opencl.h>\n");
   //fprintf(fp, "#include <CL/cl_ext_intelfpga.h>\n");
+  fprintf(fp, "#ifndef CL_MEM_HETEROGENEOUS_INTELFPGA\n");
+  fprintf(fp, "#define CL_MEM_HETEROGENEOUS_INTELFPGA (1 << 19)\n");
+  fprintf(fp, "#endif\n");
   fprintf(fp, "#include <chrono>\n");
   fprintf(fp, "#include \"AOCLUtils/aocl_utils.h\"\n\n");
 
@@ -763,6 +766,10 @@ static __isl_give isl_printer *find_device_intel(__isl_take isl_printer *p,
 
   p = print_str_new_line(p, "cl_kernel kernel[NUM_KERNELS_TO_CREATE];");
   p = print_str_new_line(p, "cl_command_queue cmdQueue[NUM_QUEUES_TO_CREATE];");
+  p = print_str_new_line(p, "std::vector<std::string> kernel_name(NUM_KERNELS_TO_CREATE);");
+  p = print_str_new_line(p, "std::vector<cl_event> kernel_event(NUM_KERNELS_TO_CREATE, NULL);");
+  p = print_str_new_line(p, "std::vector<double> kernel_time(NUM_KERNELS_TO_CREATE, 0);");
+  p = print_str_new_line(p, "std::vector<cl_event> write_event;");
 
   p = isl_printer_end_line(p);
 //  p = print_str_new_line(p, "// Parse command line arguments");
@@ -1033,6 +1040,27 @@ static __isl_give isl_printer *find_device_intel(__isl_take isl_printer *p,
       p = isl_printer_print_str(p, "\", &status);");
       p = isl_printer_end_line(p);
       p = print_str_new_line(p, "CHECK(status);");
+
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, "kernel_name[ID_");
+      p = isl_printer_print_str(p, module->name);
+      p = isl_printer_print_str(p, "_base");
+      if (group->n_mem_ports > 1)
+      {
+        p = isl_printer_print_str(p, " + ");
+        p = isl_printer_print_int(p, j);
+      }
+      p = isl_printer_print_str(p, "] = \"");
+      p = isl_printer_print_str(p, module->name);
+      if (module->is_serialized)
+        p = isl_printer_print_str(p, "_serialize");
+      if (group->n_mem_ports > 1)
+      {
+        p = isl_printer_print_str(p, "_");
+        p = isl_printer_print_int(p, j);
+      }
+      p = isl_printer_print_str(p, "\";");
+      p = isl_printer_end_line(p);
       k_id++;
     }
   }
@@ -1040,6 +1068,101 @@ static __isl_give isl_printer *find_device_intel(__isl_take isl_printer *p,
   return p;
 }
 
+/* Return 1 if the device buffers are placed on specific memory banks
+ * through the "buffer_location" attributes of the kernel arguments.
+ * Such buffers are allocated with CL_MEM_HETEROGENEOUS_INTELFPGA and only
+ * get a physical location once bound to a kernel argument.
+ */
+static int intel_use_heterogeneous_memory(struct autosa_prog *prog)
+{
+  return prog->scop->options->autosa->hbm ||
+         prog->scop->options->autosa->mem_port_map != NULL;
+}
+
+/* Set the kernel arguments that stay unchanged across kernel invocations,
+ * i.e., the parameters and the device buffers, right after the buffers
+ * are allocated. Only the host iterators are set again at each invocation
+ * (see autosa_kernel_print_set_ext_module_args).
+ * This also binds the buffers allocated with CL_MEM_HETEROGENEOUS_INTELFPGA
+ * to their memory banks before any host data is written to them.
+ */
+static __isl_give isl_printer *print_set_const_kernel_args_intel(
+    __isl_take isl_printer *p, struct autosa_kernel *kernel,
+    struct autosa_hw_top_module *top)
+{
+  isl_space *space;
+  int nparam;
+  int n_host_iter;
+
+  space = isl_union_set_get_space(kernel->arrays);
+  nparam = isl_space_dim(space, isl_dim_param);
+  n_host_iter = isl_space_dim(kernel->space, isl_dim_set);
+
+  p = print_str_new_line(p, "// Set the kernel arguments unchanged across invocations");
+  for (int i = 0; i < top->n_hw_modules; i++)
+  {
+    struct autosa_hw_module *module = top->hw_modules[i];
+    struct autosa_array_ref_group *group;
+    if (module->type == PE_MODULE || module->to_mem == 0)
+      continue;
+    group = module->io_groups[0];
+
+    for (int j = 0; j < group->n_mem_ports; j++)
+    {
+      isl_printer *p_str;
+      char *kernel_id;
+
+      p_str = isl_printer_to_str(kernel->ctx);
+      p_str = isl_printer_print_str(p_str, "kernel[ID_");
+      p_str = isl_printer_print_str(p_str, module->name);
+      p_str = isl_printer_print_str(p_str, "_base");
+      if (group->n_mem_ports > 1)
+      {
+        p_str = isl_printer_print_str(p_str, " + ");
+        p_str = isl_printer_print_int(p_str, j);
+      }
+      p_str = isl_printer_print_str(p_str, "]");
+      kernel_id = isl_printer_get_str(p_str);
+      isl_printer_free(p_str);
+
+      /* Params */
+      for (int k = 0; k < nparam; k++)
+      {
+        p = isl_printer_start_line(p);
+        p = isl_printer_print_str(p, "status = clSetKernelArg(");
+        p = isl_printer_print_str(p, kernel_id);
+        p = isl_printer_print_str(p, ", ");
+        p = isl_printer_print_int(p, k);
+        p = isl_printer_print_str(p, ", sizeof(unsigned int), (void *)&");
+        p = isl_printer_print_str(p, isl_space_get_dim_name(space, isl_dim_param, k));
+        p = isl_printer_print_str(p, "); CHECK(status);");
+        p = isl_printer_end_line(p);
+      }
+
+      /* Arrays. The buffers are allocated per memory port, shared by the
+       * copy-in and copy-out modules of the same group.
+       */
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, "status = clSetKernelArg(");
+      p = isl_printer_print_str(p, kernel_id);
+      p = isl_printer_print_str(p, ", ");
+      p = isl_printer_print_int(p, nparam + n_host_iter);
+      p = isl_printer_print_str(p, ", sizeof(cl_mem), (void *)&buffer_");
+      p = isl_printer_print_str(p, group->array->name);
+      p = isl_printer_print_str(p, "[");
+      p = isl_printer_print_int(p, group->mem_port_id + j);
+      p = isl_printer_print_str(p, "]); CHECK(status);");
+      p = isl_printer_end_line(p);
+
+      free(kernel_id);
+    }
+  }
+  isl_space_free(space);
+  p = isl_printer_end_line(p);
+
+  return p;
+}
+
 static __isl_give isl_printer *declare_and_allocate_device_arrays_intel(
     __isl_take isl_printer *p, struct autosa_prog *prog,
     struct autosa_kernel *kernel, struct autosa_hw_top_module *top)
@@ -1269,7 +1392,11 @@ static __isl_give isl_printer *declare_and_allocate_device_arrays_intel(
         p = isl_printer_print_str(p, module->in? "host_serialize_" : "host_deserialize_");
         p = isl_printer_print_str(p, local_array->array->name);            
         p = isl_printer_print_str(p, "(");
-        p = print_host_serialize_arguments(p, kernel, group, module, 0, 0);  // TODO: add hbm support later.
+        /* Host serialization requires one I/O group per array and is
+         * rejected together with HBM (see sa_io_construct_optimize),
+         * so a serialized array never spans multiple memory ports.
+         */
+        p = print_host_serialize_arguments(p, kernel, group, module, 0, 0);
         p = isl_printer_print_str(p, ");");
         p = isl_printer_end_line(p);
   
@@ -1338,6 +1465,8 @@ static __isl_give isl_printer *declare_and_allocate_device_arrays_intel(
       else if (local_array->array->copy_out)
         p = isl_printer_print_str(p, "CL_MEM_WRITE_ONLY");
     }
+    if (intel_use_heterogeneous_memory(prog))
+      p = isl_printer_print_str(p, " | CL_MEM_HETEROGENEOUS_INTELFPGA");
     p = isl_printer_print_str(p, ",");
     p = isl_printer_end_line(p);
     p = isl_printer_start_line(p);
@@ -1374,6 +1503,8 @@ static __isl_give isl_printer *declare_and_allocate_device_arrays_intel(
   }
   p = isl_printer_end_line(p);
 
+  p = print_set_const_kernel_args_intel(p, kernel, top);
+
   /* Insert profiling information. */
   p = print_str_new_line(p, "auto host_begin = std::chrono::high_resolution_clock::now();");
   p = print_str_new_line(p, "auto fpga_begin = std::chrono::high_resolution_clock::now();");
@@ -1423,6 +1554,11 @@ static __isl_give isl_printer *clear_device_intel(__isl_take isl_printer *p,
   p = print_str_new_line(p, "std::cout << \"FPGA Time: \" << fpga_duration.count() << \" s\" << std::endl;");
   p = print_str_new_line(p, "std::chrono::duration<double> host_duration = host_end - host_begin;");
   p = print_str_new_line(p, "std::cout << \"Host Time: \" << host_duration.count() << \" s\" << std::endl;");
+  p = print_str_new_line(p, "for (int i = 0; i < NUM_KERNELS_TO_CREATE; i++) {");
+  p = isl_printer_indent(p, 2);
+  p = print_str_new_line(p, "std::cout << \"Kernel \" << kernel_name[i] << \" Time: \" << kernel_time[i] << \" s\" << std::endl;");
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
   p = isl_printer_end_line(p);
 
   /* Deserialize the buffer data if necessary. */
@@ -1435,7 +1571,7 @@ static __isl_give isl_printer *clear_device_intel(__isl_take isl_printer *p,
       p = isl_printer_print_str(p, "host_deserialize_");
       p = isl_printer_print_str(p, local_array->array->name);
       p = isl_printer_print_str(p, "(");      
-      p = print_host_serialize_arguments(p, top->kernel, group, module, 0, 0);  // TODO: add hbm support later.
+      p = print_host_serialize_arguments(p, top->kernel, group, module, 0, 0);
       p = isl_printer_print_str(p, ");");      
       p = isl_printer_end_line(p);
     }
@@ -1540,6 +1676,8 @@ static __isl_give isl_printer *drain_merge_intel(
  * in its entirety.  The bounds on the extent of "array" have
  * been precomputed in extract_array_info and are used in
  * gpu_array_info_print_size.
+ * The writes are non-blocking and spread over the command queues. Their
+ * events are collected in "write_event", on which the kernel launches wait.
  */
 static __isl_give isl_printer *copy_array_to_device_intel(__isl_take isl_printer *p,
                                                           struct autosa_array_info *array)
@@ -1555,18 +1693,19 @@ static __isl_give isl_printer *copy_array_to_device_intel(__isl_take isl_printer
   p = isl_printer_end_line(p);
   p = isl_printer_indent(p, 2);
 
+  p = print_str_new_line(p, "cl_event event;");
   p = print_str_new_line(p, "status = clEnqueueWriteBuffer(");
   indent = strlen("status = clEnqueueWriteBuffer(");
   p = isl_printer_indent(p, indent);
   p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "cmdQueue[0],");
+  p = isl_printer_print_str(p, "cmdQueue[i % NUM_QUEUES_TO_CREATE],");
   p = isl_printer_end_line(p);
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "buffer_");
   p = isl_printer_print_str(p, array->name);
   p = isl_printer_print_str(p, "[i],");
   p = isl_printer_end_line(p);
-  p = print_str_new_line(p, "CL_TRUE,");
+  p = print_str_new_line(p, "CL_FALSE,");
   p = print_str_new_line(p, "0,");
   p = isl_printer_start_line(p);
   if (local_array->host_serialize) {
@@ -1587,8 +1726,9 @@ static __isl_give isl_printer *copy_array_to_device_intel(__isl_take isl_printer
   p = isl_printer_end_line(p);
   p = print_str_new_line(p, "0,");
   p = print_str_new_line(p, "NULL,");
-  p = print_str_new_line(p, "NULL); CHECK(status);");
+  p = print_str_new_line(p, "&event); CHECK(status);");
   p = isl_printer_indent(p, -indent);
+  p = print_str_new_line(p, "write_event.push_back(event);");
 
   p = isl_printer_indent(p, -2);
   p = print_str_new_line(p, "}");
@@ -1612,7 +1752,7 @@ static __isl_give isl_printer *copy_array_from_device_intel(
   p = print_str_new_line(p, "// Read the results back from the device");
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "for (int i = 0; i < ");
-  p = isl_printer_print_int(p, local_array->n_io_group_refs);
+  p = isl_printer_print_int(p, local_array->n_mem_ports);
   p = isl_printer_print_str(p, "; i++) {");
   p = isl_printer_end_line(p);
   p = isl_printer_indent(p, 2);
@@ -1734,6 +1874,9 @@ static __isl_give isl_printer *print_device_node_intel(__isl_take isl_printer *p
  * 
  * We will ignore the fifos since for Intel OpenCL designs will replace these 
  * fifos later with channels.
+ * The parameters and arrays are set once after the device buffers are
+ * allocated (see print_set_const_kernel_args_intel). Only the host loop
+ * iterators, which change across kernel invocations, are set here.
  */
 static __isl_give isl_printer *autosa_kernel_print_set_ext_module_args(
     __isl_take isl_printer *p,
@@ -1757,92 +1900,15 @@ static __isl_give isl_printer *autosa_kernel_print_set_ext_module_args(
   if (!(complete || upper))
     return p;
 
-  /* Module identifiers */
-  if (!dummy)
-  {
-    for (int i = 0; i < isl_id_list_n_id(module->inst_ids); i++)
-    {
-      p = print_str_new_line(p, "status = clSetKernelArg(");
-      p = isl_printer_indent(p, 2);
-
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "kernel[ID_");
-      p = isl_printer_print_str(p, module_name);
-      p = isl_printer_print_str(p, "_base");
-      if (module->io_groups[0]->n_mem_ports > 1)
-      {
-        p = isl_printer_print_str(p, " + c0");
-      }
-      p = isl_printer_print_str(p, "],");
-      p = isl_printer_end_line(p);
-
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_int(p, n_arg);
-      p = isl_printer_print_str(p, ",");
-      p = isl_printer_end_line(p);
-      n_arg++;
-
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "sizeof(unsigned int),");
-      p = isl_printer_end_line(p);
-
-      p = isl_printer_start_line(p);
-      p = isl_printer_print_str(p, "(void *)&c");
-      p = isl_printer_print_int(p, i);
-      p = isl_printer_print_str(p, ");");
-      p = isl_printer_end_line(p);
-
-      p = isl_printer_indent(p, -2);
-      p = print_str_new_line(p, "CHECK(status);");
-    }
-  }
-  else
-  {
-    /* Dummy modules will never be instantiated at the host code. */
-  }
+  /* Module identifiers are plugged into the kernel body by codegen.py
+   * and removed from the kernel arguments. The instance "c0" of a
+   * multi-port module selects its kernel instead.
+   */
 
-  /* Params */
+  /* Host iters */
   space = isl_union_set_get_space(module->kernel->arrays);
-  n = isl_space_dim(space, isl_dim_param);
+  n_arg = isl_space_dim(space, isl_dim_param);
   isl_space_free(space);
-  for (int i = 0; i < n; i++)
-  {
-    const char *name = isl_space_get_dim_name(space, isl_dim_set, i);
-    p = print_str_new_line(p, "status = clSetKernelArg(");
-    p = isl_printer_indent(p, 2);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "kernel[ID_");
-    p = isl_printer_print_str(p, module_name);
-    p = isl_printer_print_str(p, "_base");
-    if (module->io_groups[0]->n_mem_ports > 1)
-    {
-      p = isl_printer_print_str(p, " + c0");
-    }
-    p = isl_printer_print_str(p, "],");
-    p = isl_printer_end_line(p);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_int(p, n_arg);
-    p = isl_printer_print_str(p, ",");
-    p = isl_printer_end_line(p);
-    n_arg++;
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "sizeof(unsigned int),");
-    p = isl_printer_end_line(p);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "(void *)&");
-    p = isl_printer_print_str(p, name);
-    p = isl_printer_print_str(p, ");");
-    p = isl_printer_end_line(p);
-
-    p = isl_printer_indent(p, -2);
-    p = print_str_new_line(p, "CHECK(status);");
-  }
-
-  /* Host iters */
   n = isl_space_dim(module->kernel->space, isl_dim_set);
   for (int i = 0; i < n; i++)
   {
@@ -1881,55 +1947,6 @@ static __isl_give isl_printer *autosa_kernel_print_set_ext_module_args(
     p = print_str_new_line(p, "CHECK(status);");
   }
 
-  /* Scalars and arrays */
-  if (module->type != PE_MODULE && module->to_mem)
-  {
-    struct autosa_local_array_info *local_array = module->io_groups[0]->local_array;
-    /* IO modules will not contain any scalar inputs. */
-    p = print_str_new_line(p, "status = clSetKernelArg(");
-    p = isl_printer_indent(p, 2);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "kernel[ID_");
-    p = isl_printer_print_str(p, module_name);
-    p = isl_printer_print_str(p, "_base");
-    if (module->io_groups[0]->n_mem_ports > 1)
-    {
-      p = isl_printer_print_str(p, " + c0");
-    }
-    p = isl_printer_print_str(p, "],");
-    p = isl_printer_end_line(p);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_int(p, n_arg);
-    p = isl_printer_print_str(p, ",");
-    p = isl_printer_end_line(p);
-    n_arg++;
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "sizeof(cl_mem),");
-    p = isl_printer_end_line(p);
-
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "(void *)&buffer_");
-    p = isl_printer_print_str(p, local_array->array->name);
-    p = isl_printer_print_str(p, "[");
-    if (module->io_groups[0]->n_mem_ports == 1)
-    {
-      p = isl_printer_print_int(p, module->n_array_ref);
-    }
-    else
-    {
-      p = isl_printer_print_str(p, "c0 + ");
-      p = isl_printer_print_int(p, module->n_array_ref);
-    }
-    p = isl_printer_print_str(p, "]);");
-    p = isl_printer_end_line(p);
-
-    p = isl_printer_indent(p, -2);
-    p = print_str_new_line(p, "CHECK(status);");
-  }
-
   return p;
 }
 
@@ -1957,6 +1974,60 @@ static __isl_give isl_printer *print_set_ext_module_args_stmt(
   return p;
 }
 
+/* Print the code that waits for the kernel event at index "id", accumulates
+ * its execution time to "kernel_time" and releases the event.
+ */
+static __isl_give isl_printer *print_collect_kernel_event(
+    __isl_take isl_printer *p, const char *id)
+{
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "if (kernel_event[");
+  p = isl_printer_print_str(p, id);
+  p = isl_printer_print_str(p, "] != NULL) {");
+  p = isl_printer_end_line(p);
+  p = isl_printer_indent(p, 2);
+  p = print_str_new_line(p, "cl_ulong start, end;");
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "status = clWaitForEvents(1, &kernel_event[");
+  p = isl_printer_print_str(p, id);
+  p = isl_printer_print_str(p, "]); CHECK(status);");
+  p = isl_printer_end_line(p);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "status = clGetEventProfilingInfo(kernel_event[");
+  p = isl_printer_print_str(p, id);
+  p = isl_printer_print_str(p, "], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL); CHECK(status);");
+  p = isl_printer_end_line(p);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "status = clGetEventProfilingInfo(kernel_event[");
+  p = isl_printer_print_str(p, id);
+  p = isl_printer_print_str(p, "], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL); CHECK(status);");
+  p = isl_printer_end_line(p);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "kernel_time[");
+  p = isl_printer_print_str(p, id);
+  p = isl_printer_print_str(p, "] += (end - start) * 1e-9;");
+  p = isl_printer_end_line(p);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "clReleaseEvent(kernel_event[");
+  p = isl_printer_print_str(p, id);
+  p = isl_printer_print_str(p, "]);");
+  p = isl_printer_end_line(p);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "kernel_event[");
+  p = isl_printer_print_str(p, id);
+  p = isl_printer_print_str(p, "] = NULL;");
+  p = isl_printer_end_line(p);
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+
+  return p;
+}
+
+/* Print the enqueue of the kernel of the external module in "stmt".
+ * The launch may sit inside host loops, in which case the event slot of
+ * the kernel still holds the event of the previous launch. This event is
+ * collected and released before the slot is reused.
+ */
 static __isl_give isl_printer *autosa_kernel_print_launch_ext_module_kernels(
     __isl_take isl_printer *p,
     struct autosa_kernel_stmt *stmt, struct autosa_prog *prog)
@@ -1975,10 +2046,25 @@ static __isl_give isl_printer *autosa_kernel_print_launch_ext_module_kernels(
   int nparams;
   int n;
   const char *type;
+  isl_printer *p_str;
+  char *kernel_id;
 
   if (!(complete || upper))
     return p;
 
+  p_str = isl_printer_to_str(isl_printer_get_ctx(p));
+  p_str = isl_printer_print_str(p_str, "ID_");
+  p_str = isl_printer_print_str(p_str, module_name);
+  p_str = isl_printer_print_str(p_str, "_base");
+  if (module->io_groups[0]->n_mem_ports > 1)
+  {
+    p_str = isl_printer_print_str(p_str, " + c0");
+  }
+  kernel_id = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+
+  p = print_collect_kernel_event(p, kernel_id);
+
   p = print_str_new_line(p, "status = clEnqueueNDRangeKernel(");
   p = isl_printer_indent(p, 2);
   p = isl_printer_start_line(p);
@@ -2007,12 +2093,17 @@ static __isl_give isl_printer *autosa_kernel_print_launch_ext_module_kernels(
   p = print_str_new_line(p, "NULL,");
   p = print_str_new_line(p, "globalWorkSize,");
   p = print_str_new_line(p, "localWorkSize,");
-  p = print_str_new_line(p, "0,");
-  p = print_str_new_line(p, "NULL,");
-  p = print_str_new_line(p, "NULL);");
+  p = print_str_new_line(p, "write_event.size(),");
+  p = print_str_new_line(p, "write_event.empty() ? NULL : write_event.data(),");
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "&kernel_event[");
+  p = isl_printer_print_str(p, kernel_id);
+  p = isl_printer_print_str(p, "]);");
+  p = isl_printer_end_line(p);
 
   p = isl_printer_indent(p, -2);
   p = print_str_new_line(p, "CHECK(status);");
+  free(kernel_id);
 
   return p;
 }
@@ -2041,10 +2132,10 @@ static __isl_give isl_printer *print_launch_ext_module_kernels_stmt(
   return p;
 }
 
-/* Set kernel arguments:
- * - arrays
- * - parameters
+/* Set kernel arguments that change across kernel invocations:
  * - host iterators
+ * The parameters and arrays have been set once at the device
+ * initialization.
  * TODO: We need to filter out the module declaration trees and 
  * print them for Intel devices.
  */
@@ -2066,6 +2157,9 @@ static __isl_give isl_printer *print_set_kernel_arguments_intel(
   p = print_str_new_line(p, "localWorkSize[0] = 1;");
   p = isl_printer_end_line(p);
 
+  if (isl_space_dim(kernel->space, isl_dim_set) == 0)
+    return p;
+
   for (int i = 0; i < top->n_ext_module; i++)
   {
     /* Print AST */
@@ -2083,7 +2177,10 @@ static __isl_give isl_printer *print_set_kernel_arguments_intel(
 
 /* Launch the kernels.
  * For each io module connected to the external memory, we will launch a kernel
- * in a independent command queue.
+ * in a independent command queue. All kernels wait for the pending host-to-device
+ * transfers in "write_event" and record their own events in "kernel_event".
+ * Events left over from earlier launches in host loops are collected before
+ * their slots are reused.
  */
 static __isl_give isl_printer *print_launch_kernel_intel(
     __isl_take isl_printer *p,
@@ -2162,21 +2259,23 @@ static __isl_give isl_printer *print_host_user_intel(__isl_take isl_printer *p,
 
   p = print_set_kernel_arguments_intel(p, data->prog, kernel, top);
 
-  p = print_str_new_line(p, "for (int i = 0; i < NUM_QUEUES_TO_CREATE; i++) {");
-  p = isl_printer_indent(p, 2);
-  p = print_str_new_line(p, "status = clFinish(cmdQueue[i]); CHECK(status);");
-  p = isl_printer_indent(p, -2);
-  p = print_str_new_line(p, "}");
   p = print_str_new_line(p, "fpga_begin = std::chrono::high_resolution_clock::now();");
 
   p = print_launch_kernel_intel(p, data->prog, kernel, top);
 
-  p = print_str_new_line(p, "for (int i = 0; i < NUM_QUEUES_TO_CREATE; i++) {");
+  /* Wait for the kernels and accumulate their execution time. */
+  p = print_str_new_line(p, "for (int i = 0; i < NUM_KERNELS_TO_CREATE; i++) {");
   p = isl_printer_indent(p, 2);
-  p = print_str_new_line(p, "status = clFinish(cmdQueue[i]); CHECK(status);");
+  p = print_collect_kernel_event(p, "i");
   p = isl_printer_indent(p, -2);
   p = print_str_new_line(p, "}");
   p = print_str_new_line(p, "fpga_end = std::chrono::high_resolution_clock::now();");
+  p = print_str_new_line(p, "for (auto &event : write_event) {");
+  p = isl_printer_indent(p, 2);
+  p = print_str_new_line(p, "clReleaseEvent(event);");
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+  p = print_str_new_line(p, "write_event.clear();");
 
   p = ppcg_end_block(p);
   p = isl_printer_end_line(p);
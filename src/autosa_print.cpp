@@ -992,6 +992,30 @@ __isl_give isl_printer *autosa_module_array_info_print_call_argument(
   return p;
 }
 
+/* Print the type of a loop iterator that takes values in [0, max], 
+ * including the value at loop exit.
+ * For Xilinx, the iterator is narrowed to the smallest "ap_uint" that holds 
+ * "max", instead of leaving it to the post-processing scripts.
+ * Otherwise, the default AST iterator type is used.
+ */
+__isl_give isl_printer *autosa_print_iterator_type(
+  __isl_take isl_printer *p, long max, enum platform target)
+{
+  int bitwidth = 1;
+
+  if (target != XILINX_HW || max < 0)
+    return isl_printer_print_str(p, 
+              isl_options_get_ast_iterator_type(isl_printer_get_ctx(p)));
+
+  while (bitwidth < 63 && (max >> bitwidth) > 0)
+    bitwidth++;
+  p = isl_printer_print_str(p, "ap_uint<");
+  p = isl_printer_print_int(p, bitwidth);
+  p = isl_printer_print_str(p, ">");
+
+  return p;
+}
+
 /* Print the variable initialization. */
 __isl_give isl_printer *autosa_print_var_initialization(
   __isl_take isl_printer *p, struct autosa_kernel_var *var,
@@ -1003,13 +1027,15 @@ __isl_give isl_printer *autosa_print_var_initialization(
     if (target == CATAPULT_HW)
       p = print_str_new_line(p, "// hls_pipeline");    
 
+    extent = isl_vec_get_element_val(var->size, i);
     p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "for (int c");
+    p = isl_printer_print_str(p, "for (");
+    p = autosa_print_iterator_type(p, isl_val_get_num_si(extent), target);
+    p = isl_printer_print_str(p, " c");
     p = isl_printer_print_int(p, i);
     p = isl_printer_print_str(p, " = 0; c");
     p = isl_printer_print_int(p, i);
     p = isl_printer_print_str(p, " < ");
-    extent = isl_vec_get_element_val(var->size, i);
     p = isl_printer_print_val(p, extent);
     isl_val_free(extent);
     p = isl_printer_print_str(p, "; c");
@@ -1020,7 +1046,7 @@ __isl_give isl_printer *autosa_print_var_initialization(
   }
   
   if (target == XILINX_HW)
-    p = print_str_new_line(p, "// hls_pipeline");
+    p = print_str_new_line(p, "#pragma HLS PIPELINE II=1");
 
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, var->name);
@@ -1039,11 +1065,59 @@ __isl_give isl_printer *autosa_print_var_initialization(
   return p;  
 }
 
+/* Print the template header "template<int p0, ..., int p[n-1]>" of 
+ * a module with "n" identifiers when C++ templates are used in codegen.
+ * All the instances of the module then share a single definition, 
+ * with the module identifiers as compile-time constants.
+ */
+__isl_give isl_printer *print_module_template_params(
+    __isl_take isl_printer *p, int n)
+{
+  if (n == 0)
+    return p;
+
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "template<");
+  for (int i = 0; i < n; i++)
+  {
+    if (i > 0)
+      p = isl_printer_print_str(p, ", ");
+    p = isl_printer_print_str(p, "int p");
+    p = isl_printer_print_int(p, i);
+  }
+  p = isl_printer_print_str(p, ">");
+  p = isl_printer_end_line(p);
+
+  return p;
+}
+
+/* Print the template arguments "<p0, ..., p[n-1]>" of a module with
+ * "n" identifiers, i.e., the module identifiers of the enclosing module.
+ */
+__isl_give isl_printer *print_module_template_args(
+    __isl_take isl_printer *p, int n)
+{
+  if (n == 0)
+    return p;
+
+  p = isl_printer_print_str(p, "<");
+  for (int i = 0; i < n; i++)
+  {
+    if (i > 0)
+      p = isl_printer_print_str(p, ", ");
+    p = isl_printer_print_str(p, "p");
+    p = isl_printer_print_int(p, i);
+  }
+  p = isl_printer_print_str(p, ">");
+
+  return p;
+}
+
 /* Print the arguments to a module declaration or call. If "types" is set,
  * then print a declaration (including the types of the arguments).
  *
  * The arguments are printed in the following order
- * - the module identifiers
+ * - the module identifiers (unless C++ templates are used)
  * - the parameters
  * - the host loop iterators
  * - the arrays accessed by the module
@@ -1200,9 +1274,47 @@ __isl_give isl_printer *print_module_arguments(
       }
       if (types)
       {
-        p = autosa_array_info_print_declaration_argument(
-              p, module->io_groups[0]->array, n_lane,
-              target == INTEL_HW ? "__global volatile" : NULL, -1, prog->scop->options->autosa->mem_port_map, target);
+        if (target == INTEL_HW && prog->scop->options->autosa->hbm)
+        {
+          /* Place each memory port on its own HBM bank. When the array is
+           * split into multiple ports, the bank depends on the module id and
+           * is resolved when the module is instantiated by codegen.py.
+           */
+          struct autosa_array_ref_group *group = module->io_groups[0];
+          isl_printer *p_str;
+          char *memory_space;
+          int port;
+
+          port = autosa_array_get_mem_port_base(kernel, group->array,
+                    prog->scop->options->autosa->mem_port_map);
+          port += group->mem_port_id;
+          p_str = isl_printer_to_str(prog->ctx);
+          p_str = isl_printer_print_str(p_str, "__global volatile __attribute__((buffer_location(\"HBM");
+          if (group->n_mem_ports > 1)
+          {
+            p_str = isl_printer_print_str(p_str, "(");
+            p_str = isl_printer_print_int(p_str, port);
+            p_str = isl_printer_print_str(p_str, " + ");
+            p_str = isl_printer_print_str(p_str, dims[0]);
+            p_str = isl_printer_print_str(p_str, ")");
+          }
+          else
+          {
+            p_str = isl_printer_print_int(p_str, port);
+          }
+          p_str = isl_printer_print_str(p_str, "\")))");
+          memory_space = isl_printer_get_str(p_str);
+          isl_printer_free(p_str);
+          p = autosa_array_info_print_declaration_argument(
+                p, group->array, n_lane, memory_space, -1, NULL, target);
+          free(memory_space);
+        }
+        else
+        {
+          p = autosa_array_info_print_declaration_argument(
+                p, module->io_groups[0]->array, n_lane,
+                target == INTEL_HW ? "__global volatile" : NULL, -1, prog->scop->options->autosa->mem_port_map, target);
+        }
       }
       else
       {
@@ -1578,7 +1690,7 @@ __isl_give isl_printer *print_module_arguments(
  * then print a declaration (including the types of the arguments).
  *
  * The arguments are printed in the following order
- * - the module identifiers
+ * - the module identifiers (unless C++ templates are used on Xilinx)
  * - the parameters
  * - the host loop iterators 
  * - the arrays accessed by the module
@@ -1600,9 +1712,13 @@ __isl_give isl_printer *print_pe_dummy_module_arguments(
   struct autosa_hw_module *module = pe_dummy_module->module;
 
   type = isl_options_get_ast_iterator_type(prog->ctx);
-  /* module identifiers */
+  /* module identifiers, passed as template arguments when the Xilinx 
+   * printer emits the PE dummy modules as C++ templates 
+   */
   const char *dims[] = {"idx", "idy", "idz"};
   n = isl_id_list_n_id(module->inst_ids);
+  if (prog->scop->options->autosa->use_cplusplus_template && target == XILINX_HW)
+    n = 0;
   for (int i = 0; i < n; ++i)
   {
     if (!first)
@@ -3294,7 +3410,11 @@ __isl_give isl_printer *autosa_kernel_print_io(__isl_take isl_printer *p,
       if (hls->target == XILINX_HW)
       {
         p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, "for (int n = 0; n < ");
+        p = isl_printer_print_str(p, "for (");
+        p = autosa_print_iterator_type(p, 
+              is_sparse ? group->n_lane * n_nzero : data_pack / nxt_data_pack,
+              hls->target);
+        p = isl_printer_print_str(p, " n = 0; n < ");
         if (is_sparse)
           p = isl_printer_print_int(p, group->n_lane * n_nzero);  
         else
@@ -3560,7 +3680,9 @@ __isl_give isl_printer *autosa_kernel_print_io(__isl_take isl_printer *p,
         }
 
         p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, "for (int n = 0; n < ");
+        p = isl_printer_print_str(p, "for (");
+        p = autosa_print_iterator_type(p, group->n_lane / kernel->vec_len, hls->target);
+        p = isl_printer_print_str(p, " n = 0; n < ");
         p = isl_printer_print_int(p, group->n_lane / kernel->vec_len);
         p = isl_printer_print_str(p, "; n++) {");
         p = isl_printer_end_line(p);
@@ -3578,7 +3700,9 @@ __isl_give isl_printer *autosa_kernel_print_io(__isl_take isl_printer *p,
         }
 
         p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, "for (int m = 0; m < ");        
+        p = isl_printer_print_str(p, "for (");
+        p = autosa_print_iterator_type(p, kernel->vec_len, hls->target);
+        p = isl_printer_print_str(p, " m = 0; m < ");
         p = isl_printer_print_int(p, kernel->vec_len);
         p = isl_printer_print_str(p, "; m++) {");
         p = isl_printer_end_line(p);
@@ -3622,7 +3746,9 @@ __isl_give isl_printer *autosa_kernel_print_io(__isl_take isl_printer *p,
         }
 
         p = isl_printer_start_line(p);
-        p = isl_printer_print_str(p, "for (int n = 0; n < ");
+        p = isl_printer_print_str(p, "for (");
+        p = autosa_print_iterator_type(p, group->n_lane / kernel->vec_len * kernel->n_nzero, hls->target);
+        p = isl_printer_print_str(p, " n = 0; n < ");
         p = isl_printer_print_int(p, group->n_lane / kernel->vec_len * kernel->n_nzero);
         p = isl_printer_print_str(p, "; n++) {");
         p = isl_printer_end_line(p);
@@ -4760,7 +4886,9 @@ static __isl_give isl_printer *io_transfer_write_data_split(
 
   if (hls->target == XILINX_HW) {    
     p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "for (int n = 0; n < ");
+    p = isl_printer_print_str(p, "for (");
+    p = autosa_print_iterator_type(p, n_lane / nxt_n_lane, hls->target);
+    p = isl_printer_print_str(p, " n = 0; n < ");
     p = isl_printer_print_int(p, n_lane / nxt_n_lane);
     p = isl_printer_print_str(p, "; n++) {");
     p = isl_printer_end_line(p);
@@ -5642,7 +5770,9 @@ static __isl_give isl_printer *autosa_kernel_print_io_transfer_data_pack(
   if (hls->target == XILINX_HW)
   {    
     p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "for (int n = 0; n < ");
+    p = isl_printer_print_str(p, "for (");
+    p = autosa_print_iterator_type(p, n_lane / nxt_n_lane, hls->target);
+    p = isl_printer_print_str(p, " n = 0; n < ");
     p = isl_printer_print_int(p, n_lane / nxt_n_lane);
     p = isl_printer_print_str(p, "; n++) {");
     p = isl_printer_end_line(p);
@@ -6126,56 +6256,42 @@ __isl_give isl_printer *autosa_kernel_print_host_serialize(
   return p;
 }
 
-/* Print a drain merge statement.
- *
- * [group_array_prefix]_to[...] = [group_array_prefix]_from[...]
+/* Replace the array of the drain merge index "index" by 
+ * [array]_[suffix].
  */
-__isl_give isl_printer *autosa_kernel_print_drain_merge(__isl_take isl_printer *p,
-                                                        struct autosa_kernel_stmt *stmt, struct hls_info *hls)
+static __isl_give isl_ast_expr *drain_merge_index_set_array(
+    isl_ctx *ctx, __isl_keep isl_ast_expr *index, const char *suffix)
 {
-  isl_ast_expr *index_to, *index_from, *arg;
-  isl_ctx *ctx = hls->ctx;
-  struct autosa_drain_merge_func *func = stmt->u.dm.func;
-  isl_ast_expr *index = stmt->u.dm.index;
-  int n_arg;
+  isl_ast_expr *arg;
   isl_id *id;
-  const char *array_name;
   char *new_array_name;
-  isl_printer *p_str;
 
-  p = isl_printer_start_line(p);
-  // TODO
-  n_arg = isl_ast_expr_get_op_n_arg(index);
-  /* Modify the index. */
   arg = isl_ast_expr_get_op_arg(index, 0);
   id = isl_ast_expr_id_get_id(arg);
-  array_name = isl_id_get_name(id);
+  new_array_name = concat(ctx, isl_id_get_name(id), suffix);
   isl_id_free(id);
   isl_ast_expr_free(arg);
-  p_str = isl_printer_to_str(ctx);
-  p_str = isl_printer_print_str(p_str, array_name);
-  p_str = isl_printer_print_str(p_str, "_to");
-  new_array_name = isl_printer_get_str(p_str);
-  isl_printer_free(p_str);
   id = isl_id_alloc(ctx, new_array_name, NULL);
   arg = isl_ast_expr_from_id(id);
   free(new_array_name);
-  index_to = isl_ast_expr_set_op_arg(isl_ast_expr_copy(index), 0, arg);
 
-  arg = isl_ast_expr_get_op_arg(index, 0);
-  id = isl_ast_expr_id_get_id(arg);
-  array_name = isl_id_get_name(id);
-  isl_id_free(id);
-  isl_ast_expr_free(arg);
-  p_str = isl_printer_to_str(ctx);
-  p_str = isl_printer_print_str(p_str, array_name);
-  p_str = isl_printer_print_str(p_str, "_from");
-  new_array_name = isl_printer_get_str(p_str);
-  isl_printer_free(p_str);
-  id = isl_id_alloc(ctx, new_array_name, NULL);
-  arg = isl_ast_expr_from_id(id);
-  free(new_array_name);
-  index_from = isl_ast_expr_set_op_arg(isl_ast_expr_copy(index), 0, arg);
+  return isl_ast_expr_set_op_arg(isl_ast_expr_copy(index), 0, arg);
+}
+
+/* Print a drain merge statement.
+ *
+ * [group_array_prefix]_to[...] = [group_array_prefix]_from[...]
+ */
+__isl_give isl_printer *autosa_kernel_print_drain_merge(__isl_take isl_printer *p,
+                                                        struct autosa_kernel_stmt *stmt, struct hls_info *hls)
+{
+  isl_ast_expr *index_to, *index_from;
+  isl_ctx *ctx = hls->ctx;
+  isl_ast_expr *index = stmt->u.dm.index;
+
+  p = isl_printer_start_line(p);
+  index_to = drain_merge_index_set_array(ctx, index, "to");
+  index_from = drain_merge_index_set_array(ctx, index, "from");
 
   p = isl_printer_print_ast_expr(p, index_to);
   p = isl_printer_print_str(p, " = ");
@@ -6190,6 +6306,102 @@ __isl_give isl_printer *autosa_kernel_print_drain_merge(__isl_take isl_printer *
   return p;
 }
 
+/* Print the loop "node" of a drain merge function.
+ * If the loop only contains a drain merge statement and walks through
+ * consecutive array elements (see create_drain_merge_leaf), 
+ * the loop is printed as a block copy
+ *
+ *   memcpy(&[array]_to[index(lb)], &[array]_from[index(lb)], n * sizeof(type));
+ *
+ * where "lb" is the initial value of the loop iterator and "n" is the 
+ * trip count of the loop. Otherwise, the loop is printed as is.
+ * This is only used for the merge functions on the host.
+ */
+static __isl_give isl_printer *print_drain_merge_for(__isl_take isl_printer *p,
+                                                     __isl_take isl_ast_print_options *print_options,
+                                                     __isl_keep isl_ast_node *node, void *user)
+{
+  isl_ctx *ctx = isl_printer_get_ctx(p);
+  isl_ast_node *body;
+  isl_ast_expr *iter, *init, *cond, *inc, *ub, *index, *index_to, *index_from;
+  isl_id *id;
+  isl_id_to_ast_expr *iter2init;
+  struct autosa_kernel_stmt *stmt = NULL;
+  enum isl_ast_op_type cond_type;
+  int block_copy = 0;
+
+  body = isl_ast_node_for_get_body(node);
+  if (isl_ast_node_get_type(body) == isl_ast_node_user)
+  {
+    id = isl_ast_node_get_annotation(body);
+    stmt = id ? (struct autosa_kernel_stmt *)isl_id_get_user(id) : NULL;
+    isl_id_free(id);
+  }
+  isl_ast_node_free(body);
+  if (!stmt || stmt->type != AUTOSA_KERNEL_STMT_DRAIN_MERGE || 
+      !stmt->u.dm.contiguous_iter)
+    return isl_ast_node_for_print(node, p, print_options);
+
+  iter = isl_ast_node_for_get_iterator(node);
+  cond = isl_ast_node_for_get_cond(node);
+  inc = isl_ast_node_for_get_inc(node);
+  id = isl_ast_expr_get_id(iter);
+  cond_type = isl_ast_expr_get_op_type(cond);
+  if (!strcmp(isl_id_get_name(id), stmt->u.dm.contiguous_iter) &&
+      isl_ast_expr_get_type(inc) == isl_ast_expr_int &&
+      isl_ast_expr_get_type(cond) == isl_ast_expr_op &&
+      (cond_type == isl_ast_op_le || cond_type == isl_ast_op_lt))
+  {
+    isl_val *v = isl_ast_expr_get_val(inc);
+    isl_ast_expr *arg = isl_ast_expr_get_op_arg(cond, 0);
+    block_copy = isl_val_is_one(v) && isl_ast_expr_is_equal(arg, iter);
+    isl_ast_expr_free(arg);
+    isl_val_free(v);
+  }
+  isl_ast_expr_free(inc);
+  if (!block_copy)
+  {
+    isl_id_free(id);
+    isl_ast_expr_free(iter);
+    isl_ast_expr_free(cond);
+    return isl_ast_node_for_print(node, p, print_options);
+  }
+  isl_ast_print_options_free(print_options);
+
+  init = isl_ast_node_for_get_init(node);
+  ub = isl_ast_expr_get_op_arg(cond, 1);
+  iter2init = isl_id_to_ast_expr_alloc(ctx, 1);
+  iter2init = isl_id_to_ast_expr_set(iter2init, id, isl_ast_expr_copy(init));
+  index = isl_ast_expr_substitute_ids(isl_ast_expr_copy(stmt->u.dm.index), iter2init);
+  index_to = drain_merge_index_set_array(ctx, index, "to");
+  index_from = drain_merge_index_set_array(ctx, index, "from");
+
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "memcpy(&");
+  p = isl_printer_print_ast_expr(p, index_to);
+  p = isl_printer_print_str(p, ", &");
+  p = isl_printer_print_ast_expr(p, index_from);
+  p = isl_printer_print_str(p, ", ((");
+  p = isl_printer_print_ast_expr(p, ub);
+  p = isl_printer_print_str(p, ") - (");
+  p = isl_printer_print_ast_expr(p, init);
+  p = isl_printer_print_str(p, cond_type == isl_ast_op_le ? ") + 1)" : "))");
+  p = isl_printer_print_str(p, " * sizeof(");
+  p = isl_printer_print_str(p, stmt->u.dm.func->group->local_array->array->type);
+  p = isl_printer_print_str(p, "));");
+  p = isl_printer_end_line(p);
+
+  isl_ast_expr_free(index);
+  isl_ast_expr_free(index_to);
+  isl_ast_expr_free(index_from);
+  isl_ast_expr_free(init);
+  isl_ast_expr_free(ub);
+  isl_ast_expr_free(cond);
+  isl_ast_expr_free(iter);
+
+  return p;
+}
+
 /* Print an I/O dram statement.
  *
  * An in I/O statement is printed as 
@@ -6395,19 +6607,11 @@ static __isl_give isl_printer *print_inter_trans_module_call(
   p = isl_printer_print_str(p, "_inter_trans");
   if (boundary)
     p = isl_printer_print_str(p, "_boundary");
-  if (prog->scop->options->autosa->use_cplusplus_template) {
-    p = isl_printer_print_str(p, "<");
-    for (int i = 0; i < n; i++) {
-      if (i > 0) 
-        p = isl_printer_print_str(p, ", ");
-      p = isl_printer_print_str(p, "p");
-      p = isl_printer_print_int(p, i);
-    }
-    p = isl_printer_print_str(p, ">");
-  }
   if (hls->target == CATAPULT_HW) {
     p = isl_printer_print_str(p, "_inst.run");
   }
+  if (prog->scop->options->autosa->use_cplusplus_template)
+    p = print_module_template_args(p, n);
   p = isl_printer_print_str(p, "(");
   p = isl_printer_end_line(p);
   p = isl_printer_indent(p, 2);
@@ -6477,19 +6681,11 @@ static __isl_give isl_printer *print_intra_trans_module_call(
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, module->name);
   p = isl_printer_print_str(p, "_intra_trans");
-  if (prog->scop->options->autosa->use_cplusplus_template) {
-    p = isl_printer_print_str(p, "<");
-    for (int i = 0; i < n; i++) {
-      if (i > 0) 
-        p = isl_printer_print_str(p, ", ");
-      p = isl_printer_print_str(p, "p");
-      p = isl_printer_print_int(p, i);
-    }
-    p = isl_printer_print_str(p, ">");
-  }
   if (hls->target == CATAPULT_HW) {
     p = isl_printer_print_str(p, "_inst.run");
   }
+  if (prog->scop->options->autosa->use_cplusplus_template)
+    p = print_module_template_args(p, n);
   p = isl_printer_print_str(p, "(");
   p = isl_printer_end_line(p);
   p = isl_printer_indent(p, 2);
@@ -7667,6 +7863,9 @@ isl_stat print_drain_merge_funcs(
     print_options = isl_ast_print_options_alloc(ctx);
     print_options = isl_ast_print_options_set_print_user(print_options,
                                                          &print_module_stmt, &hw_data);
+    if (!hls->hls)
+      print_options = isl_ast_print_options_set_print_for(print_options,
+                                                          &print_drain_merge_for, NULL);
     p = isl_ast_node_print(funcs[i]->device_tree, p, print_options);
 
     p = isl_printer_indent(p, -2);
@@ -37,6 +37,8 @@ __isl_give isl_printer *autosa_array_info_print_declaration_argument(
     const char *memory_space, int n_ref);
 __isl_give isl_printer *autosa_module_array_info_print_call_argument(
     __isl_take isl_printer *p, struct polysa_array_info *array);
+__isl_give isl_printer *autosa_print_iterator_type(
+    __isl_take isl_printer *p, long max, enum platform target);
 __isl_give isl_printer *autosa_print_var_initialization(
     __isl_take isl_printer *p, struct autosa_kernel_var *var, enum platform target);
 
@@ -56,6 +58,10 @@ __isl_give isl_printer *print_kernel_header(
 /* HW modules */
 __isl_give isl_printer *print_module_iterators(
     __isl_take isl_printer *p, FILE *out, struct autosa_hw_module *module);
+__isl_give isl_printer *print_module_template_params(
+    __isl_take isl_printer *p, int n);
+__isl_give isl_printer *print_module_template_args(
+    __isl_take isl_printer *p, int n);
 __isl_give isl_printer *print_module_arguments(
     __isl_take isl_printer *p,
     struct autosa_prog *prog,
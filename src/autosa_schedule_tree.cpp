@@ -1,11 +1,14 @@
 /* This file defines functions used to manipulate the schedule trees in AutoSA.
  */
+#include <sys/wait.h>
+#include <unistd.h>
 #include <isl/ctx.h>
 #include <isl/schedule_node.h>
 
 #include "autosa_common.h"
 #include "autosa_utils.h"
 #include "autosa_schedule_tree.h"
+#include "hybrid.h"
 
 /* Is "node" a mark node with an identifier called "name"?
  */
@@ -479,20 +482,20 @@ __isl_give isl_vec *get_dep_dis_at_schedule(__isl_keep isl_basic_map *dep,
   return dep_dis;
 }
 
-/* Compute the dependence distance vector of the dependence under the 
- * partial schedule of the band node. The dependence "dep" is untagged.
+/* Compute the dependence distance vector of the untagged dependence "dep"
+ * under the band partial schedule "p_sc", with the subtree contraction 
+ * already applied.
+ * If "uniform" is not NULL, it is set to isl_bool_false if the distance at
+ * any band member is not a constant.
+ * Return NULL if the source or the sink of "dep" is not scheduled by "p_sc".
  */
-__isl_give isl_vec *get_dep_dis_at_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *band)
+static __isl_give isl_vec *compute_dep_dis_at_sched(__isl_keep isl_basic_map *dep,
+                                                    __isl_keep isl_multi_union_pw_aff *p_sc, isl_bool *uniform)
 {
-  if (isl_schedule_node_get_type(band) != isl_schedule_node_band)
-    return NULL;
-
-  isl_multi_union_pw_aff *p_sc = isl_schedule_node_band_get_partial_schedule(band);
-  isl_union_pw_multi_aff *contraction = isl_schedule_node_get_subtree_contraction(band);
-  p_sc = isl_multi_union_pw_aff_pullback_union_pw_multi_aff(p_sc, contraction);
-
-  int band_w = isl_schedule_node_band_n_member(band);
+  int band_w = isl_multi_union_pw_aff_dim(p_sc, isl_dim_set);
   isl_vec *dep_dis = isl_vec_zero(isl_basic_map_get_ctx(dep), band_w);
+  if (uniform)
+    *uniform = isl_bool_true;
   for (int i = 0; i < band_w; i++)
   {
     isl_union_pw_aff *p_sc_hyp = isl_multi_union_pw_aff_get_union_pw_aff(p_sc, i);
@@ -539,6 +542,15 @@ __isl_give isl_vec *get_dep_dis_at_node(__isl_keep isl_basic_map *dep, __isl_kee
     }
     isl_pw_aff_list_free(p_sc_hyp_list);
     isl_space_free(dest_space);
+    isl_union_pw_aff_free(p_sc_hyp);
+
+    if (!src_sc || !dest_sc)
+    {
+      isl_pw_aff_free(src_sc);
+      isl_pw_aff_free(dest_sc);
+      isl_vec_free(dep_dis);
+      return NULL;
+    }
 
     /* Compute the dependence distance at the current hyperplane. */
     /* Step 1: Extend the scheduling function. */
@@ -570,16 +582,268 @@ __isl_give isl_vec *get_dep_dis_at_node(__isl_keep isl_basic_map *dep, __isl_kee
 
     /* Step 3: Intersect the scheduling function with the domain. */
     isl_pw_aff *dis = isl_pw_aff_intersect_domain(dis_sc, isl_set_from_basic_set(isl_basic_set_copy(dep_set)));
+    if (uniform && *uniform == isl_bool_true)
+    {
+      isl_pw_aff *dis_cst = isl_pw_aff_coalesce(isl_pw_aff_copy(dis));
+      *uniform = isl_pw_aff_is_cst(dis_cst);
+      if (*uniform == isl_bool_true && isl_pw_aff_n_piece(dis_cst) > 1)
+        *uniform = isl_bool_false;
+      isl_pw_aff_free(dis_cst);
+    }
     isl_val *val = isl_pw_aff_eval(dis, isl_basic_set_sample_point(dep_set));
     dep_dis = isl_vec_set_element_val(dep_dis, i, val);
-
-    isl_union_pw_aff_free(p_sc_hyp);
   }
 
+  return dep_dis;
+}
+
+/* Compute the dependence distance vector of the dependence under the 
+ * partial schedule of the band node. The dependence "dep" is untagged.
+ */
+__isl_give isl_vec *get_dep_dis_at_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *band)
+{
+  if (isl_schedule_node_get_type(band) != isl_schedule_node_band)
+    return NULL;
+
+  isl_multi_union_pw_aff *p_sc = isl_schedule_node_band_get_partial_schedule(band);
+  isl_union_pw_multi_aff *contraction = isl_schedule_node_get_subtree_contraction(band);
+  p_sc = isl_multi_union_pw_aff_pullback_union_pw_multi_aff(p_sc, contraction);
+
+  isl_vec *dep_dis = compute_dep_dis_at_sched(dep, p_sc, NULL);
+
   isl_multi_union_pw_aff_free(p_sc);
   return dep_dis;
 }
 
+/* Find the index of dependence "dep" in "table". Add "dep" to the table 
+ * if it is not found.
+ */
+static int dep_dis_table_find_dep(struct autosa_dep_dis_table *table,
+                                  __isl_keep isl_basic_map *dep)
+{
+  for (int i = 0; i < table->n_dep; i++)
+  {
+    if (table->deps[i] == dep)
+      return i;
+  }
+  for (int i = 0; i < table->n_dep; i++)
+  {
+    if (isl_basic_map_plain_is_equal(table->deps[i], dep) == isl_bool_true)
+      return i;
+  }
+
+  table->deps = (isl_basic_map **)realloc(table->deps,
+                                          (table->n_dep + 1) * sizeof(isl_basic_map *));
+  table->deps[table->n_dep] = isl_basic_map_copy(dep);
+  return table->n_dep++;
+}
+
+/* Find the entry in "table" whose band members match the members of 
+ * "p_sc". The members may appear in any order. On success, "perm[i]" is 
+ * set to the position of the i-th member of "p_sc" in the entry.
+ */
+static struct autosa_dep_dis_entry *dep_dis_table_find_entry(
+    struct autosa_dep_dis_table *table, __isl_keep isl_multi_union_pw_aff *p_sc,
+    int *perm)
+{
+  int n = isl_multi_union_pw_aff_dim(p_sc, isl_dim_set);
+
+  for (int i = 0; i < table->n_entry; i++)
+  {
+    struct autosa_dep_dis_entry *entry = table->entries[i];
+    int n_entry = isl_multi_union_pw_aff_dim(entry->sched, isl_dim_set);
+    int match = 1;
+
+    if (n_entry < n)
+      continue;
+    for (int j = 0; j < n && match; j++)
+    {
+      isl_union_pw_aff *upa = isl_multi_union_pw_aff_get_union_pw_aff(p_sc, j);
+      perm[j] = -1;
+      for (int k = 0; k < n_entry; k++)
+      {
+        isl_union_pw_aff *upa_entry =
+            isl_multi_union_pw_aff_get_union_pw_aff(entry->sched, k);
+        isl_bool equal = isl_union_pw_aff_plain_is_equal(upa, upa_entry);
+        isl_union_pw_aff_free(upa_entry);
+        if (equal == isl_bool_true)
+        {
+          perm[j] = k;
+          break;
+        }
+      }
+      isl_union_pw_aff_free(upa);
+      if (perm[j] < 0)
+        match = 0;
+    }
+    if (match)
+      return entry;
+  }
+
+  return NULL;
+}
+
+static struct autosa_dep_dis_entry *dep_dis_table_add_entry(
+    struct autosa_dep_dis_table *table, __isl_take isl_multi_union_pw_aff *p_sc)
+{
+  struct autosa_dep_dis_entry *entry;
+
+  entry = (struct autosa_dep_dis_entry *)calloc(1, sizeof(struct autosa_dep_dis_entry));
+  entry->sched = p_sc;
+  table->entries = (struct autosa_dep_dis_entry **)realloc(table->entries,
+                                                           (table->n_entry + 1) * sizeof(struct autosa_dep_dis_entry *));
+  table->entries[table->n_entry++] = entry;
+
+  return entry;
+}
+
+/* Return the dependence distance vector of the untagged dependence "dep" 
+ * under the partial schedule of the band node "band", using the memoized 
+ * results in "table" when available.
+ * The distance is only computed once for each band partial schedule 
+ * (up to permutation of the band members).
+ * Return NULL if the distance can't be determined from a single sample, i.e., 
+ * the dependence is not scheduled by the band or the distance is not uniform.
+ */
+__isl_give isl_vec *autosa_dep_dis_table_get(struct autosa_dep_dis_table *table,
+                                             __isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *band)
+{
+  isl_multi_union_pw_aff *p_sc;
+  isl_union_pw_multi_aff *contraction;
+  struct autosa_dep_dis_entry *entry;
+  int *perm;
+  int n, dep_id;
+  isl_vec *dis;
+
+  if (!table || !dep || !band)
+    return NULL;
+  if (isl_schedule_node_get_type(band) != isl_schedule_node_band)
+    return NULL;
+
+  p_sc = isl_schedule_node_band_get_partial_schedule(band);
+  contraction = isl_schedule_node_get_subtree_contraction(band);
+  p_sc = isl_multi_union_pw_aff_pullback_union_pw_multi_aff(p_sc, contraction);
+  n = isl_multi_union_pw_aff_dim(p_sc, isl_dim_set);
+
+  perm = (int *)malloc(n * sizeof(int));
+  entry = dep_dis_table_find_entry(table, p_sc, perm);
+  if (!entry)
+  {
+    for (int i = 0; i < n; i++)
+      perm[i] = i;
+    entry = dep_dis_table_add_entry(table, isl_multi_union_pw_aff_copy(p_sc));
+  }
+
+  dep_id = dep_dis_table_find_dep(table, dep);
+  if (dep_id >= entry->n_dep)
+  {
+    entry->dis = (isl_vec **)realloc(entry->dis, table->n_dep * sizeof(isl_vec *));
+    entry->computed = (int *)realloc(entry->computed, table->n_dep * sizeof(int));
+    for (int i = entry->n_dep; i < table->n_dep; i++)
+    {
+      entry->dis[i] = NULL;
+      entry->computed[i] = 0;
+    }
+    entry->n_dep = table->n_dep;
+  }
+
+  if (!entry->computed[dep_id])
+  {
+    isl_bool uniform;
+    table->n_miss++;
+    entry->dis[dep_id] = compute_dep_dis_at_sched(table->deps[dep_id],
+                                                  entry->sched, &uniform);
+    if (uniform != isl_bool_true)
+      entry->dis[dep_id] = isl_vec_free(entry->dis[dep_id]);
+    entry->computed[dep_id] = 1;
+  }
+  else
+  {
+    table->n_hit++;
+  }
+
+  dis = NULL;
+  if (entry->dis[dep_id])
+  {
+    dis = isl_vec_zero(table->ctx, n);
+    for (int i = 0; i < n; i++)
+      dis = isl_vec_set_element_val(dis, i,
+                                    isl_vec_get_element_val(entry->dis[dep_id], perm[i]));
+  }
+
+  free(perm);
+  isl_multi_union_pw_aff_free(p_sc);
+  return dis;
+}
+
+/* Compute the dependence distance vector of the untagged dependence "dep" 
+ * under the partial schedule of the band node "band".
+ * Look up the memoized distance table of "scop" first and fall back to
+ * get_dep_dis_at_node if the distance is not available in the table.
+ */
+__isl_give isl_vec *autosa_get_dep_dis_at_node(struct ppcg_scop *scop,
+                                               __isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *band)
+{
+  isl_vec *dis = NULL;
+
+  if (scop && scop->dep_dis)
+    dis = autosa_dep_dis_table_get(scop->dep_dis, dep, band);
+  if (!dis)
+    dis = get_dep_dis_at_node(dep, band);
+
+  return dis;
+}
+
+/* Skew the loop at "level" by the loop at "src_level" in the band node, i.e., 
+ * replace the schedule at "level" with 
+ * schedule[level] + factor * schedule[src_level].
+ * The transformation is unimodular. The caller should guarantee that the 
+ * band remains permutable. "coincident" is the new coincident property of 
+ * the skewed loop.
+ */
+__isl_give isl_schedule_node *loop_skewing_at_node(
+  __isl_take isl_schedule_node *node, isl_size level, isl_size src_level, 
+  int factor, int coincident)
+{
+  /* Obtain the partial schedule of the node. */
+  isl_multi_union_pw_aff *sc = isl_schedule_node_band_get_partial_schedule(node);
+  isl_ctx *ctx = isl_schedule_node_get_ctx(node);
+
+  /* Skew the schedule at "level". */
+  isl_union_pw_aff *upa = isl_multi_union_pw_aff_get_union_pw_aff(sc, level);
+  isl_union_pw_aff *src_upa = isl_multi_union_pw_aff_get_union_pw_aff(sc, src_level);
+  src_upa = isl_union_pw_aff_scale_val(src_upa, isl_val_int_from_si(ctx, factor));
+  upa = isl_union_pw_aff_add(upa, src_upa);
+  isl_multi_union_pw_aff *new_sc = isl_multi_union_pw_aff_copy(sc);
+  new_sc = isl_multi_union_pw_aff_set_union_pw_aff(new_sc, level, upa);
+
+  /* Insert a new schedule node with the new schedule. */
+  struct autosa_node_band_prop *prop = extract_node_band_prop(node);
+  node = isl_schedule_node_insert_partial_schedule(node, new_sc);
+
+  /* Update the properties of the new node. */
+  node = isl_schedule_node_band_set_permutable(node, 1);
+  for (int i = 0; i < isl_schedule_node_band_n_member(node); i++)
+  {
+    node = isl_schedule_node_band_member_set_coincident(node, i, prop->coincident[i]);
+    node = isl_schedule_node_band_member_set_pe_opt(node, i, prop->pe_opt[i]);
+    node = isl_schedule_node_band_member_set_space_time(node, i, prop->space_time[i]);
+    node = isl_schedule_node_band_member_set_sched_pos(node, i, prop->sched_pos[i]);
+  }
+  node = isl_schedule_node_band_member_set_coincident(node, level, coincident);
+
+  autosa_node_band_prop_free(prop);
+
+  /* Delete the old node after the current node */
+  node = isl_schedule_node_child(node, 0);
+  node = isl_schedule_node_delete(node);
+
+  node = isl_schedule_node_parent(node);
+  isl_multi_union_pw_aff_free(sc);
+
+  return node;
+}
+
 /* Interchange the loop at "level1" and "level2" in the schedule node and 
  * return the new schedule. */
 __isl_give isl_schedule_node *loop_interchange_at_node(
@@ -1165,6 +1429,24 @@ isl_bool is_flow_dep_carried_by_array_part_loops(__isl_keep isl_schedule *schedu
             int dim;
             int is_parallel;
 
+            /* Look up the memoized dependence distance first. */
+            isl_basic_map *untagged_dep = isl_basic_map_from_map(
+                isl_map_factor_domain(
+                    isl_map_from_basic_map(isl_basic_map_copy(io_info->dep->isl_dep))));
+            isl_vec *dis = autosa_dep_dis_table_get(kernel->scop->dep_dis, untagged_dep, node);
+            isl_basic_map_free(untagged_dep);
+            if (dis)
+            {
+              is_parallel = isl_vec_is_zero(dis);
+              isl_vec_free(dis);
+              if (!is_parallel)
+              {
+                carried = isl_bool_true;
+                break;
+              }
+              continue;
+            }
+
             isl_union_map *dep = isl_union_map_from_map(
                 isl_map_factor_domain(
                     isl_map_from_basic_map(isl_basic_map_copy(io_info->dep->isl_dep))));
@@ -1204,8 +1486,12 @@ isl_bool is_flow_dep_carried_by_array_part_loops(__isl_keep isl_schedule *schedu
   return carried;
 }
 
-/* Test if the dependence is carried by the current schedule node. */
-int is_dep_carried_by_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *node)
+/* Test if the dependence is carried by the current schedule node. 
+ * If "scop" is not NULL, the memoized dependence distance of "scop" is used 
+ * when available.
+ */
+int is_dep_carried_by_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedule_node *node,
+                           struct ppcg_scop *scop)
 {
   if (!node || isl_schedule_node_get_type(node) != isl_schedule_node_band)
     return -1;
@@ -1218,6 +1504,20 @@ int is_dep_carried_by_node(__isl_keep isl_basic_map *dep, __isl_keep isl_schedul
   isl_map *map_dep, *test;
   int is_carried;
 
+  if (scop && scop->dep_dis)
+  {
+    isl_basic_map *untagged_dep = isl_basic_map_from_map(
+        isl_map_factor_domain(isl_map_from_basic_map(isl_basic_map_copy(dep))));
+    isl_vec *dis = autosa_dep_dis_table_get(scop->dep_dis, untagged_dep, node);
+    isl_basic_map_free(untagged_dep);
+    if (dis)
+    {
+      is_carried = !isl_vec_is_zero(dis);
+      isl_vec_free(dis);
+      return is_carried;
+    }
+  }
+
   umap = isl_schedule_node_band_get_partial_schedule_union_map(node);
   umap_dep = isl_union_map_from_map(isl_map_factor_domain(isl_map_from_basic_map(isl_basic_map_copy(dep))));
   umap_dep = isl_union_map_apply_range(umap_dep, isl_union_map_copy(umap));
@@ -1807,6 +2107,43 @@ int *extract_band_upper_bounds(__isl_keep isl_schedule_node *node)
   return ubs;
 }
 
+/* Return the number of iterations of the bands below the band "node" 
+ * down to the "PE" mark, i.e., the iterations covered by one iteration 
+ * of "node". Return -1 if any of the bounds is unknown.
+ */
+double extract_band_inner_volume(__isl_keep isl_schedule_node *node)
+{
+  isl_schedule_node *child;
+  double volume = 1;
+
+  child = isl_schedule_node_copy(node);
+  child = isl_schedule_node_child(child, 0);
+  while (isl_schedule_node_get_type(child) == isl_schedule_node_band ||
+         (isl_schedule_node_get_type(child) == isl_schedule_node_mark &&
+          !is_marked(child, "pe")))
+  {
+    if (isl_schedule_node_get_type(child) == isl_schedule_node_band)
+    {
+      int n = isl_schedule_node_band_n_member(child);
+      int *ubs = extract_band_upper_bounds(child);
+      for (int i = 0; i < n; i++)
+      {
+        if (ubs[i] <= 0)
+          volume = -1;
+        else if (volume > 0)
+          volume *= ubs[i];
+      }
+      free(ubs);
+    }
+    if (isl_schedule_node_n_children(child) != 1)
+      break;
+    child = isl_schedule_node_child(child, 0);
+  }
+  isl_schedule_node_free(child);
+
+  return volume;
+}
+
 /* Return an isl_multi_aff, with as elements the parameters in "space"
  * that have the names specified by the elements in "names".
  * If (some of) these parameters do not already appear in "space",
@@ -2205,6 +2542,146 @@ __isl_give isl_schedule *get_schedule(struct autosa_gen *gen)
                            &compute_or_set_properties, gen);
 }
 
+/* Alternative ISL scheduler configurations explored by explore_schedules.
+ * The default configuration set up in ppcg.c is
+ * {whole_component: 0, maximize_band_depth: 1, maximize_coincidence: 1}.
+ */
+struct autosa_sched_config
+{
+  int whole_component;
+  int maximize_band_depth;
+  int maximize_coincidence;
+  int outer_coincidence;
+  int serialize_sccs;
+};
+
+static struct autosa_sched_config autosa_sched_configs[] = {
+    {1, 1, 1, 0, 0},
+    {0, 0, 1, 0, 0},
+    {0, 1, 0, 1, 0},
+    {1, 0, 0, 1, 0},
+    {0, 1, 1, 0, 1}};
+
+/* Compute a schedule under the scheduler configuration "config" and
+ * write it to the file "path". Executed inside a worker process.
+ */
+static int save_schedule_under_config(struct autosa_gen *gen,
+                                      struct autosa_sched_config *config, const char *path)
+{
+  isl_schedule *schedule;
+  isl_printer *p;
+  FILE *fp;
+
+  isl_options_set_schedule_whole_component(gen->ctx, config->whole_component);
+  isl_options_set_schedule_maximize_band_depth(gen->ctx, config->maximize_band_depth);
+  isl_options_set_schedule_maximize_coincidence(gen->ctx, config->maximize_coincidence);
+  isl_options_set_schedule_outer_coincidence(gen->ctx, config->outer_coincidence);
+  isl_options_set_schedule_serialize_sccs(gen->ctx, config->serialize_sccs);
+
+  schedule = compute_schedule(gen);
+  if (!schedule)
+    return -1;
+  schedule = merge_outer_bands(schedule, gen);
+
+  fp = fopen(path, "w");
+  if (!fp)
+  {
+    isl_schedule_free(schedule);
+    return -1;
+  }
+  p = isl_printer_to_file(gen->ctx, fp);
+  p = isl_printer_set_yaml_style(p, ISL_YAML_STYLE_BLOCK);
+  p = isl_printer_print_schedule(p, schedule);
+  isl_printer_free(p);
+  fclose(fp);
+  isl_schedule_free(schedule);
+
+  return 0;
+}
+
+/* Compute alternative schedules of the program using the scheduler
+ * configurations in autosa_sched_configs.
+ * The ISL scheduler may take a long time on some programs, therefore,
+ * each configuration is evaluated in a separate worker process.
+ * Each worker dumps the schedule into the output directory and the
+ * schedules are read back once all the workers finish.
+ * Workers that fail are skipped.
+ * The number of schedules is returned in "n_schedule".
+ */
+isl_schedule **explore_schedules(struct autosa_gen *gen, int *n_schedule)
+{
+  int n_config = sizeof(autosa_sched_configs) / sizeof(struct autosa_sched_config);
+  pid_t *pids;
+  char **paths;
+  isl_schedule **schedules = NULL;
+
+  *n_schedule = 0;
+  pids = (pid_t *)malloc(n_config * sizeof(pid_t));
+  paths = (char **)malloc(n_config * sizeof(char *));
+  fflush(stdout);
+  for (int i = 0; i < n_config; i++)
+  {
+    isl_printer *p_str = isl_printer_to_str(gen->ctx);
+    p_str = isl_printer_print_str(p_str, gen->options->autosa->output_dir);
+    p_str = isl_printer_print_str(p_str, "/schedule_");
+    p_str = isl_printer_print_int(p_str, i);
+    p_str = isl_printer_print_str(p_str, ".yaml");
+    paths[i] = isl_printer_get_str(p_str);
+    isl_printer_free(p_str);
+
+    pids[i] = fork();
+    if (pids[i] == 0)
+    {
+      /* Worker process */
+      int r = save_schedule_under_config(gen, &autosa_sched_configs[i], paths[i]);
+      _exit(r < 0 ? 1 : 0);
+    }
+    else if (pids[i] < 0)
+    {
+      printf("[AutoSA] Warning: Failed to launch scheduler worker %d.\n", i);
+    }
+  }
+
+  for (int i = 0; i < n_config; i++)
+  {
+    int status;
+    FILE *fp;
+    isl_schedule *schedule;
+
+    if (pids[i] < 0)
+    {
+      free(paths[i]);
+      continue;
+    }
+    if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0)
+    {
+      if (gen->options->autosa->verbose)
+        printf("[AutoSA] Scheduler worker %d failed.\n", i);
+      remove(paths[i]);
+      free(paths[i]);
+      continue;
+    }
+    fp = fopen(paths[i], "r");
+    schedule = fp ? isl_schedule_read_from_file(gen->ctx, fp) : NULL;
+    if (fp)
+      fclose(fp);
+    remove(paths[i]);
+    free(paths[i]);
+    if (!schedule)
+      continue;
+    schedules = (isl_schedule **)realloc(schedules,
+                                         (*n_schedule + 1) * sizeof(isl_schedule *));
+    schedules[*n_schedule] = schedule;
+    *n_schedule = *n_schedule + 1;
+  }
+
+  free(pids);
+  free(paths);
+
+  return schedules;
+}
+
 /* Since we are merging for the outermost band node, 
  * we will check if for each validity constraint if the domain is lexicographically 
  * less or equal to the range. 
@@ -2263,6 +2740,108 @@ static isl_bool is_dep_non_neg_at_node(
   return (i == n) ? isl_bool_true : isl_bool_false;
 }
 
+/* Apply the classical part of hybrid tiling to the outer bands of 
+ * the schedule as a pre-pass of the space-time transformation.
+ * If the outermost band and its child form the input pattern of hybrid
+ * tiling, i.e., a single time loop followed by a band of coincident 
+ * space loops, as it is typically the case for time-iterated stencils,
+ * the bounds on the relative dependence distances
+ *
+ *   d_i >= -lower_i d_0
+ *
+ * are computed as for hybrid tiling and each space loop s_i is skewed to
+ * s_i + ceil(lower_i) t. All the dependence distances in the skewed 
+ * space loops are then non-negative, such that merge_outer_bands 
+ * merges the time loop and the space loops into a single permutable band.
+ * The space-time transformation can then pick the time loop as a space loop
+ * and array partitioning tiles the time loop, producing arrays that keep 
+ * the data on-chip across the time steps of each tile.
+ * The hexagonal part of hybrid tiling is not applied, since the two phases
+ * it introduces break the single permutable band required by AutoSA.
+ * The schedule is returned unmodified if the input pattern is not found
+ * or no bounds exist.
+ */
+__isl_give isl_schedule *hybrid_tile_outer_bands(__isl_take isl_schedule *schedule, struct autosa_gen *gen)
+{
+  isl_schedule_node *node;
+  isl_bool has_pattern;
+  ppcg_ht_bounds *bounds;
+  isl_multi_union_pw_aff *time, *space;
+  isl_union_pw_aff *time_upa;
+  int n, skewed = 0;
+
+  node = isl_schedule_get_root(schedule);
+  node = isl_schedule_node_child(node, 0);
+  has_pattern = ppcg_ht_has_input_pattern(node);
+  if (has_pattern <= 0)
+  {
+    isl_schedule_node_free(node);
+    return schedule;
+  }
+
+  bounds = ppcg_ht_compute_bounds(gen->prog->scop, node);
+  time = isl_schedule_node_band_get_partial_schedule(node);
+  time_upa = isl_multi_union_pw_aff_get_union_pw_aff(time, 0);
+  isl_multi_union_pw_aff_free(time);
+  node = isl_schedule_node_child(node, 0);
+  space = isl_schedule_node_band_get_partial_schedule(node);
+  n = isl_schedule_node_band_n_member(node);
+
+  for (int i = 0; i < n; i++)
+  {
+    isl_val *lower = ppcg_ht_bounds_get_lower(bounds, i);
+    if (!lower || isl_val_is_nan(lower))
+    {
+      isl_val_free(lower);
+      skewed = -1;
+      break;
+    }
+    lower = isl_val_ceil(lower);
+    if (!isl_val_is_zero(lower))
+    {
+      isl_union_pw_aff *upa = isl_multi_union_pw_aff_get_union_pw_aff(space, i);
+      upa = isl_union_pw_aff_add(upa, isl_union_pw_aff_scale_val(
+                                          isl_union_pw_aff_copy(time_upa), isl_val_copy(lower)));
+      space = isl_multi_union_pw_aff_set_union_pw_aff(space, i, upa);
+      skewed = 1;
+      if (gen->options->autosa->verbose)
+      {
+        printf("[AutoSA] Skew space loop %d by %ld times the time loop.\n",
+               i, isl_val_get_num_si(lower));
+      }
+    }
+    isl_val_free(lower);
+  }
+  isl_union_pw_aff_free(time_upa);
+  ppcg_ht_bounds_free(bounds);
+
+  if (skewed <= 0)
+  {
+    if (skewed < 0)
+      printf("[AutoSA] Warning: No bounds on the dependence distances found for hybrid tiling.\n");
+    isl_multi_union_pw_aff_free(space);
+    isl_schedule_node_free(node);
+    return schedule;
+  }
+  isl_schedule_free(schedule);
+
+  /* Replace the space band by the skewed one. */
+  int *coincident = (int *)malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++)
+    coincident[i] = isl_schedule_node_band_member_get_coincident(node, i);
+  node = isl_schedule_node_delete(node);
+  node = isl_schedule_node_insert_partial_schedule(node, space);
+  node = isl_schedule_node_band_set_permutable(node, 1);
+  for (int i = 0; i < n; i++)
+    node = isl_schedule_node_band_member_set_coincident(node, i, coincident[i]);
+  free(coincident);
+
+  schedule = isl_schedule_node_get_schedule(node);
+  isl_schedule_node_free(node);
+
+  return schedule;
+}
+
 /* Try to merge the outer bands of the schedule as much as possible as 
  * long as they can form a permutable band.
  * Start from the outermost band, if the dependence distance on the current band 
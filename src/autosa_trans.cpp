@@ -3,16 +3,280 @@
 //#include <chrono>
 //using namespace std::chrono;
 
+#include <barvinok/isl.h>
+
 #include "autosa_trans.h"
 #include "autosa_utils.h"
 #include "autosa_schedule_tree.h"
 #include "autosa_comm.h"
 #include "autosa_codegen.h"
 
+/* Test if the tagged dependence "map" is uniform under "schedule". */
+static isl_bool is_tagged_dep_uniform(__isl_keep isl_map *map,
+                                      __isl_keep isl_schedule *schedule)
+{
+    isl_bool is_uniform = isl_bool_true;
+    isl_map *untagged = isl_map_factor_domain(isl_map_copy(map));
+    isl_basic_map_list *bmap_list = isl_map_get_basic_map_list(untagged);
+
+    for (int i = 0; i < isl_map_n_basic_map(untagged); i++)
+    {
+        isl_basic_map *bmap = isl_basic_map_list_get_basic_map(bmap_list, i);
+        if (isl_basic_map_is_empty(bmap))
+        {
+            isl_basic_map_free(bmap);
+            continue;
+        }
+        is_uniform = is_dep_uniform(bmap, schedule);
+        if (is_uniform != isl_bool_true)
+            break;
+    }
+
+    isl_basic_map_list_free(bmap_list);
+    isl_map_free(untagged);
+    return is_uniform;
+}
+
+/* Internal data struct used for sa_uniformize_deps. */
+struct sa_uniformize_data
+{
+    isl_schedule *schedule;
+    /* Schedule map of the statement instances */
+    isl_union_map *sched;
+    /* Tagged read accesses */
+    isl_union_map *reads;
+    /* Updated tagged flow dependences */
+    isl_union_map *flow;
+    /* Updated tagged RAR dependences, including the propagation dependences 
+     * among the readers */
+    isl_union_map *rar;
+    int n_uniformized;
+};
+
+/* Return the relation between the tagged statement instances in the 
+ * wrapped space "space" that are executed in order under the schedule 
+ * map "sched", i.e., { [S[i] -> ref[]] -> [S[j] -> ref[]] : S[i] << S[j] }
+ * where << is the lexicographic order of the schedule.
+ */
+static __isl_give isl_map *tagged_sched_lex_lt(__isl_take isl_space *space,
+                                               __isl_keep isl_union_map *sched)
+{
+    isl_map *untag, *time;
+    isl_union_map *umap;
+
+    untag = isl_map_domain_map(isl_set_unwrap(isl_set_universe(space)));
+    umap = isl_union_map_apply_range(isl_union_map_from_map(untag),
+                                     isl_union_map_copy(sched));
+    time = isl_map_from_union_map(umap);
+
+    return isl_map_lex_lt_map(isl_map_copy(time), time);
+}
+
+/* Given the pairs of readers of the same value "pairs" that are ordered 
+ * by the schedule, return the relation between each reader and its 
+ * immediate successor, i.e., remove the pairs with another reader 
+ * executed in between.
+ */
+static __isl_give isl_map *next_reader(__isl_take isl_map *pairs)
+{
+    isl_map *skip;
+
+    skip = isl_map_apply_range(isl_map_copy(pairs), isl_map_copy(pairs));
+    return isl_map_subtract(pairs, skip);
+}
+
+/* Return isl_bool_true if the dependence "dep" is still enforced after being
+ * replaced by "first" followed by the propagation dependences "chain",
+ * i.e., each pair of "dep" is connected by "first" and zero or more steps
+ * of "chain". If "first" is NULL, at least one step of "chain" is required.
+ * The transitive closure of "chain" is required to be exact, so that
+ * an overapproximation does not hide a missing pair.
+ */
+static isl_bool is_dep_enforced(__isl_keep isl_map *dep,
+                                __isl_keep isl_map *first, __isl_keep isl_map *chain)
+{
+    isl_map *closure, *reach;
+    isl_bool exact, covered;
+
+    closure = isl_map_transitive_closure(isl_map_copy(chain), &exact);
+    if (exact != isl_bool_true)
+    {
+        isl_map_free(closure);
+        return exact < 0 ? isl_bool_error : isl_bool_false;
+    }
+    if (first)
+    {
+        reach = isl_map_apply_range(isl_map_copy(first), closure);
+        reach = isl_map_union(reach, isl_map_copy(first));
+    }
+    else
+    {
+        reach = closure;
+    }
+    covered = isl_map_is_subset(dep, reach);
+    isl_map_free(reach);
+
+    return covered;
+}
+
+/* Uniformize the tagged flow dependence "map" if it is not uniform.
+ * A non-uniform flow dependence usually comes from a broadcast, where 
+ * the value produced by one statement instance is consumed by many readers.
+ * We pipeline the broadcast by replacing the dependence with:
+ * - a flow dependence from the writer to its first reader, and 
+ * - a propagation dependence from each reader to the next reader of the 
+ *   same value, which is added as a RAR dependence.
+ * The first and next readers are determined by the execution order 
+ * under the schedule.
+ * The value is then forwarded among the readers, i.e., a propagation 
+ * variable is introduced at the readers.
+ * The transformation is only applied if both new dependences are uniform,
+ * and every reader is still ordered after the writer through them.
+ */
+static isl_stat uniformize_flow_dep(__isl_take isl_map *map, void *user)
+{
+    struct sa_uniformize_data *data = (struct sa_uniformize_data *)user;
+    isl_map *lt, *later, *first, *pairs, *chain;
+
+    if (is_tagged_dep_uniform(map, data->schedule) == isl_bool_true)
+    {
+        data->flow = isl_union_map_union(data->flow, isl_union_map_from_map(map));
+        return isl_stat_ok;
+    }
+
+    lt = tagged_sched_lex_lt(isl_space_range(isl_map_get_space(map)), data->sched);
+    /* Flow dependence to the first reader, i.e., the readers with 
+     * no earlier reader of the same value. */
+    later = isl_map_apply_range(isl_map_copy(map), isl_map_copy(lt));
+    first = isl_map_subtract(isl_map_copy(map), later);
+    /* Pairs of readers of the same value. */
+    pairs = isl_map_apply_range(isl_map_reverse(isl_map_copy(map)), isl_map_copy(map));
+    pairs = isl_map_intersect(pairs, lt);
+    chain = next_reader(pairs);
+
+    if (is_tagged_dep_uniform(first, data->schedule) == isl_bool_true &&
+        is_tagged_dep_uniform(chain, data->schedule) == isl_bool_true &&
+        is_dep_enforced(map, first, chain) == isl_bool_true)
+    {
+        data->flow = isl_union_map_union(data->flow, isl_union_map_from_map(first));
+        data->rar = isl_union_map_union(data->rar, isl_union_map_from_map(chain));
+        data->n_uniformized++;
+        isl_map_free(map);
+    }
+    else
+    {
+        data->flow = isl_union_map_union(data->flow, isl_union_map_from_map(map));
+        isl_map_free(first);
+        isl_map_free(chain);
+    }
+
+    return isl_stat_ok;
+}
+
+/* Uniformize the tagged RAR dependence "map" if it is not uniform.
+ * A non-uniform RAR dependence comes from a broadcast read, where the 
+ * same array element is read by many instances of the same reference.
+ * We replace the dependence with the propagation dependence from each 
+ * reader to the next reader of the same array element under the schedule, 
+ * restricted to the readers involved in "map".
+ * The transformation is only applied if the new dependence is uniform
+ * and still orders every pair of readers in "map".
+ * Dependences between different references are left untouched.
+ */
+static isl_stat uniformize_rar_dep(__isl_take isl_map *map, void *user)
+{
+    struct sa_uniformize_data *data = (struct sa_uniformize_data *)user;
+    isl_map *access, *pairs, *chain;
+    isl_union_map *umap;
+    isl_space *space;
+
+    space = isl_map_get_space(map);
+    if (is_tagged_dep_uniform(map, data->schedule) == isl_bool_true ||
+        isl_space_tuple_is_equal(space, isl_dim_in, space, isl_dim_out) != isl_bool_true)
+    {
+        isl_space_free(space);
+        data->rar = isl_union_map_union(data->rar, isl_union_map_from_map(map));
+        return isl_stat_ok;
+    }
+
+    /* Pairs of readers of the same array element. */
+    umap = isl_union_map_intersect_domain(isl_union_map_copy(data->reads),
+                                          isl_union_set_from_set(isl_map_domain(isl_map_copy(map))));
+    access = isl_map_from_union_map(umap);
+    pairs = isl_map_apply_range(isl_map_copy(access), isl_map_reverse(access));
+    pairs = isl_map_intersect(pairs,
+                              tagged_sched_lex_lt(isl_space_domain(space), data->sched));
+    pairs = isl_map_intersect_range(pairs, isl_map_range(isl_map_copy(map)));
+    chain = next_reader(pairs);
+
+    if (isl_map_is_empty(chain) == isl_bool_false &&
+        is_tagged_dep_uniform(chain, data->schedule) == isl_bool_true &&
+        is_dep_enforced(map, NULL, chain) == isl_bool_true)
+    {
+        data->rar = isl_union_map_union(data->rar, isl_union_map_from_map(chain));
+        data->n_uniformized++;
+        isl_map_free(map);
+    }
+    else
+    {
+        data->rar = isl_union_map_union(data->rar, isl_union_map_from_map(map));
+        isl_map_free(chain);
+    }
+
+    return isl_stat_ok;
+}
+
+/* Convert the non-uniform flow and RAR dependences of "scop" into uniform 
+ * ones by pipelining the broadcasts. See uniformize_flow_dep and 
+ * uniformize_rar_dep for details.
+ * Return the number of uniformized dependences.
+ */
+static int sa_uniformize_deps(__isl_keep isl_schedule *schedule, struct ppcg_scop *scop)
+{
+    struct sa_uniformize_data data;
+    isl_space *space = isl_union_map_get_space(scop->tagged_dep_flow);
+
+    data.schedule = schedule;
+    data.sched = isl_schedule_get_map(schedule);
+    data.reads = scop->tagged_reads;
+    data.flow = isl_union_map_empty(isl_space_copy(space));
+    data.rar = isl_union_map_empty(space);
+    data.n_uniformized = 0;
+    isl_union_map_foreach_map(scop->tagged_dep_flow, &uniformize_flow_dep, &data);
+    isl_union_map_foreach_map(scop->tagged_dep_rar, &uniformize_rar_dep, &data);
+    isl_union_map_free(data.sched);
+
+    if (data.n_uniformized > 0)
+    {
+        if (scop->options->autosa->verbose)
+        {
+            printf("[AutoSA] %d non-uniform dependences uniformized.\n",
+                   data.n_uniformized);
+        }
+        isl_union_map_free(scop->tagged_dep_flow);
+        scop->tagged_dep_flow = data.flow;
+        isl_union_map_free(scop->dep_flow);
+        scop->dep_flow = isl_union_map_factor_domain(isl_union_map_copy(scop->tagged_dep_flow));
+        isl_union_map_free(scop->tagged_dep_rar);
+        scop->tagged_dep_rar = data.rar;
+        isl_union_map_free(scop->dep_rar);
+        scop->dep_rar = isl_union_map_factor_domain(isl_union_map_copy(scop->tagged_dep_rar));
+    }
+    else
+    {
+        isl_union_map_free(data.flow);
+        isl_union_map_free(data.rar);
+    }
+
+    return data.n_uniformized;
+}
+
 /* A program is legal to be transformed to systolic array if and only if 
  * it satisfies the following constraints:
  * - one single fully permutable outermost band
  * - uniform dependency
+ * Non-uniform flow dependences caused by broadcasts are uniformized 
+ * before the check fails.
  */
 isl_bool sa_legality_check(__isl_keep isl_schedule *schedule, struct ppcg_scop *scop)
 {
@@ -35,6 +299,13 @@ isl_bool sa_legality_check(__isl_keep isl_schedule *schedule, struct ppcg_scop *
     /* Check if all flow and rar dependences are uniform. */
     isl_bool all_uniform_dep = uniform_dep_check(schedule, scop);
     if (all_uniform_dep < 1)
+    {
+        if (scop->options->autosa->verbose)
+            printf("[AutoSA] Non-uniform dependence detected. Try to uniformize the dependences.\n");
+        if (sa_uniformize_deps(schedule, scop) > 0)
+            all_uniform_dep = uniform_dep_check(schedule, scop);
+    }
+    if (all_uniform_dep < 1)
     {
         throw std::runtime_error("[AutoSA] Error: Non-uniform dependence detected.");
     }    
@@ -80,16 +351,28 @@ static cJSON *load_tuning_config(char *config_file)
     return config;
 }
 
+/* Return true if "space_pos" is negative or is one of the space loops 
+ * "i", "j", and "k".
+ */
+static int is_space_pos_covered(int space_pos, int i, int j, int k)
+{
+    if (space_pos < 0)
+        return 1;
+    return space_pos == i || space_pos == j || space_pos == k;
+}
+
 /* Generate asyncrhonized systolic arrays with the given dimension.
  * For sync arrays, time loops are placed inside the space loops.
  * We will first select space loop candidates from the outermost loop band 
  * which carry dependences with distance less than or equal to 1. 
  * Then we will enumerate different space loop combinations by picking up "dim" 
  * space loops from the candidate pool.
+ * If "space_pos" is non-negative, only the combinations that contain the loop 
+ * at "space_pos" are generated.
  */
 struct autosa_kernel **sa_space_time_transform_at_dim_async(
     __isl_keep isl_schedule *schedule, struct ppcg_scop *scop,
-    isl_size dim, isl_size *num_sa)
+    isl_size dim, int space_pos, isl_size *num_sa)
 {
     struct autosa_kernel **sas = NULL;
 
@@ -107,26 +390,32 @@ struct autosa_kernel **sa_space_time_transform_at_dim_async(
     isl_size ndeps = isl_union_map_n_basic_map(dep_total);
 
     for (int h = 0; h < band_w; h++)
+        is_space_loop[h] = 1;
+    /* The distance vector is computed once per dependence and is memoized 
+     * for the later passes. */
+    for (int n = 0; n < ndeps; n++)
     {
-        int n;
-        for (n = 0; n < ndeps; n++)
+        isl_basic_map *dep = isl_basic_map_list_get_basic_map(deps, n);
+        isl_vec *dep_dis = autosa_get_dep_dis_at_node(scop, dep, band);
+        if (!dep_dis)
+        {
+            /* The distance is unknown, no loop can be safely used 
+             * as a space loop. */
+            for (int h = 0; h < band_w; h++)
+                is_space_loop[h] = 0;
+            isl_basic_map_free(dep);
+            continue;
+        }
+        for (int h = 0; h < band_w; h++)
         {
-            isl_basic_map *dep = isl_basic_map_list_get_basic_map(deps, n);
-            isl_vec *dep_dis = get_dep_dis_at_node(dep, band);
             isl_val *val = isl_vec_get_element_val(dep_dis, h);
-            if (!(isl_val_is_one(val) || isl_val_is_zero(val)))
-            {
-                isl_vec_free(dep_dis);
-                isl_val_free(val);
-                isl_basic_map_free(dep);
-                break;
-            }
-
+            if (isl_val_is_one(val) != isl_bool_true &&
+                isl_val_is_zero(val) != isl_bool_true)
+                is_space_loop[h] = 0;
             isl_val_free(val);
-            isl_vec_free(dep_dis);
-            isl_basic_map_free(dep);
         }
-        is_space_loop[h] = (n == ndeps);
+        isl_vec_free(dep_dis);
+        isl_basic_map_free(dep);
     }
 
     /* Perform loop permutation to generate all candidates. */
@@ -134,7 +423,7 @@ struct autosa_kernel **sa_space_time_transform_at_dim_async(
     {
         for (int i = 0; i < band_w; i++)
         {
-            if (is_space_loop[i])
+            if (is_space_loop[i] && is_space_pos_covered(space_pos, i, -1, -1))
             {
                 isl_schedule *new_schedule = isl_schedule_dup(schedule);
                 isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
@@ -176,7 +465,7 @@ struct autosa_kernel **sa_space_time_transform_at_dim_async(
             {
                 for (int j = i + 1; j < band_w; j++)
                 {
-                    if (is_space_loop[j])
+                    if (is_space_loop[j] && is_space_pos_covered(space_pos, i, j, -1))
                     {
                         isl_schedule *new_schedule = isl_schedule_dup(schedule);
                         isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
@@ -234,7 +523,7 @@ struct autosa_kernel **sa_space_time_transform_at_dim_async(
                     {
                         for (int k = j + 1; k < band_w; k++)
                         {
-                            if (is_space_loop[k])
+                            if (is_space_loop[k] && is_space_pos_covered(space_pos, i, j, k))
                             {
                                 isl_schedule *new_schedule = isl_schedule_dup(schedule);
                                 isl_schedule_node *band = get_outermost_permutable_node(new_schedule);
@@ -304,10 +593,12 @@ struct autosa_kernel **sa_space_time_transform_at_dim_async(
  * which carry dependences with distance less than or equal to 1. 
  * Then we will enumerate different space loop combinations by picking up "dim" 
  * space loops from the candidate pool.
+ * If "space_pos" is non-negative, only the combinations that contain the loop 
+ * at "space_pos" are generated.
  */
 struct autosa_kernel **sa_space_time_transform_at_dim_sync(
     __isl_keep isl_schedule *schedule, struct ppcg_scop *scop,
-    isl_size dim, isl_size *num_sa)
+    isl_size dim, int space_pos, isl_size *num_sa)
 {
     struct autosa_kernel **sas = NULL;
 
@@ -325,26 +616,32 @@ struct autosa_kernel **sa_space_time_transform_at_dim_sync(
     isl_size ndeps = isl_union_map_n_basic_map(dep_total);
 
     for (int h = 0; h < band_w; h++)
+        is_space_loop[h] = 1;
+    /* The distance vector is computed once per dependence and is memoized 
+     * for the later passes. */
+    for (int n = 0; n < ndeps; n++)
     {
-        int n;
-        for (n = 0; n < ndeps; n++)
+        isl_basic_map *dep = isl_basic_map_list_get_basic_map(deps, n);
+        isl_vec *dep_dis = autosa_get_dep_dis_at_node(scop, dep, band);
+        if (!dep_dis)
+        {
+            /* The distance is unknown, no loop can be safely used 
+             * as a space loop. */
+            for (int h = 0; h < band_w; h++)
+                is_space_loop[h] = 0;
+            isl_basic_map_free(dep);
+            continue;
+        }
+        for (int h = 0; h < band_w; h++)
         {
-            isl_basic_map *dep = isl_basic_map_list_get_basic_map(deps, n);
-            isl_vec *dep_dis = get_dep_dis_at_node(dep, band);
             isl_val *val = isl_vec_get_element_val(dep_dis, h);
-            if (!(isl_val_is_one(val) || isl_val_is_zero(val)))
-            {
-                isl_vec_free(dep_dis);
-                isl_val_free(val);
-                isl_basic_map_free(dep);
-                break;
-            }
-
+            if (isl_val_is_one(val) != isl_bool_true &&
+                isl_val_is_zero(val) != isl_bool_true)
+                is_space_loop[h] = 0;
             isl_val_free(val);
-            isl_vec_free(dep_dis);
-            isl_basic_map_free(dep);
         }
-        is_space_loop[h] = (n == ndeps);
+        isl_vec_free(dep_dis);
+        isl_basic_map_free(dep);
     }
 
     /* Perform loop permutation to generate all candidates. */
@@ -352,7 +649,7 @@ struct autosa_kernel **sa_space_time_transform_at_dim_sync(
     {
         for (int i = 0; i < band_w; i++)
         {
-            if (is_space_loop[i])
+            if (is_space_loop[i] && is_space_pos_covered(space_pos, i, -1, -1))
             {
                 isl_schedule *new_schedule = isl_schedule_dup(schedule);
                 isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
@@ -397,7 +694,7 @@ struct autosa_kernel **sa_space_time_transform_at_dim_sync(
             {
                 for (int j = i + 1; j < band_w; j++)
                 {
-                    if (is_space_loop[j])
+                    if (is_space_loop[j] && is_space_pos_covered(space_pos, i, j, -1))
                     {
                         isl_schedule *new_schedule = isl_schedule_dup(schedule);
                         isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
@@ -455,7 +752,7 @@ struct autosa_kernel **sa_space_time_transform_at_dim_sync(
                     {
                         for (int k = j + 1; k < band_w; k++)
                         {
-                            if (is_space_loop[k])
+                            if (is_space_loop[k] && is_space_pos_covered(space_pos, i, j, k))
                             {
                                 isl_schedule *new_schedule = isl_schedule_dup(schedule);
                                 isl_schedule_node *band = get_innermost_permutable_node(new_schedule);
@@ -528,16 +825,184 @@ struct autosa_kernel **sa_space_time_transform_at_dim(
 {
     if (scop->options->autosa->sa_type == AUTOSA_SA_TYPE_ASYNC)
     {
-        return sa_space_time_transform_at_dim_async(schedule, scop, dim, num_sa);
+        return sa_space_time_transform_at_dim_async(schedule, scop, dim, -1, num_sa);
     }
     else if (scop->options->autosa->sa_type == AUTOSA_SA_TYPE_SYNC)
     {
-        return sa_space_time_transform_at_dim_sync(schedule, scop, dim, num_sa);
+        return sa_space_time_transform_at_dim_sync(schedule, scop, dim, -1, num_sa);
     }
 
     return NULL;
 }
 
+static void sa_candidates_rank_by_utilization(struct autosa_kernel **sa_list,
+                                              isl_size num_sa);
+
+/* Return true if skewing loop "i" by "f" times loop "j" is legal, i.e., 
+ * all the dependence distances "dis" at loop "i" become 0 or 1.
+ * "coincident" is set to 1 if all the skewed dependence distances are 0.
+ */
+static int is_legal_skewing(int *dis, int ndeps, int band_w, int i, int j,
+                            int f, int *coincident)
+{
+    *coincident = 1;
+    for (int n = 0; n < ndeps; n++)
+    {
+        int d = dis[n * band_w + i] + f * dis[n * band_w + j];
+        if (d != 0 && d != 1)
+            return 0;
+        if (d != 0)
+            *coincident = 0;
+    }
+
+    return 1;
+}
+
+/* Generate systolic array candidates with skewed space loops.
+ * Space loops are required to carry dependences with distance 0 or 1.
+ * For each loop "i" in the band that is not a space loop candidate, we look 
+ * for all the unimodular skewings loop[i] + f * loop[j] that bring all the 
+ * dependence distances at loop "i" to 0 or 1, which also keeps the band 
+ * permutable. The skewing factor "f" is solved from the first dependence 
+ * with a non-zero distance at loop "j", i.e., d_i + f * d_j is either 0 or 1, 
+ * and is then checked against all the other dependences.
+ * For each legal skewing, we enumerate the systolic arrays that use the 
+ * skewed loop as one of the space loops.
+ * The generated candidates are ranked by the PE utilization first, then by 
+ * the I/O volume per time step.
+ */
+static struct autosa_kernel **sa_space_time_transform_skewed(
+    __isl_keep isl_schedule *schedule, struct ppcg_scop *scop, isl_size *num_sa)
+{
+    struct autosa_kernel **sas = NULL;
+    int is_async = scop->options->autosa->sa_type == AUTOSA_SA_TYPE_ASYNC;
+    isl_schedule_node *band;
+    isl_size band_w;
+    int known = 1;
+
+    *num_sa = 0;
+    if (is_async)
+        band = get_outermost_permutable_node(schedule);
+    else
+        band = get_innermost_permutable_node(schedule);
+    band_w = isl_schedule_node_band_n_member(band);
+
+    isl_union_map *dep_total = isl_union_map_union(isl_union_map_copy(scop->dep_flow),
+                                                   isl_union_map_copy(scop->dep_rar));
+    isl_basic_map_list *deps = isl_union_map_get_basic_map_list(dep_total);
+    isl_size ndeps = isl_union_map_n_basic_map(dep_total);
+
+    /* Collect the dependence distances. */
+    int *dis = (int *)malloc(ndeps * band_w * sizeof(int));
+    for (int n = 0; n < ndeps && known; n++)
+    {
+        isl_basic_map *dep = isl_basic_map_list_get_basic_map(deps, n);
+        isl_vec *dep_dis = autosa_get_dep_dis_at_node(scop, dep, band);
+        if (!dep_dis)
+            known = 0;
+        for (int h = 0; h < band_w && dep_dis; h++)
+        {
+            isl_val *val = isl_vec_get_element_val(dep_dis, h);
+            dis[n * band_w + h] = isl_val_get_num_si(val);
+            isl_val_free(val);
+        }
+        isl_vec_free(dep_dis);
+        isl_basic_map_free(dep);
+    }
+
+    for (int i = 0; i < band_w && known; i++)
+    {
+        int is_space_loop = 1;
+        for (int n = 0; n < ndeps; n++)
+        {
+            if (dis[n * band_w + i] != 0 && dis[n * band_w + i] != 1)
+                is_space_loop = 0;
+        }
+        if (is_space_loop)
+            continue;
+
+        for (int j = 0; j < band_w; j++)
+        {
+            int pivot = -1;
+            int factors[2];
+            int n_factor = 0;
+
+            if (j == i)
+                continue;
+            for (int n = 0; n < ndeps; n++)
+            {
+                if (dis[n * band_w + j] != 0)
+                {
+                    pivot = n;
+                    break;
+                }
+            }
+            if (pivot < 0)
+                continue;
+            /* Solve d_i + f * d_j = 0 or 1 at the pivot dependence. */
+            for (int target = 0; target <= 1; target++)
+            {
+                int num = target - dis[pivot * band_w + i];
+                int den = dis[pivot * band_w + j];
+                if (num % den == 0 && num / den != 0)
+                    factors[n_factor++] = num / den;
+            }
+
+            for (int f = 0; f < n_factor; f++)
+            {
+                int coincident;
+                if (!is_legal_skewing(dis, ndeps, band_w, i, j, factors[f], &coincident))
+                    continue;
+
+                if (scop->options->autosa->verbose)
+                {
+                    printf("[AutoSA] Skew loop %d by loop %d with factor %d.\n",
+                           i, j, factors[f]);
+                }
+                isl_schedule *new_schedule = isl_schedule_dup(schedule);
+                isl_schedule_node *new_band;
+                if (is_async)
+                    new_band = get_outermost_permutable_node(new_schedule);
+                else
+                    new_band = get_innermost_permutable_node(new_schedule);
+                isl_schedule_free(new_schedule);
+                new_band = loop_skewing_at_node(new_band, i, j, factors[f], coincident);
+                new_schedule = isl_schedule_node_get_schedule(new_band);
+                isl_schedule_node_free(new_band);
+
+                for (int dim = 1; dim <= scop->options->autosa->max_sa_dim && dim <= 3 && dim <= band_w; dim++)
+                {
+                    isl_size n_sa_dim = 0;
+                    struct autosa_kernel **sa_dim_list;
+                    if (is_async)
+                        sa_dim_list = sa_space_time_transform_at_dim_async(
+                            new_schedule, scop, dim, i, &n_sa_dim);
+                    else
+                        sa_dim_list = sa_space_time_transform_at_dim_sync(
+                            new_schedule, scop, dim, i, &n_sa_dim);
+                    sas = (struct autosa_kernel **)realloc(sas,
+                                                           (*num_sa + n_sa_dim) * sizeof(struct autosa_kernel *));
+                    for (int k = 0; k < n_sa_dim; k++)
+                        sas[*num_sa + k] = sa_dim_list[k];
+                    free(sa_dim_list);
+                    *num_sa = *num_sa + n_sa_dim;
+                }
+                isl_schedule_free(new_schedule);
+            }
+        }
+    }
+
+    free(dis);
+    isl_basic_map_list_free(deps);
+    isl_union_map_free(dep_total);
+    isl_schedule_node_free(band);
+
+    if (*num_sa > 1)
+        sa_candidates_rank_by_utilization(sas, *num_sa);
+
+    return sas;
+}
+
 /* Apply space-time transformation to generate different systolic array candidates. */
 struct autosa_kernel **sa_space_time_transform(__isl_take isl_schedule *schedule,
                                                struct ppcg_scop *scop, isl_size *num_sa)
@@ -628,6 +1093,30 @@ struct autosa_kernel **sa_space_time_transform(__isl_take isl_schedule *schedule
         free(sa_dim_list);
         n_sa += n_sa_dim;
     }
+    /* Explore systolic arrays with skewed space loops */
+    if (scop->options->autosa->sa_skew)
+    {
+        if (scop->options->autosa->verbose)
+        {
+            printf("[AutoSA] Explore skewed systolic array.\n");
+        }
+        isl_size n_sa_skew = 0;
+        struct autosa_kernel **sa_skew_list = sa_space_time_transform_skewed(
+            schedule, scop, &n_sa_skew);
+        if (scop->options->autosa->verbose)
+        {
+            printf("[AutoSA] %d candidates generated.\n", n_sa_skew);
+        }
+        sa_list = (struct autosa_kernel **)realloc(sa_list,
+                                                   (n_sa + n_sa_skew) * sizeof(struct autosa_kernel *));
+        for (int i = 0; i < n_sa_skew; i++)
+        {
+            sa_list[n_sa + i] = sa_skew_list[i];
+            sa_list[n_sa + i]->space_time_id = n_sa + i;
+        }
+        free(sa_skew_list);
+        n_sa += n_sa_skew;
+    }
 
     isl_schedule_free(schedule);
     isl_schedule_node_free(band);
@@ -716,12 +1205,24 @@ isl_stat sa_space_time_loop_setup(struct autosa_kernel *sa)
     return isl_stat_ok;
 }
 
-/* Internal struct used for sa_candidates_smart_pick. */
+/* Internal struct used for sa_candidates_smart_pick. 
+ * "io_volume" estimates the number of data elements loaded from outside 
+ * of the array at each time step. 
+ * "n_io_port" is the number of dependences that require off-chip data.
+ * "reuse" is the number of dependences served on-chip, i.e., forwarded 
+ * between PEs or kept inside PEs.
+ * "extent" is the extent of each space loop and "n_pe" is the number of PEs.
+ */
 struct sa_candidates_smart_pick_update_data
 {
     int score;
     struct autosa_kernel *sa;
     enum autosa_dep_type dep_type;
+    double io_volume;
+    int n_io_port;
+    int reuse;
+    int *extent;
+    double n_pe;
 };
 
 /* Internal struct used for not_carrried_at_space. */
@@ -729,6 +1230,7 @@ struct dep_space_test_internal_data
 {
     isl_vec *dirvec;
     isl_basic_map *dep;
+    struct ppcg_scop *scop;
 };
 
 /* This function tests if the current node contains any space loop.
@@ -766,7 +1268,12 @@ static isl_bool not_carried_at_space(__isl_keep isl_schedule_node *node, void *u
 
     if (n_space_dim > 0)
     {
-        isl_vec *disvec = get_dep_dis_at_node(untagged_dep, node);
+        isl_vec *disvec = autosa_get_dep_dis_at_node(data->scop, untagged_dep, node);
+        if (!disvec)
+        {
+            isl_basic_map_free(untagged_dep);
+            return isl_bool_true;
+        }
         isl_vec *dirvec = isl_vec_zero(isl_schedule_node_get_ctx(node), n_space_dim);
         int carried = 0;
         for (int i = 0; i < n_space_dim; i++)
@@ -804,7 +1311,7 @@ static isl_bool sa_candidates_smart_pick_update(__isl_keep isl_map *map, void *u
     for (int i = 0; i < isl_map_n_basic_map(map); i++)
     {
         isl_basic_map *dep = isl_basic_map_list_get_basic_map(bmap_list, i);
-        struct dep_space_test_internal_data internal_data = {NULL, dep};
+        struct dep_space_test_internal_data internal_data = {NULL, dep, sa->scop};
         int is_carried_at_space = !isl_schedule_node_every_descendant(node,
                                                                       not_carried_at_space, &internal_data);
         if (is_carried_at_space && data->dep_type == AUTOSA_DEP_RAR)
@@ -812,6 +1319,39 @@ static isl_bool sa_candidates_smart_pick_update(__isl_keep isl_map *map, void *u
         else if (!is_carried_at_space && data->dep_type == AUTOSA_DEP_RAW)
             data->score += 1;
 
+        /* Update the I/O volume. Data carried by the space loops are 
+         * only loaded by the boundary PEs and then forwarded. 
+         * RAW carried by the time loops are accumulated inside PEs. 
+         * Otherwise, each PE loads the data individually. 
+         */
+        if (is_carried_at_space && internal_data.dirvec)
+        {
+            double n_boundary_pe = data->n_pe;
+            for (int j = 0; j < isl_vec_size(internal_data.dirvec); j++)
+            {
+                isl_val *val = isl_vec_get_element_val(internal_data.dirvec, j);
+                int is_zero = isl_val_is_zero(val);
+                isl_val_free(val);
+                if (!is_zero && data->extent[j] > 0)
+                {
+                    n_boundary_pe /= data->extent[j];
+                    break;
+                }
+            }
+            data->io_volume += n_boundary_pe;
+            data->n_io_port += 1;
+            data->reuse += 1;
+        }
+        else if (data->dep_type == AUTOSA_DEP_RAW)
+        {
+            data->reuse += 1;
+        }
+        else
+        {
+            data->io_volume += data->n_pe;
+            data->n_io_port += 1;
+        }
+
         isl_vec_free(internal_data.dirvec);
         isl_basic_map_free(dep);
     }
@@ -820,58 +1360,335 @@ static isl_bool sa_candidates_smart_pick_update(__isl_keep isl_map *map, void *u
     return isl_bool_true;
 }
 
-/* Select one systolic array design based on heuristics. 
- * Heuristic:
+/* Metrics of a systolic array candidate used by the cost models. 
+ * "heuristic" is the score of the heuristic cost model.
+ * "n_pe" is the number of PEs and "pe_util" is the PE utilization. 
+ * "reuse" is the number of dependences served on-chip.
+ * "io_volume" is the number of data elements loaded from outside of the 
+ * array at each time step, which are distributed to "n_io_port" I/O ports,
+ * requiring a bandwidth of "bw_per_port" elements per time step each.
+ * "score" is the score computed by the selected cost model.
+ */
+struct sa_candidate_eval
+{
+    int heuristic;
+    double n_pe;
+    double pe_util;
+    int reuse;
+    double io_volume;
+    int n_io_port;
+    double bw_per_port;
+    double score;
+};
+
+/* Heuristic cost model.
  * We favor designs with the following features:
  * - RAR carried by space loops. 
  * - RAW carried by time loops. 
- * We compute a score for each design and select the one with the highest score.
- * The score is computed as :
- * score = 1 * (RAR carried by space || RAW carried by time loop)
  * Namely, for each dependnece, if it is a RAR carried by space or a RAW carried by 
  * time loops, it will contriute one credit to the total score.
- * Besides, between 1D and 2D systolic arrays, we prefer 2D systolic arrays for now.
+ * Besides, between 1D and 2D systolic arrays, we prefer 2D systolic arrays.
+ */
+static double sa_cost_heuristic(struct sa_candidate_eval *eval)
+{
+    return eval->heuristic;
+}
+
+/* Analytical cost model.
+ * The score estimates the number of useful operations per time step.
+ * Each active PE performs one operation per time step as long as each I/O 
+ * port supplies at most one data element per time step. Otherwise, the 
+ * array is throttled by the off-chip bandwidth.
+ * For arrays with parametric sizes, the number of PEs is unknown and 
+ * the score falls back to the heuristic cost model.
+ */
+static double sa_cost_analytical(struct sa_candidate_eval *eval)
+{
+    if (eval->n_pe < 0)
+        return sa_cost_heuristic(eval);
+
+    double throughput = eval->n_pe * eval->pe_util;
+
+    if (eval->bw_per_port > 1)
+        throughput /= eval->bw_per_port;
+
+    return throughput + eval->reuse;
+}
+
+/* The cost models indexed by --sa-cost-model. */
+static double (*sa_cost_models[])(struct sa_candidate_eval *eval) = {
+    sa_cost_heuristic,
+    sa_cost_analytical};
+
+/* Compute the extent of each space loop of the systolic array "sa" and 
+ * store them in "extent", which should have "sa->space_w" elements.
+ * The number of PEs in the bounding box of the array is stored in "n_pe".
+ * Return the PE utilization, i.e., the ratio between the number of PEs 
+ * that execute at least one statement instance and the number of PEs 
+ * in the bounding box. The utilization is below 1 for arrays with 
+ * skewed space loops.
+ * If the array size can't be determined statically, the extent and 
+ * "n_pe" are set to -1 and the utilization is assumed to be 1.
+ */
+static double sa_space_profile(struct autosa_kernel *sa, int *extent, double *n_pe)
+{
+    isl_schedule_node *node;
+    isl_union_map *umap;
+    isl_set *space_set;
+    int n_member, space_start;
+    double box = 1;
+    double util = 1;
+
+    if (sa->type == AUTOSA_SA_TYPE_SYNC)
+        node = get_innermost_permutable_node(sa->schedule);
+    else
+        node = get_outermost_permutable_node(sa->schedule);
+    n_member = isl_schedule_node_band_n_member(node);
+    space_start = (sa->type == AUTOSA_SA_TYPE_SYNC) ? n_member - sa->space_w : 0;
+
+    umap = isl_schedule_node_band_get_partial_schedule_union_map(node);
+    umap = isl_union_map_intersect_domain(umap, isl_schedule_node_get_domain(node));
+    isl_schedule_node_free(node);
+    space_set = isl_set_from_union_set(isl_union_map_range(umap));
+    space_set = isl_set_project_out(space_set, isl_dim_set, space_start + sa->space_w,
+                                    n_member - space_start - sa->space_w);
+    space_set = isl_set_project_out(space_set, isl_dim_set, 0, space_start);
+
+    for (int i = 0; i < sa->space_w; i++)
+    {
+        isl_val *lb = isl_set_dim_min_val(isl_set_copy(space_set), i);
+        isl_val *ub = isl_set_dim_max_val(isl_set_copy(space_set), i);
+        if (isl_val_is_int(lb) && isl_val_is_int(ub))
+            extent[i] = isl_val_get_num_si(ub) - isl_val_get_num_si(lb) + 1;
+        else
+            extent[i] = -1;
+        isl_val_free(lb);
+        isl_val_free(ub);
+        if (extent[i] > 0 && box > 0)
+            box *= extent[i];
+        else
+            box = -1;
+    }
+
+    if (box > 0 && isl_set_dim(space_set, isl_dim_param) == 0)
+    {
+        isl_pw_qpolynomial *card = isl_set_card(isl_set_copy(space_set));
+        isl_point *pnt = isl_point_zero(isl_pw_qpolynomial_get_domain_space(card));
+        isl_val *val = isl_pw_qpolynomial_eval(card, pnt);
+        if (isl_val_is_rat(val))
+            util = isl_val_get_d(val) / box;
+        isl_val_free(val);
+    }
+    *n_pe = box > 0 ? box : -1;
+    isl_set_free(space_set);
+
+    return util;
+}
+
+/* Evaluate the systolic array candidate "sa" and store the metrics in 
+ * "eval". The metrics are computed from the schedule of the candidate:
+ * - the heuristic score (see sa_cost_heuristic)
+ * - the number of PEs and the PE utilization
+ * - the number of dependences served on-chip
+ * - the I/O volume per time step and the bandwidth required per I/O port
+ * The score of the cost model selected by --sa-cost-model is then computed.
+ */
+static void sa_candidate_evaluate(struct autosa_kernel *sa,
+                                  struct sa_candidate_eval *eval)
+{
+    struct sa_candidates_smart_pick_update_data data;
+
+    data.score = 0;
+    data.sa = sa;
+    data.io_volume = 0;
+    data.n_io_port = 0;
+    data.reuse = 0;
+    /* Initialize the autosa_loop_types. */
+    sa_loop_init(sa);
+    /* Set up the space_time properties. */
+    sa_space_time_loop_setup(sa);
+    data.extent = (int *)malloc(sa->space_w * sizeof(int));
+    eval->pe_util = sa_space_profile(sa, data.extent, &eval->n_pe);
+    /* Count the I/O volume per PE if the number of PEs is unknown. */
+    data.n_pe = eval->n_pe > 0 ? eval->n_pe : 1;
+
+    data.dep_type = AUTOSA_DEP_RAR;
+    isl_union_map_every_map(sa->scop->tagged_dep_rar, &sa_candidates_smart_pick_update, &data);
+    data.dep_type = AUTOSA_DEP_RAW;
+    isl_union_map_every_map(sa->scop->tagged_dep_flow, &sa_candidates_smart_pick_update, &data);
+    /* Add one more credit for 2D arrays. */
+    if (sa->n_sa_dim == 2)
+        data.score += 1;
+    free(data.extent);
+
+    eval->heuristic = data.score;
+    eval->reuse = data.reuse;
+    eval->io_volume = data.io_volume;
+    eval->n_io_port = data.n_io_port;
+    eval->bw_per_port = data.n_io_port > 0 ? data.io_volume / data.n_io_port : 0;
+    eval->score = sa_cost_models[sa->scop->options->autosa->sa_cost_model](eval);
+}
+
+/* Sort the systolic array candidates in "sa_list" in place by the PE 
+ * utilization in descending order, then by the I/O volume per time step 
+ * in ascending order.
+ */
+static void sa_candidates_rank_by_utilization(struct autosa_kernel **sa_list,
+                                              isl_size num_sa)
+{
+    struct sa_candidate_eval *evals;
+
+    evals = (struct sa_candidate_eval *)malloc(num_sa * sizeof(struct sa_candidate_eval));
+    for (int i = 0; i < num_sa; i++)
+        sa_candidate_evaluate(sa_list[i], &evals[i]);
+
+    for (int i = 1; i < num_sa; i++)
+    {
+        struct sa_candidate_eval cur_eval = evals[i];
+        struct autosa_kernel *cur = sa_list[i];
+        int j = i - 1;
+        while (j >= 0 &&
+               (cur_eval.pe_util > evals[j].pe_util ||
+                (cur_eval.pe_util == evals[j].pe_util &&
+                 cur_eval.io_volume < evals[j].io_volume)))
+        {
+            evals[j + 1] = evals[j];
+            sa_list[j + 1] = sa_list[j];
+            j--;
+        }
+        evals[j + 1] = cur_eval;
+        sa_list[j + 1] = cur;
+    }
+    free(evals);
+}
+
+/* Return true if the candidate "eval1" is better than "eval2".
+ * If "tie_break" is set, candidates with the same score are ranked by
+ * the PE utilization first, then by the I/O volume per time step.
+ * Otherwise, the first candidate with the highest score is kept.
+ */
+static int sa_candidate_is_better(struct sa_candidate_eval *eval1,
+                                  struct sa_candidate_eval *eval2,
+                                  int tie_break)
+{
+    if (eval1->score != eval2->score || !tie_break)
+        return eval1->score > eval2->score;
+    if (eval1->pe_util != eval2->pe_util)
+        return eval1->pe_util > eval2->pe_util;
+    return eval1->io_volume < eval2->io_volume;
+}
+
+/* Evaluate all the systolic array candidates in "sa_list". 
+ * Return the per-candidate metrics.
+ */
+static struct sa_candidate_eval *sa_candidates_evaluate(
+    struct autosa_kernel **sa_list, isl_size num_sa)
+{
+    struct sa_candidate_eval *evals;
+
+    evals = (struct sa_candidate_eval *)malloc(num_sa * sizeof(struct sa_candidate_eval));
+    for (int i = 0; i < num_sa; i++)
+    {
+        sa_candidate_evaluate(sa_list[i], &evals[i]);
+        if (sa_list[i]->scop->options->autosa->verbose)
+        {
+            printf("[AutoSA] Candidate %d: score: %.2f, #PE: %.0f, PE utilization: %.2f, "
+                   "on-chip reuse: %d, I/O volume: %.0f, bandwidth per port: %.2f\n",
+                   i, evals[i].score, evals[i].n_pe, evals[i].pe_util, evals[i].reuse,
+                   evals[i].io_volume, evals[i].bw_per_port);
+        }
+    }
+
+    return evals;
+}
+
+/* Dump out the per-candidate metrics of the systolic arrays in "sa_list".
+ * Besides, "rank" lists the candidate ids in the descending order of 
+ * the score, which is used by the DSE to explore the promising candidates 
+ * first.
+ */
+static cJSON *sa_candidates_eval_to_json(struct autosa_kernel **sa_list, isl_size num_sa)
+{
+    struct sa_candidate_eval *evals;
+    cJSON *candidates, *rank;
+    cJSON *space_time_json;
+    int *order;
+    int tie_break = sa_list[0]->scop->options->autosa->sa_cost_model !=
+                    AUTOSA_SA_COST_HEURISTIC;
+
+    evals = sa_candidates_evaluate(sa_list, num_sa);
+    space_time_json = cJSON_CreateObject();
+    candidates = cJSON_CreateArray();
+    for (int i = 0; i < num_sa; i++)
+    {
+        cJSON *candidate = cJSON_CreateObject();
+        cJSON_AddNumberToObject(candidate, "kernel_id", i);
+        cJSON_AddNumberToObject(candidate, "score", evals[i].score);
+        cJSON_AddNumberToObject(candidate, "heuristic_score", evals[i].heuristic);
+        cJSON_AddNumberToObject(candidate, "n_pe", evals[i].n_pe);
+        cJSON_AddNumberToObject(candidate, "pe_utilization", evals[i].pe_util);
+        cJSON_AddNumberToObject(candidate, "on_chip_reuse", evals[i].reuse);
+        cJSON_AddNumberToObject(candidate, "io_volume", evals[i].io_volume);
+        cJSON_AddNumberToObject(candidate, "n_io_port", evals[i].n_io_port);
+        cJSON_AddNumberToObject(candidate, "bw_per_port", evals[i].bw_per_port);
+        cJSON_AddItemToArray(candidates, candidate);
+    }
+
+    /* Sort the candidates by score. */
+    order = (int *)malloc(num_sa * sizeof(int));
+    for (int i = 0; i < num_sa; i++)
+        order[i] = i;
+    for (int i = 1; i < num_sa; i++)
+    {
+        int cur = order[i];
+        int j = i - 1;
+        while (j >= 0 &&
+               sa_candidate_is_better(&evals[cur], &evals[order[j]], tie_break))
+        {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = cur;
+    }
+    rank = cJSON_CreateIntArray(order, num_sa);
+    free(order);
+    free(evals);
+
+    cJSON_AddItemToObject(space_time_json, "n_kernel", cJSON_CreateNumber(num_sa));
+    cJSON_AddItemToObject(space_time_json, "cost_model",
+                          cJSON_CreateString(sa_list[0]->scop->options->autosa->sa_cost_model ==
+                                                     AUTOSA_SA_COST_HEURISTIC
+                                                 ? "heuristic"
+                                                 : "analytical"));
+    cJSON_AddItemToObject(space_time_json, "candidates", candidates);
+    cJSON_AddItemToObject(space_time_json, "rank", rank);
+
+    return space_time_json;
+}
+
+/* Select one systolic array design based on the cost model selected by 
+ * --sa-cost-model. The candidate with the highest score is selected.
+ * With the heuristic model, the first of the designs with the same score is
+ * selected as before. With the analytical model, designs with the same score
+ * are ranked by the PE utilization first, then by the I/O volume per time step.
  */
 struct autosa_kernel *sa_candidates_smart_pick(
     struct autosa_kernel **sa_list, __isl_keep isl_size num_sa)
 {
     assert(num_sa > 0);
-    int max_score = -1;
     struct autosa_kernel *sa_opt;
-    int opt_id;
-    isl_union_map *dep_rar, *dep_flow;
+    struct sa_candidate_eval *evals;
+    int opt_id = 0;
+    int tie_break = sa_list[0]->scop->options->autosa->sa_cost_model !=
+                    AUTOSA_SA_COST_HEURISTIC;
 
-    for (int i = 0; i < num_sa; i++)
+    evals = sa_candidates_evaluate(sa_list, num_sa);
+    for (int i = 1; i < num_sa; i++)
     {
-        struct autosa_kernel *sa = sa_list[i];
-        struct sa_candidates_smart_pick_update_data data;
-        data.score = 0;
-        data.sa = sa;
-        /* Initialize the autosa_loop_types. */
-        sa_loop_init(sa);
-        /* Set up the space_time properties. */
-        sa_space_time_loop_setup(sa);
-
-        dep_rar = sa->scop->tagged_dep_rar;
-        dep_flow = sa->scop->tagged_dep_flow;
-
-        data.dep_type = AUTOSA_DEP_RAR;
-        isl_union_map_every_map(dep_rar, &sa_candidates_smart_pick_update, &data);
-        data.dep_type = AUTOSA_DEP_RAW;
-        isl_union_map_every_map(dep_flow, &sa_candidates_smart_pick_update, &data);
-        /* Add one more credit for 2D arrays. */
-        if (sa->n_sa_dim == 2)
-            data.score += 1;
-        if (data.score > max_score)
-        {
+        if (sa_candidate_is_better(&evals[i], &evals[opt_id], tie_break))
             opt_id = i;
-            max_score = data.score;
-        }
-        //#ifdef _DEBUG
-        //    DBGVAR(std::cout, i);
-        //    DBGVAR(std::cout, data.score);
-        //#endif
     }
+    free(evals);
 
     sa_opt = autosa_kernel_copy(sa_list[opt_id]);
 
@@ -979,7 +1796,7 @@ isl_stat data_transfer_update(__isl_keep isl_basic_map *dep, struct data_transfe
     isl_id_free(dest_id);
 
     /* Test if the dependence is carried at the space loop. */
-    struct dep_space_test_internal_data internal_data = {NULL, dep};
+    struct dep_space_test_internal_data internal_data = {NULL, dep, kernel->scop};
     node = isl_schedule_get_root(kernel->schedule);
     int is_carried_at_space = !isl_schedule_node_every_descendant(
         node, not_carried_at_space, &internal_data);
@@ -1114,9 +1931,12 @@ void extract_sa_dims_from_node(__isl_keep isl_schedule_node *node, int *sa_dims,
  * mode: opt mode for array partitioning.
  * L2_en: enable signal for L2 array partitioning.
  * L2_mode: opt mode for L2 array partitioning.
+ * L3_en: enable signal for L3 array partitioning.
+ * L3_mode: opt mode for L3 array partitioning.
  */
 isl_stat sa_array_partitioning_optimize(struct autosa_kernel *sa,
-                                        bool en, char *mode, bool L2_en, char *L2_mode)
+                                        bool en, char *mode, bool L2_en, char *L2_mode,
+                                        bool L3_en, char *L3_mode)
 {
     int tile_len;
     isl_schedule *schedule;
@@ -1223,8 +2043,8 @@ isl_stat sa_array_partitioning_optimize(struct autosa_kernel *sa,
     else
     {
         /* Auto mode.
-         * Perform the array partitioning following the default policy. */
-        tile_size = read_default_array_part_tile_sizes(sa, tile_len);
+         * Search the tiling factors using the analytical models. */
+        tile_size = search_array_part_tile_sizes(sa, node);
     }
 
     /* Tile the band. */
@@ -1443,6 +2263,109 @@ isl_stat sa_array_partitioning_optimize(struct autosa_kernel *sa,
         }
     }
 
+    /* If three-level buffering is enabled, we will tile the band T1 from the 
+     * L2 array partitioning once more:
+     * T0
+     * |
+     * T1
+     * |
+     * T2
+     * |
+     * P
+     * The L3 I/O buffers are allocated under the band T0 and hold the data 
+     * reused across all the L2 tiles inside one L3 tile. 
+     */
+    if (sa->options->autosa->three_level_buffer)
+    {
+        if (sa->options->autosa->two_level_buffer && L3_en)
+        {
+            printf("[AutoSA] Three-level buffering is set. Apply third-level array partitioning.\n");
+            tile_len = isl_schedule_node_band_n_member(node);
+            if (!strcmp(L3_mode, "manual"))
+            {
+                tile_size = read_array_part_L3_tile_sizes(sa, tile_len);
+                if (!tile_size)
+                {
+                    /* Dump out the number of and upper bounds of array_part_L3 loops and exit the program. */
+                    int *ubs = extract_band_upper_bounds(node);
+                    FILE *fp;
+                    char *content;
+                    cJSON *tuning, *array_part_json, *loops_json;
+                    isl_printer *p_str;
+                    char *tuning_path;
+
+                    tuning = cJSON_CreateObject();
+                    array_part_json = cJSON_CreateObject();
+                    cJSON_AddItemToObject(tuning, "array_part_L3", array_part_json);
+                    loops_json = cJSON_CreateArray();
+                    cJSON_AddItemToObject(array_part_json, "tilable_loops", loops_json);
+                    for (int i = 0; i < tile_len; i++)
+                    {
+                        cJSON *loop = cJSON_CreateNumber(ubs[i]);
+                        cJSON_AddItemToArray(loops_json, loop);
+                    }
+                    loops_json = cJSON_CreateArray();
+                    cJSON_AddItemToObject(array_part_json, "coincident", loops_json);
+                    for (int i = 0; i < tile_len; i++)
+                    {
+                        cJSON *loop = cJSON_CreateNumber(
+                            isl_schedule_node_band_member_get_coincident(node, i));
+                        cJSON_AddItemToArray(loops_json, loop);
+                    }
+                    /* Add the iterations of one L2 array partition and the total 
+                     * element size of the arrays, used to estimate the L3 buffer 
+                     * size of each candidate. 
+                     */
+                    int ele_bytes = 0;
+                    for (int i = 0; i < sa->prog->n_array; i++)
+                        ele_bytes += sa->prog->array[i].size;
+                    cJSON_AddNumberToObject(array_part_json, "inner_volume",
+                                            extract_band_inner_volume(node));
+                    cJSON_AddNumberToObject(array_part_json, "ele_bytes", ele_bytes);
+                    p_str = isl_printer_to_str(sa->ctx);
+                    p_str = isl_printer_print_str(p_str, sa->options->autosa->output_dir);
+                    p_str = isl_printer_print_str(p_str, "/tuning.json");
+                    tuning_path = isl_printer_get_str(p_str);
+                    fp = fopen(tuning_path, "w");
+                    content = cJSON_Print(tuning);
+                    fprintf(fp, "%s", content);
+                    fclose(fp);
+                    free(content);
+                    cJSON_Delete(tuning);
+                    free(tuning_path);
+                    isl_printer_free(p_str);
+                    free(ubs);
+                    exit(0);
+                }
+            }
+            else
+            {
+                /* Auto mode.
+                 * Select the largest L3 tile whose buffers fit on-chip. */
+                tile_size = search_array_part_L3_tile_sizes(sa, node);
+            }
+
+            if (!tile_size)
+            {
+                isl_schedule_node_free(node);
+                return isl_stat_error;
+            }
+            node = autosa_tile_band(node, tile_size);
+            free(tile_size);
+
+            /* Add the third-level array mark */
+            node = isl_schedule_node_child(node, 0);
+            id = isl_id_alloc(sa->ctx, "array_L3", NULL);
+            node = isl_schedule_node_insert_mark(node, id);
+            node = isl_schedule_node_parent(node);
+        }
+        else
+        {
+            /* Disable the L3 array partitioning */
+            sa->options->autosa->three_level_buffer = 0;
+        }
+    }
+
     /* Clean up the band pe_opt properties. */
     schedule = isl_schedule_node_get_schedule(node);
     isl_schedule_node_free(node);
@@ -1841,11 +2764,13 @@ struct count_latency_hiding_loop_data
 {
     int tile_len;
     int *ubs;
+    int *is_space;
     struct autosa_kernel *kernel;
 };
 
 /* Count the number of latency hiding candidate loops.
- * Extract the loop upper bounds of the candidate loops.
+ * Extract the loop upper bounds of the candidate loops and mark the 
+ * space loops.
  */
 static isl_bool count_latency_hiding_loop(
     __isl_keep isl_schedule_node *node, void *user)
@@ -1876,6 +2801,9 @@ static isl_bool count_latency_hiding_loop(
                 int *ubs = extract_band_upper_bounds(node_copy);
                 data->ubs = (int *)realloc(data->ubs, sizeof(int) * data->tile_len);
                 data->ubs[data->tile_len - 1] = ubs[0];
+                data->is_space = (int *)realloc(data->is_space, sizeof(int) * data->tile_len);
+                data->is_space[data->tile_len - 1] =
+                    isl_schedule_node_band_member_get_space_time(node, i) == autosa_loop_space;
                 isl_schedule_node_free(node_copy);
                 free(ubs);
             }
@@ -1899,6 +2827,7 @@ static __isl_give isl_schedule_node *autosa_latency_tile_loop(
     struct count_latency_hiding_loop_data data;
     data.tile_len = 0;
     data.ubs = NULL;
+    data.is_space = NULL;
     data.kernel = sa;
     int i;
 
@@ -1945,11 +2874,12 @@ static __isl_give isl_schedule_node *autosa_latency_tile_loop(
     }
     else
     {
-        /* Perform the latency hiding following the default policy. */
-        tile_size = read_default_latency_tile_sizes(sa, tile_len);
+        /* Search the tiling factors using the analytical models. */
+        tile_size = search_latency_tile_sizes(sa, tile_len, data.ubs, data.is_space);
     }
 
     free(data.ubs);
+    free(data.is_space);
     if (!tile_size)
     {
         isl_schedule_node_free(node);
@@ -2094,6 +3024,7 @@ struct simd_vectorization_data
     char *mode;
     int *ubs;
     int *tile_size;
+    int *reduction;
     char *buffer;
     int buffer_offset;
     int has_space_candidate;
@@ -2330,6 +3261,142 @@ static float is_stride_coalesced(__isl_keep isl_schedule_node *node,
     return coalesced ? data.score : -1;
 }
 
+/* Is the tagged dependence "map" a self-dependence of a reduction statement
+ * through its reduction variable? That is, the source and sink belong to the
+ * same reduction statement (see autosa_stmt_is_reduction), and the dependence
+ * is between the accesses to the reduction variable, i.e., from the write to
+ * the write or the read (output and flow dependences), or from the read to
+ * the write (anti dependences).
+ */
+static isl_bool is_reduction_dep(__isl_keep isl_map *map, void *user)
+{
+    struct autosa_kernel *kernel = (struct autosa_kernel *)user;
+    isl_space *space, *src_space, *sink_space;
+    isl_id *src_stmt, *src_ref, *sink_stmt, *sink_ref;
+    isl_id *write_ref = NULL, *read_ref = NULL;
+    struct autosa_stmt *stmt;
+    isl_bool is_reduction = isl_bool_false;
+
+    space = isl_map_get_space(map);
+    src_space = isl_space_unwrap(isl_space_domain(isl_space_copy(space)));
+    sink_space = isl_space_unwrap(isl_space_range(space));
+    src_stmt = isl_space_get_tuple_id(src_space, isl_dim_in);
+    src_ref = isl_space_get_tuple_id(src_space, isl_dim_out);
+    sink_stmt = isl_space_get_tuple_id(sink_space, isl_dim_in);
+    sink_ref = isl_space_get_tuple_id(sink_space, isl_dim_out);
+    isl_space_free(src_space);
+    isl_space_free(sink_space);
+
+    if (src_stmt == sink_stmt)
+    {
+        stmt = find_stmt(kernel->prog, src_stmt);
+        if (stmt && autosa_stmt_is_reduction(stmt, &write_ref, &read_ref, NULL) == isl_bool_true)
+        {
+            if (src_ref == write_ref && (sink_ref == write_ref || sink_ref == read_ref))
+                is_reduction = isl_bool_true;
+            if (src_ref == read_ref && sink_ref == write_ref)
+                is_reduction = isl_bool_true;
+        }
+    }
+
+    isl_id_free(src_stmt);
+    isl_id_free(src_ref);
+    isl_id_free(sink_stmt);
+    isl_id_free(sink_ref);
+    isl_id_free(write_ref);
+    isl_id_free(read_ref);
+
+    return is_reduction;
+}
+
+/* Return the tagged version of the false (anti and output) dependences
+ * of "scop", i.e., the pairs of tagged accesses to the same array element
+ * whose statement instances are related by scop->dep_false.
+ */
+static __isl_give isl_union_map *tagged_dep_false(struct ppcg_scop *scop)
+{
+    isl_union_map *accesses, *pairs, *dep;
+    isl_union_pw_multi_aff *tagger;
+
+    accesses = isl_union_map_union(isl_union_map_copy(scop->tagged_reads),
+                                   isl_union_map_copy(scop->tagged_may_writes));
+    pairs = isl_union_map_apply_range(accesses,
+                isl_union_map_reverse(isl_union_map_copy(scop->tagged_may_writes)));
+    tagger = isl_union_pw_multi_aff_copy(scop->tagger);
+    dep = isl_union_map_copy(scop->dep_false);
+    dep = isl_union_map_preimage_domain_union_pw_multi_aff(dep,
+                isl_union_pw_multi_aff_copy(tagger));
+    dep = isl_union_map_preimage_range_union_pw_multi_aff(dep, tagger);
+
+    return isl_union_map_intersect(pairs, dep);
+}
+
+/* Is the band member "pos" of the band "node" a reduction loop?
+ * We compute the flow, anti and output dependences carried by this loop, i.e.,
+ * the dependences between the instances that share the same outer schedule
+ * dimensions but are mapped to different iterations of this loop.
+ * The loop is a reduction loop if there is at least one such dependence and
+ * all of them are self-dependences of reduction statements through their
+ * reduction variables, which could be relaxed by reassociating the updates.
+ */
+static int is_reduction_loop(struct autosa_kernel *sa,
+                             __isl_keep isl_schedule_node *node, int pos)
+{
+    isl_union_map *prefix, *outer, *inner, *same_outer, *same_inner;
+    isl_union_map *carried, *deps;
+    isl_multi_union_pw_aff *partial;
+    isl_union_pw_multi_aff *tagger;
+    isl_bool is_empty, all_reduction;
+    int n = isl_schedule_node_band_n_member(node);
+
+    if (!sa->scop->tagged_dep_flow)
+        return 0;
+
+    prefix = isl_schedule_node_get_prefix_schedule_union_map(node);
+    partial = isl_schedule_node_band_get_partial_schedule(node);
+    partial = isl_multi_union_pw_aff_drop_dims(partial, isl_dim_set, pos + 1, n - pos - 1);
+    inner = isl_union_map_flat_range_product(isl_union_map_copy(prefix),
+                isl_union_map_from_multi_union_pw_aff(isl_multi_union_pw_aff_copy(partial)));
+    if (pos > 0)
+    {
+        partial = isl_multi_union_pw_aff_drop_dims(partial, isl_dim_set, pos, 1);
+        outer = isl_union_map_flat_range_product(prefix,
+                    isl_union_map_from_multi_union_pw_aff(partial));
+    }
+    else
+    {
+        isl_multi_union_pw_aff_free(partial);
+        outer = prefix;
+    }
+
+    same_outer = isl_union_map_apply_range(isl_union_map_copy(outer),
+                                           isl_union_map_reverse(outer));
+    same_inner = isl_union_map_apply_range(isl_union_map_copy(inner),
+                                           isl_union_map_reverse(inner));
+    carried = isl_union_map_subtract(same_outer, same_inner);
+
+    /* Lift the relation to the tagged instances. */
+    tagger = isl_union_pw_multi_aff_copy(sa->scop->tagger);
+    carried = isl_union_map_preimage_domain_union_pw_multi_aff(carried,
+                isl_union_pw_multi_aff_copy(tagger));
+    carried = isl_union_map_preimage_range_union_pw_multi_aff(carried, tagger);
+
+    deps = isl_union_map_copy(sa->scop->tagged_dep_flow);
+    if (sa->scop->tagged_dep_waw)
+        deps = isl_union_map_union(deps, isl_union_map_copy(sa->scop->tagged_dep_waw));
+    if (sa->scop->dep_false)
+        deps = isl_union_map_union(deps, tagged_dep_false(sa->scop));
+    deps = isl_union_map_intersect(deps, carried);
+
+    is_empty = isl_union_map_is_empty(deps);
+    all_reduction = isl_bool_false;
+    if (is_empty == isl_bool_false)
+        all_reduction = isl_union_map_every_map(deps, &is_reduction_dep, sa);
+    isl_union_map_free(deps);
+
+    return all_reduction == isl_bool_true;
+}
+
 /* A loop is identified to be vectorizable if it is:
  * - a parallel or reduction loop
  * - with stride-0/1 access.
@@ -2342,6 +3409,9 @@ static float is_stride_coalesced(__isl_keep isl_schedule_node *node,
  * The heuristics are:
  * - We prefer reduction loop to parallel loop. 
  * - We prefer array references without requirements of layout transformation.
+ * Reduction loops are detected from the dependences (see is_reduction_loop),
+ * unless the reduction information is provided by the user through 
+ * the SIMD information file.
  */
 static isl_schedule_node *detect_simd_vectorization_loop(
     __isl_take isl_schedule_node *node, void *user)
@@ -2391,35 +3461,19 @@ static isl_schedule_node *detect_simd_vectorization_loop(
                 int layout_transform = 0;
                 float score_i;
 
-                if (!isl_schedule_node_band_member_get_coincident(node, i) && !strcmp(data->mode, "manual"))
+                if (!isl_schedule_node_band_member_get_coincident(node, i) && !data->buffer)
                 {
-                    /* At present, we can't analyze reduction loop by AutoSA.
-                     * We will print each node and follow the user guidance.
-                     * Besides, reduction loops are only examined in the manual mode.
-                     * In the auto mode, only parallel loops are examined.
-                     */
-                    size_t bufsize = 100;
-                    size_t characters;
+                    /* Detect the reduction loop from the dependences. */
+                    printf("[AutoSA] Detecting the reduction loop.\n");
+                    printf("[AutoSA] Band member position: %d\n", i);
+                    is_reduction = is_reduction_loop(sa, node, i);
+                    printf("[AutoSA] Reduction property: %c\n", is_reduction ? 'y' : 'n');
+                }
+                else if (!isl_schedule_node_band_member_get_coincident(node, i))
+                {
+                    /* Follow the reduction information provided by the user. */
                     printf("[AutoSA] Detecting the reduction loop.\n");
                     printf("[AutoSA] Band member position: %d\n", i);
-                    /* If the SIMD info is pre-loaded, we don't ask for user inputs. */
-                    if (data->buffer == NULL)
-                    {
-                        isl_printer *p;
-                        p = isl_printer_to_file(ctx, stdout);
-                        p = isl_printer_end_line(p);
-                        p = isl_printer_set_yaml_style(p, ISL_YAML_STYLE_BLOCK);
-                        p = isl_printer_print_schedule_node(p, node);
-                        isl_printer_free(p);
-                        printf("[AutoSA] Please input if the current loop is a reduction loop [y/n]: ");
-                    }
-                    if (data->buffer == NULL)
-                    {
-                        char *buffer = (char *)malloc(bufsize * sizeof(char));
-                        data->buffer = buffer;
-                        data->buffer_offset = 0;
-                        characters = getline(&buffer, &bufsize, stdin);
-                    }
                     printf("[AutoSA] Reduction property: %c\n", data->buffer[data->buffer_offset]);
                     is_reduction = (data->buffer[data->buffer_offset] == 'y') ? 1 : 0;
                     if (data->buffer[data->buffer_offset + 1] == 'y' ||
@@ -2495,6 +3549,8 @@ static isl_schedule_node *detect_simd_vectorization_loop(
                         data->scores[data->n_loops - 1] = score;
                         data->legal = (int *)realloc(data->legal, sizeof(int) * data->n_loops);
                         data->legal[data->n_loops - 1] = !layout_transform;
+                        data->reduction = (int *)realloc(data->reduction, sizeof(int) * data->n_loops);
+                        data->reduction[data->n_loops - 1] = is_reduction;
                         if (!layout_transform) 
                             data->n_legal_loops++;
 
@@ -2611,9 +3667,8 @@ static isl_bool update_simd_acc(__isl_keep isl_schedule_node *node, void *user)
 }
 
 /* This function tiles the SIMD loop.
- * If it is executed in the auto mode, it will select the loop with the 
- * highest score.
- * Otherwise, it will select loops with positive tiling factors.
+ * It will select loops with positive tiling factors, which are either 
+ * specified by the user or searched in the auto mode.
  * Loops with tiling factors of one or require layout transformation are skipped.
  * At last, it will also update the stride information for the array accesses
  * under the SIMD loop.
@@ -2632,27 +3687,13 @@ static __isl_give isl_schedule_node *autosa_simd_tile_loop(
         {
             if (isl_schedule_node_band_member_get_pe_opt(node, i) == autosa_loop_simd)
             {
-                if (!strcmp(data->mode, "auto"))
+                /* Peform tiling on the loop with positive tiling factor */
+                if (data->tile_size[data->loop_cnt] <= 0)
                 {
-                    /* Perform tiling on the loop with the highest score. */
-                    if (data->scores[data->loop_cnt] != data->best_score)
-                    {
-                        node = isl_schedule_node_band_member_set_pe_opt(node, i,
-                                                                        autosa_loop_default);
-                        data->loop_cnt++;
-                        continue;
-                    }
-                }
-                else
-                {
-                    /* Peform tiling on the loop with positive tiling factor */
-                    if (data->tile_size[data->loop_cnt] <= 0)
-                    {
-                        node = isl_schedule_node_band_member_set_pe_opt(node, i,
-                                                                        autosa_loop_default);
-                        data->loop_cnt++;
-                        continue;
-                    }
+                    node = isl_schedule_node_band_member_set_pe_opt(node, i,
+                                                                    autosa_loop_default);
+                    data->loop_cnt++;
+                    continue;
                 }
                 if (data->tile_size[data->loop_cnt] == 1)
                 {
@@ -2717,6 +3758,7 @@ static __isl_give isl_schedule_node *autosa_simd_tile_loop(
 
                 node = isl_schedule_node_parent(node);
                 kernel->simd_w = tile_size;
+                kernel->simd_reduction = data->reduction[data->loop_cnt];
                 data->loop_cnt++;
                 printf("[AutoSA] SIMD vectorization successfully applied.\n");
             }
@@ -2817,6 +3859,7 @@ isl_stat sa_simd_vectorization_optimize(struct autosa_kernel *sa, char *mode)
     isl_schedule *schedule = sa->schedule;
     isl_schedule_node *node = isl_schedule_get_root(schedule);
     sa->simd_w = 1;
+    sa->simd_reduction = 0;
 
     /* Move down to the array marker */
     node = autosa_tree_move_down_to_array(node, sa->core);
@@ -2825,6 +3868,7 @@ isl_stat sa_simd_vectorization_optimize(struct autosa_kernel *sa, char *mode)
     data.kernel = sa;
     data.scores = scores;
     data.legal = NULL;
+    data.reduction = NULL;
     data.buffer = NULL;
     data.buffer_offset = 0;
     data.n_loops = n_loops;
@@ -2931,7 +3975,9 @@ isl_stat sa_simd_vectorization_optimize(struct autosa_kernel *sa, char *mode)
         }
         else
         {
-            throw std::runtime_error("[AutoSA] Error: Auto SIMD vectorization is not supported.\n");
+            /* Search the SIMD factor using the analytical models. */
+            tile_size = search_simd_tile_sizes(sa, data.n_loops, data.ubs,
+                                               data.legal, data.scores);
         }
 
         /* Perform the simd vectorization. */
@@ -2943,6 +3989,7 @@ isl_stat sa_simd_vectorization_optimize(struct autosa_kernel *sa, char *mode)
 
     free(data.ubs);
     free(data.legal);
+    free(data.reduction);
     free(tile_size);
     /* Clean up the band pe_opt properties. */
     schedule = isl_schedule_node_get_schedule(node);
@@ -3014,7 +4061,8 @@ isl_stat sa_pe_optimize(struct autosa_kernel *sa, bool pass_en[], char *pass_mod
 //    
 //#endif
     /* Array partitioning. */
-    sa_array_partitioning_optimize(sa, pass_en[0], pass_mode[0], pass_en[1], pass_mode[1]);    
+    sa_array_partitioning_optimize(sa, pass_en[0], pass_mode[0], pass_en[1], pass_mode[1],
+                                   pass_en[4], pass_mode[4]);    
 
 //#ifdef _DEBUG
 //    DBGSCHD(stdout, sa->schedule, isl_schedule_get_ctx(sa->schedule));    
@@ -3260,6 +4308,63 @@ static void localize_bounds(struct autosa_kernel *kernel,
     isl_set_free(context);
 }
 
+/* Apply the space-time transformation on the alternative schedules in 
+ * "gen" and append the systolic array candidates to "sa_list".
+ * Each alternative schedule is prepared in the same way as the default 
+ * schedule in sa_map_to_device, i.e., a context node is inserted and the 
+ * sched_pos properties are set up for the outermost band.
+ * The space-time ids and kernel ids are reassigned so that all candidates 
+ * can be picked by the DSE.
+ */
+static struct autosa_kernel **sa_space_time_transform_alt(struct autosa_gen *gen,
+    struct autosa_kernel **sa_list, isl_size *num_sa)
+{
+    for (int i = 0; i < gen->n_alt_schedules; i++)
+    {
+        isl_schedule *schedule;
+        isl_schedule_node *node;
+        isl_size n_sa_alt = 0;
+        struct autosa_kernel **sa_alt_list;
+        isl_set *context;
+
+        context = isl_set_copy(gen->prog->context);
+        context = isl_set_from_params(context);
+        schedule = isl_schedule_insert_context(
+            isl_schedule_copy(gen->alt_schedules[i]), context);
+        node = isl_schedule_get_root(schedule);
+        isl_schedule_free(schedule);
+        node = isl_schedule_node_child(node, 0);
+        node = isl_schedule_node_child(node, 0);
+        node = sched_pos_setup(node);
+        schedule = isl_schedule_node_get_schedule(node);
+        isl_schedule_node_free(node);
+
+        if (gen->options->autosa->verbose)
+        {
+            printf("[AutoSA] Explore alternative schedule %d.\n", i);
+        }
+        sa_alt_list = sa_space_time_transform(schedule, gen->prog->scop, &n_sa_alt);
+        if (gen->options->autosa->verbose)
+        {
+            printf("[AutoSA] %d candidates generated.\n", n_sa_alt);
+        }
+        sa_list = (struct autosa_kernel **)realloc(sa_list,
+                                                   (*num_sa + n_sa_alt) * sizeof(struct autosa_kernel *));
+        for (int j = 0; j < n_sa_alt; j++)
+            sa_list[*num_sa + j] = sa_alt_list[j];
+        free(sa_alt_list);
+        *num_sa = *num_sa + n_sa_alt;
+    }
+
+    for (int i = 0; i < *num_sa; i++)
+    {
+        sa_list[i]->space_time_id = i;
+        sa_list[i]->id = i;
+    }
+
+    return sa_list;
+}
+
 /* Create an autosa_kernel represents the domain isntances that reach "node" and 
  * insert a mark node pointing to the autosa_kernel before "node".
  *
@@ -3309,9 +4414,11 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
     struct autosa_kernel **sa_candidates;
     struct autosa_kernel *sa_opt, *kernel;
     isl_schedule *schedule;
-    /* Enable for array partitioning, L2 array partitioning, latency hiding, SIMD. */
-    bool pe_opt_en[4];
-    char *pe_opt_mode[4];
+    /* Enable for array partitioning, L2 array partitioning, latency hiding, SIMD, 
+     * L3 array partitioning. 
+     */
+    bool pe_opt_en[5];
+    char *pe_opt_mode[5];
     isl_union_set *domain, *expanded;
     int single_statement;
     isl_union_map *host_schedule;
@@ -3320,9 +4427,10 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
     isl_union_pw_multi_aff *contraction;
     int n_space_dim;
     char *space_time_mode;
-    cJSON *space_time_json, *space_time_mode_json, *n_sa_json, *tuning;
+    cJSON *space_time_json, *space_time_mode_json, *tuning;
     cJSON *array_part_json, *array_part_en_json, *array_part_mode_json;
     cJSON *array_part_L2_json, *array_part_L2_en_json, *array_part_L2_mode_json;
+    cJSON *array_part_L3_json, *array_part_L3_en_json, *array_part_L3_mode_json;
     cJSON *latency_json, *latency_en_json, *latency_mode_json;
     cJSON *simd_json, *simd_en_json, *simd_mode_json;
 
@@ -3337,6 +4445,8 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
     schedule = isl_schedule_node_get_schedule(node);
     isl_schedule_node_free(node);
     sa_candidates = sa_space_time_transform(schedule, gen->prog->scop, &num_sa);
+    if (gen->n_alt_schedules > 0)
+        sa_candidates = sa_space_time_transform_alt(gen, sa_candidates, &num_sa);
     if (num_sa > 0)
         printf("[AutoSA] %d systolic arrays generated.\n", num_sa);
     else
@@ -3376,9 +4486,7 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
             char *tuning_path;
 
             tuning = cJSON_CreateObject();
-            space_time_json = cJSON_CreateObject();
-            n_sa_json = cJSON_CreateNumber(num_sa);
-            cJSON_AddItemToObject(space_time_json, "n_kernel", n_sa_json);
+            space_time_json = sa_candidates_eval_to_json(sa_candidates, num_sa);
             cJSON_AddItemToObject(tuning, "space_time", space_time_json);
             p_str = isl_printer_to_str(gen->ctx);
             p_str = isl_printer_print_str(p_str, gen->options->autosa->output_dir);
@@ -3419,6 +4527,11 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
     array_part_L2_en_json = cJSON_GetObjectItemCaseSensitive(array_part_L2_json, "enable");
     array_part_L2_mode_json = cJSON_GetObjectItemCaseSensitive(array_part_L2_json, "mode");
 
+    /* The L3 stage is optional in the configuration file. */
+    array_part_L3_json = cJSON_GetObjectItemCaseSensitive(gen->tuning_config, "array_part_L3");
+    array_part_L3_en_json = cJSON_GetObjectItemCaseSensitive(array_part_L3_json, "enable");
+    array_part_L3_mode_json = cJSON_GetObjectItemCaseSensitive(array_part_L3_json, "mode");
+
     latency_json = cJSON_GetObjectItemCaseSensitive(gen->tuning_config, "latency");
     latency_en_json = cJSON_GetObjectItemCaseSensitive(latency_json, "enable");
     latency_mode_json = cJSON_GetObjectItemCaseSensitive(latency_json, "mode");
@@ -3431,11 +4544,13 @@ static __isl_give isl_schedule_node *compute_and_comm_optimize(
     pe_opt_en[1] = array_part_L2_en_json->valueint;
     pe_opt_en[2] = latency_en_json->valueint;
     pe_opt_en[3] = simd_en_json->valueint;
+    pe_opt_en[4] = array_part_L3_en_json? array_part_L3_en_json->valueint : 0;
 
     pe_opt_mode[0] = array_part_mode_json->valuestring;
     pe_opt_mode[1] = array_part_L2_mode_json->valuestring;
     pe_opt_mode[2] = latency_mode_json->valuestring;
     pe_opt_mode[3] = simd_mode_json->valuestring;
+    pe_opt_mode[4] = array_part_L3_mode_json? array_part_L3_mode_json->valuestring : NULL;
 
     sa_pe_optimize(kernel, pe_opt_en, pe_opt_mode);
     /* Create the autosa_kernel object and attach to the schedule. */
@@ -3891,6 +5006,66 @@ static __isl_give isl_schedule_node *sa_add_copies(
     return node;
 }
 
+/* Test if "schedule" can be mapped to systolic arrays, i.e., the outermost
+ * node is a permutable band and all the dependences are uniform.
+ * Unlike sa_legality_check, no error is thrown for illegal schedules.
+ */
+static isl_bool sa_is_candidate_schedule(__isl_keep isl_schedule *schedule,
+                                         struct ppcg_scop *scop)
+{
+    isl_schedule_node *node;
+    isl_bool is_band;
+
+    node = isl_schedule_get_root(schedule);
+    node = isl_schedule_node_child(node, 0);
+    is_band = isl_schedule_node_get_type(node) == isl_schedule_node_band ?
+              isl_bool_true : isl_bool_false;
+    if (is_band)
+        is_band = is_permutable_node(node);
+    isl_schedule_node_free(node);
+    if (is_band != isl_bool_true)
+        return is_band;
+
+    return uniform_dep_check(schedule, scop);
+}
+
+/* Compute the alternative schedules of the program and keep the ones
+ * that pass the legality check and differ from the default "schedule".
+ * The schedules are stored in gen->alt_schedules.
+ */
+static void sa_collect_alt_schedules(struct autosa_gen *gen,
+                                     __isl_keep isl_schedule *schedule)
+{
+    int n_schedule = 0;
+    isl_schedule **schedules;
+
+    printf("[AutoSA] Explore alternative schedules.\n");
+    schedules = explore_schedules(gen, &n_schedule);
+    for (int i = 0; i < n_schedule; i++)
+    {
+        isl_bool keep = sa_is_candidate_schedule(schedules[i], gen->prog->scop);
+        if (keep == isl_bool_true &&
+            isl_schedule_plain_is_equal(schedules[i], schedule))
+            keep = isl_bool_false;
+        for (int j = 0; j < gen->n_alt_schedules && keep == isl_bool_true; j++)
+        {
+            if (isl_schedule_plain_is_equal(schedules[i], gen->alt_schedules[j]))
+                keep = isl_bool_false;
+        }
+        if (keep != isl_bool_true)
+        {
+            isl_schedule_free(schedules[i]);
+            continue;
+        }
+        gen->alt_schedules = (isl_schedule **)realloc(gen->alt_schedules,
+                                                      (gen->n_alt_schedules + 1) * sizeof(isl_schedule *));
+        gen->alt_schedules[gen->n_alt_schedules] = schedules[i];
+        gen->n_alt_schedules++;
+    }
+    free(schedules);
+    printf("[AutoSA] %d alternative schedules found.\n", gen->n_alt_schedules);
+}
+
 /* Perform computation and commmunication management to update the 
  * "schedule" for mapping to FPGA.
  *
@@ -4003,6 +5178,9 @@ __isl_give isl_schedule *sa_map_to_device(struct autosa_gen *gen,
  * If not, we will generate CPU code instead.
  * If the --load-schedule is specified, then the loaded schedule 
  * is used instead of a computed schedule.
+ * If the --explore-schedules is specified, schedules computed under 
+ * alternative scheduler configurations are also explored in the 
+ * space-time transformation.
  * 
  * For the candidate program, a sequence of optimizations are performed, 
  * including: 
@@ -4056,6 +5234,8 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
         return isl_printer_free(p);
 
     gen->prog = prog;
+    /* Dependence distances are memoized and shared across the passes. */
+    scop->dep_dis = autosa_dep_dis_table_alloc(ctx);
     /* Scheduling */
     schedule = get_schedule(gen);
 
@@ -4067,7 +5247,11 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
      * fully permutable loop band correctly.
      * As a temporary hack, here we will try a second time and to merge the 
      * outer band as much as possible.
+     * Time-iterated stencils are skewed first such that the time loop
+     * can be merged with the space loops.
      */    
+    if (options->autosa->hybrid_tile)
+        schedule = hybrid_tile_outer_bands(schedule, gen);
     schedule = merge_outer_bands(schedule, gen);    
 
 //#ifdef _DEBUG
@@ -4086,6 +5270,10 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
     }
     else
     {
+        /* Explore alternative schedules. */
+        if (options->autosa->explore_schedules)
+            sa_collect_alt_schedules(gen, schedule);
+
         /* Perform opt. stages:
          * Computation Management -> Communication Management     
          */        
@@ -4121,6 +5309,8 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
             }
         }
 
+        if (gen->options->autosa->design_summary)
+            sa_design_summary_init(gen->ctx, gen->options->autosa);
         /* Extract loop structure for latency estimation */
         for (int i = 0; i < gen->n_hw_modules; i++)
         {
@@ -4154,6 +5344,16 @@ static __isl_give isl_printer *generate(__isl_take isl_printer *p,
         free(gen->drain_merge_funcs);
     }
 
+    for (int i = 0; i < gen->n_alt_schedules; i++)
+        isl_schedule_free(gen->alt_schedules[i]);
+    free(gen->alt_schedules);
+    gen->alt_schedules = NULL;
+    gen->n_alt_schedules = 0;
+
+    if (gen->options->autosa->verbose && scop->dep_dis)
+        printf("[AutoSA] Dependence distance table: %d hits, %d misses.\n",
+               scop->dep_dis->n_hit, scop->dep_dis->n_miss);
+    scop->dep_dis = (struct autosa_dep_dis_table *)autosa_dep_dis_table_free(scop->dep_dis);
     autosa_prog_free(prog);
 
     return p;
@@ -4200,6 +5400,8 @@ int generate_sa(isl_ctx *ctx, const char *input, FILE *out,
     gen.drain_merge_funcs = NULL;
     gen.n_drain_merge_funcs = 0;
     gen.schedule = NULL;
+    gen.alt_schedules = NULL;
+    gen.n_alt_schedules = 0;
     gen.kernel = NULL;
     gen.tuning_config = NULL;
 
@@ -41,10 +41,10 @@ isl_bool sa_legality_check(__isl_keep isl_schedule *schedule, struct ppcg_scop *
 /* Space-Time transformation */
 struct autosa_kernel **sa_space_time_transform_at_dim_async(
     __isl_keep isl_schedule *schedule, struct ppcg_scop *scop,
-    isl_size dim, isl_size *num_sa);
+    isl_size dim, int space_pos, isl_size *num_sa);
 struct autosa_kernel **sa_space_time_transform_at_dim_sync(
     __isl_keep isl_schedule *schedule, struct ppcg_scop *scop,
-    isl_size dim, isl_size *num_sa);
+    isl_size dim, int space_pos, isl_size *num_sa);
 struct autosa_kernel **sa_space_time_transform_at_dim(
     __isl_keep isl_schedule *schedule, struct ppcg_scop *scop,
     isl_size dim, isl_size *num_sa);
@@ -57,7 +57,8 @@ struct autosa_kernel **sa_space_time_transform(
 
 /* PE Optimization */
 isl_stat sa_array_partitioning_optimize(
-    struct autosa_kernel *sa, bool en, char *mode, bool L2_en, char *L2_mode);
+    struct autosa_kernel *sa, bool en, char *mode, bool L2_en, char *L2_mode,
+    bool L3_en, char *L3_mode);
 isl_stat sa_latency_hiding_optimize(
     struct autosa_kernel *sa, bool en, char *mode);
 isl_stat sa_simd_vectorization_optimize(
@@ -442,3 +442,85 @@ long compute_set_max(__isl_keep isl_set *set, int dim)
 
   return max;  
 }
+
+/* If the for node "node" has a constant lower bound, a constant upper bound 
+ * and a constant stride, store the first and the last value taken 
+ * by the iterator in "first" and "last", the stride in "stride",
+ * and return isl_bool_true.
+ * Return isl_bool_false if any of them is not a constant, or if the loop 
+ * is empty.
+ */
+isl_bool isl_ast_node_for_get_const_range(__isl_keep isl_ast_node *node,
+    long *first, long *last, long *stride)
+{
+  isl_ast_expr *init, *cond, *inc, *ub;
+  enum isl_ast_op_type op;
+  isl_bool is_const = isl_bool_false;
+
+  init = isl_ast_node_for_get_init(node);
+  cond = isl_ast_node_for_get_cond(node);
+  inc = isl_ast_node_for_get_inc(node);
+  if (isl_ast_expr_get_type(init) != isl_ast_expr_int ||
+      isl_ast_expr_get_type(inc) != isl_ast_expr_int ||
+      isl_ast_expr_get_type(cond) != isl_ast_expr_op)
+    goto done;
+  op = isl_ast_expr_get_op_type(cond);
+  if (op != isl_ast_op_le && op != isl_ast_op_lt)
+    goto done;
+  ub = isl_ast_expr_get_op_arg(cond, 1);
+  if (isl_ast_expr_get_type(ub) == isl_ast_expr_int)
+  {
+    *first = isl_val_get_num(isl_ast_expr_get_val(init));
+    *last = isl_val_get_num(isl_ast_expr_get_val(ub));
+    *stride = isl_val_get_num(isl_ast_expr_get_val(inc));
+    if (op == isl_ast_op_lt)
+      (*last)--;
+    if (*stride > 0 && *last >= *first)
+    {
+      *last = *first + (*last - *first) / *stride * *stride;
+      is_const = isl_bool_true;
+    }
+  }
+  isl_ast_expr_free(ub);
+
+done:
+  isl_ast_expr_free(init);
+  isl_ast_expr_free(cond);
+  isl_ast_expr_free(inc);
+
+  return is_const;
+}
+
+struct find_mark_data {
+  const char *name;
+  int found;
+};
+
+static isl_bool find_mark(__isl_keep isl_ast_node *node, void *user)
+{
+  struct find_mark_data *data = (struct find_mark_data *)user;
+
+  if (isl_ast_node_get_type(node) == isl_ast_node_mark)
+  {
+    isl_id *id = isl_ast_node_mark_get_id(node);
+    if (!strcmp(isl_id_get_name(id), data->name))
+      data->found = 1;
+    isl_id_free(id);
+  }
+
+  return data->found ? isl_bool_false : isl_bool_true;
+}
+
+/* Does the AST "node" or any of its descendants contain a mark 
+ * with name "name"?
+ */
+isl_bool isl_ast_node_has_mark(__isl_keep isl_ast_node *node, const char *name)
+{
+  struct find_mark_data data = {name, 0};
+
+  if (!node)
+    return isl_bool_error;
+  isl_ast_node_foreach_descendant_top_down(node, &find_mark, &data);
+
+  return data.found ? isl_bool_true : isl_bool_false;
+}
@@ -45,5 +45,8 @@ char *isl_vec_to_str(__isl_keep isl_vec *vec);
 long isl_val_get_num(__isl_take isl_val *val);
 long compute_set_min(__isl_keep isl_set *set, int dim);
 long compute_set_max(__isl_keep isl_set *set, int dim);
+isl_bool isl_ast_node_for_get_const_range(__isl_keep isl_ast_node *node,
+    long *first, long *last, long *stride);
+isl_bool isl_ast_node_has_mark(__isl_keep isl_ast_node *node, const char *name);
 
 #endif
\ No newline at end of file
@@ -32,7 +32,8 @@ static void print_xilinx_host_header(FILE *fp)
 {
   fprintf(fp, "#include <iostream>\n");
   fprintf(fp, "#include <vector>\n");
-  fprintf(fp, "#include <fstream>\n\n");
+  fprintf(fp, "#include <fstream>\n");
+  fprintf(fp, "#include <thread>\n\n");
 
   fprintf(fp, "#define CL_HPP_CL_1_2_DEFAULT_BUILD\n");
   fprintf(fp, "#define CL_HPP_TARGET_OPENCL_VERSION 120\n");
@@ -1438,6 +1439,14 @@ static __isl_give isl_printer *clear_device_xilinx(__isl_take isl_printer *p,
   return p;
 }
 
+/* Print the merging of the results drained through the different 
+ * memory ports of the array of "func".
+ * Each port writes to a disjoint set of array elements. 
+ * For the OpenCL host, the ports are therefore merged in parallel, 
+ * with one thread per port.
+ * The results are merged into the buffer of the first port, which 
+ * therefore needs no merging itself.
+ */
 static __isl_give isl_printer *drain_merge_xilinx(
     __isl_take isl_printer *p, struct autosa_prog *prog,
     struct autosa_drain_merge_func *func,
@@ -1445,9 +1454,15 @@ static __isl_give isl_printer *drain_merge_xilinx(
 {
   struct autosa_array_ref_group *group = func->group;
   p = print_str_new_line(p, "// Merge results");
+  if (!hls)
+  {
+    p = print_str_new_line(p, "{");
+    p = isl_printer_indent(p, 2);
+    p = print_str_new_line(p, "std::vector<std::thread> merge_threads;");
+  }
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "for (int idx = ");
-  p = isl_printer_print_int(p, group->mem_port_id);
+  p = isl_printer_print_int(p, group->mem_port_id == 0 ? 1 : group->mem_port_id);
   p = isl_printer_print_str(p, "; idx < ");
   p = isl_printer_print_int(p, group->mem_port_id + group->n_mem_ports);
   p = isl_printer_print_str(p, "; idx++) {");
@@ -1455,14 +1470,25 @@ static __isl_give isl_printer *drain_merge_xilinx(
 
   p = isl_printer_indent(p, 2);
   p = isl_printer_start_line(p);
+  if (!hls)
+    p = isl_printer_print_str(p, "merge_threads.push_back(std::thread([&, idx]() { ");
   p = autosa_array_ref_group_print_prefix(group, p);
   p = isl_printer_print_str(p, "_drain_merge(");
   p = print_drain_merge_arguments(p, func->kernel, group, func, 0, hls);
   p = isl_printer_print_str(p, ");");
+  if (!hls)
+    p = isl_printer_print_str(p, " }));");
   p = isl_printer_end_line(p);
 
   p = isl_printer_indent(p, -2);
   p = print_str_new_line(p, "}");
+  if (!hls)
+  {
+    p = print_str_new_line(p, "for (auto &t : merge_threads)");
+    p = print_str_new_line(p, "  t.join();");
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "}");
+  }
   p = isl_printer_end_line(p);
   return p;
 }
@@ -1983,23 +2009,10 @@ static __isl_give isl_printer *print_module_header_xilinx(
     struct autosa_prog *prog, struct autosa_hw_module *module,
     int inter, int boundary)
 {
-  int n = isl_id_list_n_id(module->inst_ids);;
-  int first = 1;
+  int n = isl_id_list_n_id(module->inst_ids);
 
-  if (n > 0 && prog->scop->options->autosa->use_cplusplus_template) {
-    /* Print the index template */
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "template<");  
-    for (int i = 0; i < n; i++) {
-      if (!first)
-        p = isl_printer_print_str(p, ", ");
-      p = isl_printer_print_str(p, "int p");
-      p = isl_printer_print_int(p, i);    
-      first = 0;
-    }
-    p = isl_printer_print_str(p, ">");
-    p = isl_printer_end_line(p);
-  }
+  if (prog->scop->options->autosa->use_cplusplus_template)
+    p = print_module_template_params(p, n);
 
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "void ");
@@ -2332,28 +2345,617 @@ static __isl_give isl_printer *print_module_vars_xilinx(__isl_take isl_printer *
 //  return p;
 //}
 
-static __isl_give isl_printer *print_for_with_pipeline(
+/* Return the largest value the iterator of the for node "node" takes, 
+ * including the value at loop exit, if the loop starts from a non-negative
+ * constant, has a constant stride and a constant upper bound.
+ * Return -1 otherwise.
+ */
+static long extract_for_iterator_max(__isl_keep isl_ast_node *node)
+{
+  long first, last, stride;
+
+  if (isl_ast_node_for_get_const_range(node, &first, &last, &stride) != 
+      isl_bool_true || first < 0)
+    return -1;
+
+  return last + stride;
+}
+
+/* Print the HLS pragmas of the for node "node" at the beginning of the 
+ * loop body.
+ * The pragmas are derived from the chain of marks directly under the loop.
+ * An "hls_pipeline" mark pipelines the loop unless there is another 
+ * "hls_pipeline" mark further inside, in which case the inner loop 
+ * is pipelined instead. 
+ * An "hls_unroll" mark unrolls the loop.
+ * An "hls_dependence.x" mark removes the inter-iteration dependence 
+ * on "x" of the pipelined loop.
+ * "pipeline" and "unroll" are set if the loop is already known 
+ * to be pipelined or unrolled.
+ */
+static __isl_give isl_printer *print_for_pragmas_xilinx(
+    __isl_take isl_printer *p, __isl_keep isl_ast_node *node, 
+    int pipeline, int unroll)
+{
+  isl_ast_node *body, *child;
+  const char *prefix = "hls_dependence.";
+
+  body = isl_ast_node_for_get_body(node);
+  while (isl_ast_node_get_type(body) == isl_ast_node_mark)
+  {
+    isl_id *id = isl_ast_node_mark_get_id(body);
+    child = isl_ast_node_mark_get_node(body);
+    if (!strcmp(isl_id_get_name(id), "hls_pipeline"))
+    {
+      if (isl_ast_node_has_mark(child, "hls_pipeline") == isl_bool_false)
+        pipeline = 1;
+    }
+    else if (!strcmp(isl_id_get_name(id), "hls_unroll"))
+    {
+      unroll = 1;
+    }
+    isl_id_free(id);
+    isl_ast_node_free(body);
+    body = child;
+  }
+  isl_ast_node_free(body);
+
+  if (pipeline)
+    p = print_str_new_line(p, "#pragma HLS PIPELINE II=1");
+  else if (unroll)
+    p = print_str_new_line(p, "#pragma HLS UNROLL");
+  if (!pipeline)
+    return p;
+
+  body = isl_ast_node_for_get_body(node);
+  while (isl_ast_node_get_type(body) == isl_ast_node_mark)
+  {
+    isl_id *id = isl_ast_node_mark_get_id(body);
+    const char *name = isl_id_get_name(id);
+    if (!strncmp(name, prefix, strlen(prefix)))
+    {
+      p = isl_printer_start_line(p);
+      p = isl_printer_print_str(p, "#pragma HLS DEPENDENCE variable=");
+      p = isl_printer_print_str(p, name + strlen(prefix));
+      p = isl_printer_print_str(p, " inter false");
+      p = isl_printer_end_line(p);
+    }
+    isl_id_free(id);
+    child = isl_ast_node_mark_get_node(body);
+    isl_ast_node_free(body);
+    body = child;
+  }
+  isl_ast_node_free(body);
+
+  return p;
+}
+
+/* Return the body of the for node "node" without the HLS marks directly
+ * under the loop. These marks are printed as pragmas by
+ * print_for_pragmas_xilinx and would otherwise be printed as comments.
+ */
+static __isl_give isl_ast_node *for_body_skip_hls_marks(
+    __isl_keep isl_ast_node *node)
+{
+  isl_ast_node *body, *child;
+
+  body = isl_ast_node_for_get_body(node);
+  while (isl_ast_node_get_type(body) == isl_ast_node_mark)
+  {
+    isl_id *id = isl_ast_node_mark_get_id(body);
+    int hls = !strncmp(isl_id_get_name(id), "hls_", strlen("hls_"));
+    isl_id_free(id);
+    if (!hls)
+      break;
+    child = isl_ast_node_mark_get_node(body);
+    isl_ast_node_free(body);
+    body = child;
+  }
+
+  return body;
+}
+
+/* Print the for node "node" with the HLS pragmas inserted in the loop body 
+ * and the loop iterator narrowed to the bit width required by 
+ * the loop bounds.
+ * Degenerate loops are printed as is, unless they hold HLS marks, in which
+ * case the iterator is declared in a block without the marks.
+ */
+static __isl_give isl_printer *print_for_with_pragmas(
     __isl_keep isl_ast_node *node, __isl_take isl_printer *p,
-    __isl_take isl_ast_print_options *print_options)
+    __isl_take isl_ast_print_options *print_options,
+    int pipeline, int unroll)
 {
+  isl_ast_expr *iterator, *init, *cond, *inc;
+  isl_ast_node *body;
+
+  if (isl_ast_node_for_is_degenerate(node))
+  {
+    isl_ast_node *full_body = isl_ast_node_for_get_body(node);
+    body = for_body_skip_hls_marks(node);
+    if (body == full_body)
+    {
+      isl_ast_node_free(full_body);
+      isl_ast_node_free(body);
+      return isl_ast_node_for_print(node, p, print_options);
+    }
+    isl_ast_node_free(full_body);
+    iterator = isl_ast_node_for_get_iterator(node);
+    init = isl_ast_node_for_get_init(node);
+    p = print_str_new_line(p, "{");
+    p = isl_printer_indent(p, 2);
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p,
+        isl_options_get_ast_iterator_type(isl_printer_get_ctx(p)));
+    p = isl_printer_print_str(p, " ");
+    p = isl_printer_print_ast_expr(p, iterator);
+    p = isl_printer_print_str(p, " = ");
+    p = isl_printer_print_ast_expr(p, init);
+    p = isl_printer_print_str(p, ";");
+    p = isl_printer_end_line(p);
+    p = isl_ast_node_print(body, p, print_options);
+    p = isl_printer_indent(p, -2);
+    p = print_str_new_line(p, "}");
+    isl_ast_expr_free(iterator);
+    isl_ast_expr_free(init);
+    isl_ast_node_free(body);
+    return p;
+  }
+
+  iterator = isl_ast_node_for_get_iterator(node);
+  init = isl_ast_node_for_get_init(node);
+  cond = isl_ast_node_for_get_cond(node);
+  inc = isl_ast_node_for_get_inc(node);
+  body = for_body_skip_hls_marks(node);
+
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "for (");
+  p = autosa_print_iterator_type(p, extract_for_iterator_max(node), XILINX_HW);
+  p = isl_printer_print_str(p, " ");
+  p = isl_printer_print_ast_expr(p, iterator);
+  p = isl_printer_print_str(p, " = ");
+  p = isl_printer_print_ast_expr(p, init);
+  p = isl_printer_print_str(p, "; ");
+  p = isl_printer_print_ast_expr(p, cond);
+  p = isl_printer_print_str(p, "; ");
+  p = isl_printer_print_ast_expr(p, iterator);
+  p = isl_printer_print_str(p, " += ");
+  p = isl_printer_print_ast_expr(p, inc);
+  p = isl_printer_print_str(p, ") {");
+  p = isl_printer_end_line(p);
+  p = isl_printer_indent(p, 2);
+  p = print_for_pragmas_xilinx(p, node, pipeline, unroll);
+  p = isl_ast_node_print(body, p, print_options);
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+
+  isl_ast_expr_free(iterator);
+  isl_ast_expr_free(init);
+  isl_ast_expr_free(cond);
+  isl_ast_expr_free(inc);
+  isl_ast_node_free(body);
+
+  return p;
+}
+
+/* Print the perfect loop nest of "n" loops rooted at the for node "node"
+ * as a single pipelined loop (see loop_flatten_optimize).
+ * The original iterators are declared before the flattened loop and are
+ * advanced at the end of each iteration, with the innermost iterator 
+ * advancing first.
+ */
+static __isl_give isl_printer *print_for_with_flatten(
+    __isl_keep isl_ast_node *node, __isl_take isl_printer *p,
+    __isl_take isl_ast_print_options *print_options, int n)
+{
+  isl_ctx *ctx = isl_printer_get_ctx(p);
+  std::vector<isl_ast_node *> loops;
+  std::vector<char *> iters;
+  std::vector<long> firsts, lasts, strides;
+  isl_ast_node *body;
+  isl_ast_expr *iterator;
+  isl_id *id;
+  long trip = 1;
+  char *flat_iter;
+
+  loops.push_back(isl_ast_node_copy(node));
+  for (int i = 0; i < n; i++)
+  {
+    long first, last, stride;
+
+    isl_ast_node_for_get_const_range(loops[i], &first, &last, &stride);
+    firsts.push_back(first);
+    lasts.push_back(last);
+    strides.push_back(stride);
+    trip *= (last - first) / stride + 1;
+    iterator = isl_ast_node_for_get_iterator(loops[i]);
+    id = isl_ast_expr_get_id(iterator);
+    iters.push_back(strdup(isl_id_get_name(id)));
+    isl_id_free(id);
+    isl_ast_expr_free(iterator);
+    if (i == n - 1)
+      break;
+    /* Skip the marks between the loops. */
+    body = isl_ast_node_for_get_body(loops[i]);
+    while (isl_ast_node_get_type(body) == isl_ast_node_mark)
+    {
+      isl_ast_node *child = isl_ast_node_mark_get_node(body);
+      isl_ast_node_free(body);
+      body = child;
+    }
+    loops.push_back(body);
+  }
+  flat_iter = concat(ctx, iters[0], "flat");
+
   p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "#pragma HLS PIPELINE II=1");
+  p = isl_printer_print_str(p, "// loop flatten:");
+  for (int i = 0; i < n; i++)
+  {
+    p = isl_printer_print_str(p, i == 0 ? " " : ", ");
+    p = isl_printer_print_str(p, iters[i]);
+  }
   p = isl_printer_end_line(p);
+  p = print_str_new_line(p, "{");
+  p = isl_printer_indent(p, 2);
+  for (int i = 0; i < n; i++)
+  {
+    p = isl_printer_start_line(p);
+    p = autosa_print_iterator_type(p, extract_for_iterator_max(loops[i]), 
+                                   XILINX_HW);
+    p = isl_printer_print_str(p, " ");
+    p = isl_printer_print_str(p, iters[i]);
+    p = isl_printer_print_str(p, " = ");
+    p = isl_printer_print_int(p, firsts[i]);
+    p = isl_printer_print_str(p, ";");
+    p = isl_printer_end_line(p);
+  }
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "for (");
+  p = autosa_print_iterator_type(p, trip, XILINX_HW);
+  p = isl_printer_print_str(p, " ");
+  p = isl_printer_print_str(p, flat_iter);
+  p = isl_printer_print_str(p, " = 0; ");
+  p = isl_printer_print_str(p, flat_iter);
+  p = isl_printer_print_str(p, " < ");
+  p = isl_printer_print_int(p, trip);
+  p = isl_printer_print_str(p, "; ");
+  p = isl_printer_print_str(p, flat_iter);
+  p = isl_printer_print_str(p, "++) {");
+  p = isl_printer_end_line(p);
+  p = isl_printer_indent(p, 2);
+  p = print_for_pragmas_xilinx(p, loops[n - 1], 1, 0);
+  body = for_body_skip_hls_marks(loops[n - 1]);
+  p = isl_ast_node_print(body, p, print_options);
+  isl_ast_node_free(body);
+
+  /* Advance the iterators. */
+  for (int i = n - 1; i > 0; i--)
+  {
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, "if (");
+    p = isl_printer_print_str(p, iters[i]);
+    p = isl_printer_print_str(p, " == ");
+    p = isl_printer_print_int(p, lasts[i]);
+    p = isl_printer_print_str(p, ") {");
+    p = isl_printer_end_line(p);
+    p = isl_printer_indent(p, 2);
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, iters[i]);
+    p = isl_printer_print_str(p, " = ");
+    p = isl_printer_print_int(p, firsts[i]);
+    p = isl_printer_print_str(p, ";");
+    p = isl_printer_end_line(p);
+  }
+  for (int i = 0; i < n; i++)
+  {
+    if (i > 0)
+    {
+      p = isl_printer_indent(p, -2);
+      p = print_str_new_line(p, "} else {");
+      p = isl_printer_indent(p, 2);
+    }
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, iters[i]);
+    p = isl_printer_print_str(p, " += ");
+    p = isl_printer_print_int(p, strides[i]);
+    p = isl_printer_print_str(p, ";");
+    p = isl_printer_end_line(p);
+    if (i > 0)
+    {
+      p = isl_printer_indent(p, -2);
+      p = print_str_new_line(p, "}");
+    }
+  }
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
 
-  p = isl_ast_node_for_print(node, p, print_options);
+  for (int i = 0; i < n; i++)
+  {
+    isl_ast_node_free(loops[i]);
+    free(iters[i]);
+  }
+  free(flat_iter);
 
   return p;
 }
 
-static __isl_give isl_printer *print_for_with_unroll(
+/* If the body of the for node "node" is an "hls_unroll" mark of a SIMD 
+ * reduction loop (see insert_unroll_mark), return the kernel of the mark 
+ * and the reduction statement under the mark in "stmt". 
+ * Return NULL if the loop should be printed as is, i.e., if the mark does not
+ * carry the kernel, or the body of the mark is not a single reduction statement.
+ */
+static struct autosa_kernel *extract_simd_reduction_stmt(
+    __isl_keep isl_ast_node *node, struct autosa_kernel_stmt **stmt)
+{
+  isl_ast_node *body, *child;
+  isl_id *id;
+  struct autosa_kernel *kernel = NULL;
+
+  body = isl_ast_node_for_get_body(node);
+  if (isl_ast_node_get_type(body) != isl_ast_node_mark)
+  {
+    isl_ast_node_free(body);
+    return NULL;
+  }
+  id = isl_ast_node_mark_get_id(body);
+  if (!strcmp(isl_id_get_name(id), "hls_unroll"))
+    kernel = (struct autosa_kernel *)isl_id_get_user(id);
+  isl_id_free(id);
+  child = isl_ast_node_mark_get_node(body);
+  isl_ast_node_free(body);
+
+  if (kernel && isl_ast_node_get_type(child) == isl_ast_node_user)
+  {
+    id = isl_ast_node_get_annotation(child);
+    *stmt = id ? (struct autosa_kernel_stmt *)isl_id_get_user(id) : NULL;
+    isl_id_free(id);
+    if (!*stmt || (*stmt)->type != AUTOSA_KERNEL_STMT_DOMAIN ||
+        autosa_stmt_is_reduction((*stmt)->u.d.stmt, NULL, NULL, NULL) != isl_bool_true)
+      kernel = NULL;
+  }
+  else
+  {
+    kernel = NULL;
+  }
+  isl_ast_node_free(child);
+
+  return kernel;
+}
+
+/* Return the element type of the array accessed by the reference "ref_id"
+ * of the statement "stmt" in "kernel".
+ */
+static const char *find_reference_array_type(struct autosa_kernel *kernel,
+                                             struct autosa_stmt *stmt, __isl_keep isl_id *ref_id)
+{
+  struct autosa_stmt_access *access;
+
+  for (access = stmt->accesses; access; access = access->next)
+  {
+    const char *name;
+    if (access->ref_id != ref_id)
+      continue;
+    name = isl_map_get_tuple_name(access->access, isl_dim_out);
+    for (int i = 0; i < kernel->n_array; i++)
+    {
+      if (!strcmp(kernel->array[i].array->name, name))
+        return kernel->array[i].array->type;
+    }
+  }
+
+  return NULL;
+}
+
+/* Return the string "name[lane]". */
+static char *print_lane_str(isl_ctx *ctx, const char *name, int lane)
+{
+  isl_printer *p_str;
+  char *str;
+
+  p_str = isl_printer_to_str(ctx);
+  p_str = isl_printer_print_str(p_str, name);
+  p_str = isl_printer_print_str(p_str, "[");
+  p_str = isl_printer_print_int(p_str, lane);
+  p_str = isl_printer_print_str(p_str, "]");
+  str = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+
+  return str;
+}
+
+/* Print "dst = src0 op src1", where "op" is either a binary operator or 
+ * the name of a max/min function.
+ */
+static __isl_give isl_printer *print_reduction_update(__isl_take isl_printer *p,
+                                                      const char *op, const char *dst,
+                                                      const char *src0, const char *src1)
+{
+  int is_func = strcmp(op, "+") && strcmp(op, "*");
+
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, dst);
+  p = isl_printer_print_str(p, " = ");
+  if (is_func)
+  {
+    p = isl_printer_print_str(p, op);
+    p = isl_printer_print_str(p, "(");
+    p = isl_printer_print_str(p, src0);
+    p = isl_printer_print_str(p, ", ");
+    p = isl_printer_print_str(p, src1);
+    p = isl_printer_print_str(p, ")");
+  }
+  else
+  {
+    p = isl_printer_print_str(p, src0);
+    p = isl_printer_print_str(p, " ");
+    p = isl_printer_print_str(p, op);
+    p = isl_printer_print_str(p, " ");
+    p = isl_printer_print_str(p, src1);
+  }
+  p = isl_printer_print_str(p, ";");
+  p = isl_printer_end_line(p);
+
+  return p;
+}
+
+/* Print the SIMD reduction loop "node" with the updates of the SIMD lanes
+ * combined by a balanced reduction tree.
+ * Printing the loop as is chains all the unrolled updates through the 
+ * reduction variable, e.g.,
+ *
+ *   for (c8 = 0; c8 <= 3; c8 += 1)
+ *     local_C[c7][c6] += local_A[0][c8] * local_B[0][c8];
+ *
+ * which HLS is not allowed to reassociate for floating-point types and 
+ * which results in a pipeline depth linear in the SIMD width.
+ * Instead, each lane updates its own partial result and the partial results
+ * are combined pairwise in ceil(log2(simd_w)) levels, i.e.,
+ *
+ *   {
+ *     float local_C_lane[4];
+ *     #pragma HLS ARRAY_PARTITION variable=local_C_lane complete
+ *     local_C_lane[0] = 0;
+ *     ...
+ *     for (c8 = 0; c8 <= 3; c8 += 1)
+ *       local_C_lane[c8] += local_A[0][c8] * local_B[0][c8];
+ *     local_C_lane[0] = local_C_lane[0] + local_C_lane[2];
+ *     local_C_lane[1] = local_C_lane[1] + local_C_lane[3];
+ *     local_C_lane[0] = local_C_lane[0] + local_C_lane[1];
+ *     local_C[c7][c6] = local_C[c7][c6] + local_C_lane[0];
+ *   }
+ *
+ * The lanes are initialized with the identity of the reduction operator.
+ * For max/min reductions, there is no such identity and the lanes are
+ * initialized with the value of the reduction variable instead, which 
+ * is then overwritten by the result of the tree.
+ * The reduction statement is printed with the reduction references
+ * temporarily mapped to the lanes.
+ */
+static __isl_give isl_printer *print_for_with_reduce_tree(
     __isl_keep isl_ast_node *node, __isl_take isl_printer *p,
-    __isl_take isl_ast_print_options *print_options)
+    __isl_take isl_ast_print_options *print_options,
+    struct autosa_kernel *kernel, struct autosa_kernel_stmt *stmt)
 {
+  isl_ctx *ctx = isl_printer_get_ctx(p);
+  isl_id *write_ref = NULL, *read_ref = NULL, *lane_id;
+  isl_id_to_ast_expr *ref2expr;
+  isl_ast_expr *lhs, *arr, *lane;
+  isl_printer *p_str;
+  char *op = NULL, *lhs_str, *lane_name, *root;
+  const char *type;
+  int identity, n_lane = kernel->simd_w;
+
+  autosa_stmt_is_reduction(stmt->u.d.stmt, &write_ref, &read_ref, &op);
+  type = find_reference_array_type(kernel, stmt->u.d.stmt, write_ref);
+  ref2expr = stmt->u.d.ref2expr;
+  lhs = isl_id_to_ast_expr_get(ref2expr, isl_id_copy(write_ref));
+  arr = isl_ast_expr_get_type(lhs) == isl_ast_expr_op ? 
+          isl_ast_expr_get_op_arg(lhs, 0) : isl_ast_expr_copy(lhs);
+  if (!type || isl_ast_expr_get_type(arr) != isl_ast_expr_id)
+  {
+    /* Fall back to the default unrolled loop. */
+    isl_ast_expr_free(arr);
+    isl_ast_expr_free(lhs);
+    isl_id_free(write_ref);
+    isl_id_free(read_ref);
+    free(op);
+    return print_for_with_pragmas(node, p, print_options, 0, 1);
+  }
+  identity = !strcmp(op, "+") || !strcmp(op, "*");
+
+  lane_id = isl_ast_expr_get_id(arr);
+  lane_name = concat(ctx, isl_id_get_name(lane_id), "lane");
+  isl_id_free(lane_id);
+  isl_ast_expr_free(arr);
+  p_str = isl_printer_to_str(ctx);
+  p_str = isl_printer_set_output_format(p_str, ISL_FORMAT_C);
+  p_str = isl_printer_print_ast_expr(p_str, lhs);
+  lhs_str = isl_printer_get_str(p_str);
+  isl_printer_free(p_str);
+  isl_ast_expr_free(lhs);
+
+  p = print_str_new_line(p, "// simd reduction tree");
+  p = print_str_new_line(p, "{");
+  p = isl_printer_indent(p, 2);
   p = isl_printer_start_line(p);
-  p = isl_printer_print_str(p, "#pragma HLS UNROLL");
+  p = isl_printer_print_str(p, type);
+  p = isl_printer_print_str(p, " ");
+  p = isl_printer_print_str(p, lane_name);
+  p = isl_printer_print_str(p, "[");
+  p = isl_printer_print_int(p, n_lane);
+  p = isl_printer_print_str(p, "];");
   p = isl_printer_end_line(p);
+  p = isl_printer_start_line(p);
+  p = isl_printer_print_str(p, "#pragma HLS ARRAY_PARTITION variable=");
+  p = isl_printer_print_str(p, lane_name);
+  p = isl_printer_print_str(p, " complete");
+  p = isl_printer_end_line(p);
+  for (int l = 0; l < n_lane; l++)
+  {
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, lane_name);
+    p = isl_printer_print_str(p, "[");
+    p = isl_printer_print_int(p, l);
+    p = isl_printer_print_str(p, "] = ");
+    if (identity)
+      p = isl_printer_print_str(p, !strcmp(op, "*") ? "1" : "0");
+    else
+      p = isl_printer_print_str(p, lhs_str);
+    p = isl_printer_print_str(p, ";");
+    p = isl_printer_end_line(p);
+  }
 
-  p = isl_ast_node_for_print(node, p, print_options);
+  /* Print the unrolled loop with the reduction references mapped to the lanes. */
+  lane_id = isl_id_alloc(ctx, lane_name, NULL);
+  lane = isl_ast_expr_access(isl_ast_expr_from_id(lane_id),
+            isl_ast_expr_list_from_ast_expr(isl_ast_node_for_get_iterator(node)));
+  stmt->u.d.ref2expr = isl_id_to_ast_expr_set(isl_id_to_ast_expr_copy(ref2expr),
+                          isl_id_copy(write_ref), isl_ast_expr_copy(lane));
+  stmt->u.d.ref2expr = isl_id_to_ast_expr_set(stmt->u.d.ref2expr,
+                          isl_id_copy(read_ref), lane);
+  p = print_for_with_pragmas(node, p, print_options, 0, 1);
+  isl_id_to_ast_expr_free(stmt->u.d.ref2expr);
+  stmt->u.d.ref2expr = ref2expr;
+
+  /* Combine the lanes pairwise. */
+  for (int n = n_lane; n > 1; n = (n + 1) / 2)
+  {
+    int half = (n + 1) / 2;
+    for (int l = 0; l + half < n; l++)
+    {
+      char *dst = print_lane_str(ctx, lane_name, l);
+      char *src = print_lane_str(ctx, lane_name, l + half);
+      p = print_reduction_update(p, op, dst, dst, src);
+      free(dst);
+      free(src);
+    }
+  }
+  root = print_lane_str(ctx, lane_name, 0);
+  if (identity)
+  {
+    p = print_reduction_update(p, op, lhs_str, lhs_str, root);
+  }
+  else
+  {
+    p = isl_printer_start_line(p);
+    p = isl_printer_print_str(p, lhs_str);
+    p = isl_printer_print_str(p, " = ");
+    p = isl_printer_print_str(p, root);
+    p = isl_printer_print_str(p, ";");
+    p = isl_printer_end_line(p);
+  }
+  free(root);
+  p = isl_printer_indent(p, -2);
+  p = print_str_new_line(p, "}");
+
+  free(lane_name);
+  free(lhs_str);
+  free(op);
+  isl_id_free(write_ref);
+  isl_id_free(read_ref);
 
   return p;
 }
@@ -2365,9 +2967,13 @@ static __isl_give isl_printer *print_for_xilinx(__isl_take isl_printer *p,
   isl_id *id;
   int pipeline;
   int unroll;
+  int n_flatten_loop;
+  struct autosa_kernel *kernel;
+  struct autosa_kernel_stmt *stmt = NULL;
 
   pipeline = 0;
   unroll = 0;
+  n_flatten_loop = 0;
   id = isl_ast_node_get_annotation(node);
 
   if (id)
@@ -2379,14 +2985,21 @@ static __isl_give isl_printer *print_for_xilinx(__isl_take isl_printer *p,
       pipeline = 1;
     if (info && info->is_unroll)
       unroll = 1;
+    if (info)
+      n_flatten_loop = info->n_flatten_loop;
+  }
+  if (n_flatten_loop > 1)
+  {
+    isl_id_free(id);
+    return print_for_with_flatten(node, p, print_options, n_flatten_loop);
   }
 
-  if (pipeline)
-    p = print_for_with_pipeline(node, p, print_options);
-  else if (unroll)
-    p = print_for_with_unroll(node, p, print_options);
+  kernel = extract_simd_reduction_stmt(node, &stmt);
+
+  if (kernel && !pipeline)
+    p = print_for_with_reduce_tree(node, p, print_options, kernel, stmt);
   else
-    p = isl_ast_node_for_print(node, p, print_options);
+    p = print_for_with_pragmas(node, p, print_options, pipeline, unroll);
 
   isl_id_free(id);
 
@@ -2616,19 +3229,8 @@ static __isl_give isl_printer *print_module_core_header_xilinx(
     int inter, int boundary, int serialize, int types)
 {
   int n = isl_id_list_n_id(module->inst_ids);
-  if (types && n > 0 && prog->scop->options->autosa->use_cplusplus_template) {
-    /* Print the template */
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "template<");
-    for (int i = 0; i < n; i++) {
-      if (i > 0)
-        p = isl_printer_print_str(p, ", ");
-      p = isl_printer_print_str(p, "int p");
-      p = isl_printer_print_int(p, i);
-    }
-    p = isl_printer_print_str(p, ">");
-    p = isl_printer_end_line(p);
-  }
+  if (types && prog->scop->options->autosa->use_cplusplus_template)
+    p = print_module_template_params(p, n);
 
   p = isl_printer_start_line(p);  
   if (types)
@@ -2642,16 +3244,8 @@ static __isl_give isl_printer *print_module_core_header_xilinx(
     p = isl_printer_print_str(p, "_boundary");
   if (serialize)
     p = isl_printer_print_str(p, "_serialize");
-  if (!types && n > 0 && prog->scop->options->autosa->use_cplusplus_template) {
-    p = isl_printer_print_str(p, "<");
-    for (int i = 0; i < n; i++) {
-      if (i > 0)
-        p = isl_printer_print_str(p, ", ");
-      p = isl_printer_print_str(p, "p");
-      p = isl_printer_print_int(p, i);
-    }
-    p = isl_printer_print_str(p, ">");
-  }
+  if (!types && prog->scop->options->autosa->use_cplusplus_template)
+    p = print_module_template_args(p, n);
   p = isl_printer_print_str(p, "(");
   if (!types) {
     p = isl_printer_end_line(p);
@@ -2684,18 +3278,8 @@ static __isl_give isl_printer *print_module_wrapper_header_xilinx(
     int inter, int boundary)
 {
   int n = isl_id_list_n_id(module->inst_ids);
-  if (n > 0 && prog->scop->options->autosa->use_cplusplus_template) {
-    p = isl_printer_start_line(p);
-    p = isl_printer_print_str(p, "template<");
-    for (int i = 0; i < n; i++) {
-      if (i > 0)
-        p = isl_printer_print_str(p, ", ");
-      p = isl_printer_print_str(p, "int p");
-      p = isl_printer_print_int(p, i);        
-    }
-    p = isl_printer_print_str(p, ">");
-    p = isl_printer_end_line(p);
-  }
+  if (prog->scop->options->autosa->use_cplusplus_template)
+    p = print_module_template_params(p, n);
 
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "void ");
@@ -3187,7 +3771,11 @@ static __isl_give isl_printer *print_pe_dummy_module_core_header_xilinx(
     struct autosa_prog *prog, struct autosa_pe_dummy_module *module, int types)
 {
   struct autosa_array_ref_group *group = module->io_group;
+  int n = isl_id_list_n_id(module->module->inst_ids);
+  int use_template = prog->scop->options->autosa->use_cplusplus_template;
 
+  if (types && use_template)
+    p = print_module_template_params(p, n);
   p = isl_printer_start_line(p);
   if (types)
     p = isl_printer_print_str(p, "void ");
@@ -3208,6 +3796,8 @@ static __isl_give isl_printer *print_pe_dummy_module_core_header_xilinx(
   }
   p = isl_printer_print_str(p, "_PE_dummy");
   p = isl_printer_print_str(p, module->in? "_in" : "_out");
+  if (!types && use_template)
+    p = print_module_template_args(p, n);
   p = isl_printer_print_str(p, "(");
   p = print_pe_dummy_module_arguments(p, prog, module->module->kernel,
                                       module, types, XILINX_HW);
@@ -3231,6 +3821,8 @@ static __isl_give isl_printer *print_pe_dummy_module_wrapper_header_xilinx(
 {
   struct autosa_array_ref_group *group = module->io_group;
 
+  if (prog->scop->options->autosa->use_cplusplus_template)
+    p = print_module_template_params(p, isl_id_list_n_id(module->module->inst_ids));
   p = isl_printer_start_line(p);
   p = isl_printer_print_str(p, "void ");
   // group_name
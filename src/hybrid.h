@@ -6,6 +6,11 @@
 
 #include "ppcg.h"
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
 struct ppcg_ht_bounds;
 typedef struct ppcg_ht_bounds ppcg_ht_bounds;
 
@@ -39,4 +44,8 @@ __isl_give isl_schedule_node *hybrid_tile_foreach_phase(
 __isl_give isl_schedule_node *hybrid_tile_drop_phase_marks(
 		__isl_take isl_schedule_node *node);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
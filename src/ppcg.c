@@ -12,9 +12,11 @@
  */
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <isl/ctx.h>
 #include <isl/id.h>
 #include <isl/val.h>
@@ -33,6 +35,7 @@
 #include <isl/constraint.h>
 #include <pet.h>
 #include <math.h>
+#include <cJSON/cJSON.h>
 #include "ppcg.h"
 #include "ppcg_options.h"
 #include "cuda.h"
@@ -1100,6 +1103,244 @@ static void compute_tagged_waw_dep(struct ppcg_scop *ps)
   derive_waw_dep_from_tagged_waw_dep(ps);
 }
 
+/* The fields of ppcg_scop filled in by compute_dependences
+ * that are stored in the dependence cache.
+ */
+static struct {
+	const char *name;
+	size_t offset;
+} dep_cache_fields[] = {
+	{ "live_in", offsetof(struct ppcg_scop, live_in) },
+	{ "live_out", offsetof(struct ppcg_scop, live_out) },
+	{ "tagged_dep_flow", offsetof(struct ppcg_scop, tagged_dep_flow) },
+	{ "dep_flow", offsetof(struct ppcg_scop, dep_flow) },
+	{ "dep_false", offsetof(struct ppcg_scop, dep_false) },
+	{ "dep_forced", offsetof(struct ppcg_scop, dep_forced) },
+	{ "tagged_dep_order", offsetof(struct ppcg_scop, tagged_dep_order) },
+	{ "dep_order", offsetof(struct ppcg_scop, dep_order) },
+	{ "tagged_dep_rar", offsetof(struct ppcg_scop, tagged_dep_rar) },
+	{ "dep_rar", offsetof(struct ppcg_scop, dep_rar) },
+	{ "tagged_dep_waw", offsetof(struct ppcg_scop, tagged_dep_waw) },
+	{ "dep_waw", offsetof(struct ppcg_scop, dep_waw) },
+};
+
+/* Return a pointer to the dependence field "i" of "ps".
+ */
+static isl_union_map **dep_cache_field(struct ppcg_scop *ps, int i)
+{
+	return (isl_union_map **) ((char *) ps + dep_cache_fields[i].offset);
+}
+
+/* Return the path of the dependence cache file.
+ */
+static char *dep_cache_path(struct ppcg_scop *ps)
+{
+	isl_printer *p;
+	char *path;
+
+	p = isl_printer_to_str(isl_set_get_ctx(ps->context));
+	p = isl_printer_print_str(p, ps->options->autosa->output_dir);
+	p = isl_printer_print_str(p, "/dep_cache.json");
+	path = isl_printer_get_str(p);
+	isl_printer_free(p);
+
+	return path;
+}
+
+/* Load the dependence cache from the output directory.
+ * Return an empty cache if the file doesn't exist.
+ */
+static cJSON *load_dep_cache(struct ppcg_scop *ps)
+{
+	FILE *f;
+	char *path, *buffer = NULL;
+	long length;
+	cJSON *cache = NULL;
+
+	path = dep_cache_path(ps);
+	f = fopen(path, "rb");
+	free(path);
+	if (f) {
+		fseek(f, 0, SEEK_END);
+		length = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		buffer = (char *) malloc(length + 1);
+		if (buffer) {
+			size_t n = fread(buffer, 1, length, f);
+			buffer[n] = '\0';
+		}
+		fclose(f);
+	}
+	if (buffer) {
+		cache = cJSON_Parse(buffer);
+		free(buffer);
+	}
+	if (!cJSON_IsObject(cache)) {
+		cJSON_Delete(cache);
+		cache = cJSON_CreateObject();
+	}
+
+	return cache;
+}
+
+/* Save the entry "entry" of the program "key" to the dependence cache
+ * in the output directory.
+ * Several AutoSA processes may share the same output directory.
+ * The cache file is reloaded right before the update and only the entry
+ * of the current program is replaced. The content is written to
+ * a temporary file private to this process, which is then renamed
+ * to the cache file, such that readers never see a partially written cache.
+ */
+static void save_dep_cache(struct ppcg_scop *ps, const char *key,
+	cJSON *entry)
+{
+	FILE *fp;
+	char *path, *tmp_path, *content;
+	cJSON *cache;
+	isl_printer *p;
+
+	cache = load_dep_cache(ps);
+	cJSON_DeleteItemFromObjectCaseSensitive(cache, key);
+	cJSON_AddItemToObject(cache, key, entry);
+	content = cJSON_Print(cache);
+	cJSON_Delete(cache);
+
+	path = dep_cache_path(ps);
+	p = isl_printer_to_str(isl_set_get_ctx(ps->context));
+	p = isl_printer_print_str(p, path);
+	p = isl_printer_print_str(p, ".");
+	p = isl_printer_print_int(p, (int) getpid());
+	p = isl_printer_print_str(p, ".tmp");
+	tmp_path = isl_printer_get_str(p);
+	isl_printer_free(p);
+
+	fp = fopen(tmp_path, "w");
+	if (fp) {
+		fprintf(fp, "%s", content);
+		if (fclose(fp) != 0 || rename(tmp_path, path) != 0)
+			remove(tmp_path);
+	}
+	free(content);
+	free(tmp_path);
+	free(path);
+}
+
+/* Return the key of "ps" in the dependence cache.
+ * The dependences only depend on the context, the iteration domain,
+ * the (tagged) accesses and the schedule of the program, together with
+ * the options that select the dependence analysis.
+ * The key is the 64-bit FNV-1a hash of the textual representation
+ * of all of these.
+ */
+static char *dep_cache_key(struct ppcg_scop *ps)
+{
+	isl_printer *p;
+	char *str;
+	char key[17];
+	unsigned long long hash = 14695981039346656037ULL;
+	int i;
+
+	p = isl_printer_to_str(isl_set_get_ctx(ps->context));
+	p = isl_printer_print_int(p, ps->options->live_range_reordering);
+	p = isl_printer_print_int(p, ps->options->target);
+	p = isl_printer_print_int(p, ps->options->autosa->autosa);
+	p = isl_printer_print_int(p, ps->options->autosa->t2s_tile);
+	p = isl_printer_print_int(p, ps->options->autosa->t2s_tile_phase);
+	p = isl_printer_print_str(p, "|");
+	p = isl_printer_print_set(p, ps->context);
+	p = isl_printer_print_str(p, "|");
+	p = isl_printer_print_union_set(p, ps->domain);
+	p = isl_printer_print_str(p, "|");
+	p = isl_printer_print_union_map(p, ps->tagged_reads);
+	p = isl_printer_print_str(p, "|");
+	p = isl_printer_print_union_map(p, ps->tagged_may_writes);
+	p = isl_printer_print_str(p, "|");
+	p = isl_printer_print_union_map(p, ps->tagged_must_writes);
+	p = isl_printer_print_str(p, "|");
+	p = isl_printer_print_union_map(p, ps->tagged_must_kills);
+	p = isl_printer_print_str(p, "|");
+	p = isl_printer_print_schedule(p, ps->schedule);
+	str = isl_printer_get_str(p);
+	isl_printer_free(p);
+	if (!str)
+		return NULL;
+
+	for (i = 0; str[i]; ++i) {
+		hash ^= (unsigned char) str[i];
+		hash *= 1099511628211ULL;
+	}
+	free(str);
+	snprintf(key, sizeof(key), "%016llx", hash);
+
+	return strdup(key);
+}
+
+/* Fill in the dependences of "ps" from the cache entry "entry".
+ * The maps are read back in the context of "ps".  Since pet
+ * anonymizes all the identifiers of the extracted scop, the read back
+ * maps refer to the same identifiers as the accesses and the schedule
+ * of "ps".
+ * Return 1 if all the stored dependences could be read back and
+ * 0 otherwise, in which case the dependences of "ps" are left untouched.
+ */
+static int read_cached_dependences(struct ppcg_scop *ps, cJSON *entry)
+{
+	isl_ctx *ctx = isl_set_get_ctx(ps->context);
+	int n = sizeof(dep_cache_fields) / sizeof(dep_cache_fields[0]);
+	isl_union_map *deps[sizeof(dep_cache_fields) / sizeof(dep_cache_fields[0])];
+	int i, ok = 1;
+
+	for (i = 0; i < n; ++i) {
+		cJSON *item;
+
+		deps[i] = NULL;
+		item = cJSON_GetObjectItemCaseSensitive(entry,
+						dep_cache_fields[i].name);
+		if (!item)
+			continue;
+		if (!cJSON_IsString(item)) {
+			ok = 0;
+			continue;
+		}
+		deps[i] = isl_union_map_read_from_str(ctx, item->valuestring);
+		if (!deps[i])
+			ok = 0;
+	}
+
+	for (i = 0; i < n; ++i) {
+		if (ok)
+			*dep_cache_field(ps, i) = deps[i];
+		else
+			isl_union_map_free(deps[i]);
+	}
+
+	return ok;
+}
+
+/* Store the dependences of "ps" in a new cache entry.
+ * Dependences that have not been computed are not stored.
+ */
+static cJSON *write_cached_dependences(struct ppcg_scop *ps)
+{
+	int n = sizeof(dep_cache_fields) / sizeof(dep_cache_fields[0]);
+	cJSON *entry;
+	int i;
+
+	entry = cJSON_CreateObject();
+	for (i = 0; i < n; ++i) {
+		isl_union_map *dep = *dep_cache_field(ps, i);
+		char *str;
+
+		if (!dep)
+			continue;
+		str = isl_union_map_to_str(dep);
+		cJSON_AddStringToObject(entry, dep_cache_fields[i].name, str);
+		free(str);
+	}
+
+	return entry;
+}
+
 /* Compute the dependences of the program represented by "scop".
  * Store the computed potential flow dependences
  * in scop->dep_flow and the reads with potentially no corresponding writes in
@@ -1112,16 +1353,42 @@ static void compute_tagged_waw_dep(struct ppcg_scop *ps)
  * in compute_live_range_reordering_dependences.
  * 
  * Extended by AutoSA: Add analysis for WAW and RAR dependences.
+ * If the dependence cache is enabled, the dependences are looked up
+ * in the cache in the output directory first, such that repeated
+ * invocations on the same program (e.g., during design space exploration)
+ * skip the dependence analysis.  Newly computed dependences are
+ * added to the cache.
  */
 static void compute_dependences(struct ppcg_scop *scop)
 {
 	isl_union_map *may_source;
 	isl_union_access_info *access;
 	isl_union_flow *flow;
+	cJSON *dep_cache = NULL;
+	char *dep_key = NULL;
 
 	if (!scop)
 		return;
 
+	if (scop->options->autosa->dep_cache) {
+		cJSON *entry;
+
+		dep_cache = load_dep_cache(scop);
+		dep_key = dep_cache_key(scop);
+		entry = dep_key ?
+			cJSON_GetObjectItemCaseSensitive(dep_cache, dep_key) :
+			NULL;
+		if (entry && read_cached_dependences(scop, entry)) {
+			if (scop->options->autosa->verbose)
+				printf("[AutoSA] Reuse the cached dependences.\n");
+			cJSON_Delete(dep_cache);
+			free(dep_key);
+			return;
+		}
+		if (entry)
+			cJSON_DeleteItemFromObjectCaseSensitive(dep_cache, dep_key);
+	}
+
 	compute_live_out(scop);
 
 	if (scop->options->live_range_reordering)
@@ -1155,6 +1422,14 @@ static void compute_dependences(struct ppcg_scop *scop)
 		compute_tagged_waw_dep(scop);			
 	}
 	/* AutoSA Extended */
+
+	if (dep_cache) {
+		if (dep_key)
+			save_dep_cache(scop, dep_key,
+					write_cached_dependences(scop));
+		cJSON_Delete(dep_cache);
+		free(dep_key);
+	}
 }
 
 /* Eliminate dead code from ps->domain.
@@ -262,6 +262,8 @@ extern "C"
 		isl_union_map *tagged_dep_rar;
 		isl_union_map *dep_waw;
 		isl_union_map *tagged_dep_waw;
+		/* Memoized dependence distances, owned by AutoSA */
+		struct autosa_dep_dis_table *dep_dis;
 		/* AutoSA Extended */
 	};
 
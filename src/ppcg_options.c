@@ -26,6 +26,11 @@ static struct isl_arg_choice sa_type[] = {
 	{"async", AUTOSA_SA_TYPE_ASYNC},
 	{0}};
 
+static struct isl_arg_choice sa_cost_model[] = {
+	{"heuristic", AUTOSA_SA_COST_HEURISTIC},
+	{"analytical", AUTOSA_SA_COST_ANALYTICAL},
+	{0}};
+
 /* Set defaults that depend on the target.
  * In particular, set --schedule-outer-coincidence iff target is a GPU.
  */
@@ -103,10 +108,16 @@ ISL_ARG_BOOL(struct autosa_options, data_pack, 0, "data-pack", 1,
 			 	"enable data packing")
 ISL_ARG_STR(struct autosa_options, data_pack_sizes, 0, "data-pack-sizes", "sizes",
 				NULL, "data pack sizes upper bound (bytes) at innermost, intermediate, outermost I/O level [default: kernel[]->data_pack[8,32,64]]")
+ISL_ARG_BOOL(struct autosa_options, dep_cache, 0, "dep-cache", 0,
+			 	"cache the dependence analysis results across invocations on the same program")
+ISL_ARG_BOOL(struct autosa_options, design_summary, 0, "design-summary", 0,
+			 	"write the design information for latency/resource estimation into a single design summary file")
 ISL_ARG_BOOL(struct autosa_options, double_buffer, 0, "double-buffer", 1,
 			 	"enable double-buffering for data transfer")
 ISL_ARG_INT(struct autosa_options, double_buffer_style, 0, "double-buffer-style", "id", 1,
 				"change double-buffering logic coding style (0: while loop 1: for loop)")
+ISL_ARG_BOOL(struct autosa_options, explore_schedules, 0, "explore-schedules", 0,
+			 	"explore alternative ISL scheduling strategies in parallel")
 ISL_ARG_INT(struct autosa_options, fifo_depth, 0, "fifo-depth", "depth", 2, "default FIFO depth")
 ISL_ARG_BOOL(struct autosa_options, hbm, 0, "hbm", 0,
 			 	"use multi-port DRAM/HBM")
@@ -116,18 +127,28 @@ ISL_ARG_BOOL(struct autosa_options, hls, 0, "hls", 0,
 			 	"generate Xilinx HLS host")
 ISL_ARG_BOOL(struct autosa_options, host_serialize, 0, "host-serialize", 0,
 			 	"serialize/deserialize the host data")
+ISL_ARG_STR(struct autosa_options, hw_info, 0, "hw-info", "info", NULL,
+				"hardware resource budget used by the auto-mode tile size search")
+ISL_ARG_BOOL(struct autosa_options, hybrid_tile, 0, "hybrid-tile", 0,
+			 	"skew time-iterated stencils with the hybrid tiling dependence bounds before the space-time transformation")
 ISL_ARG_BOOL(struct autosa_options, insert_hls_dependence, 0, "insert-hls-dependence", 0,
 			 	"insert Xilinx HLS dependence pragma (alpha version)")
 ISL_ARG_INT(struct autosa_options, int_io_dir, 0, "int-io-dir", "dir", 0,
 			 	"set the default interior I/O direction (0: [1,x] 1: [x,1])")
+ISL_ARG_BOOL(struct autosa_options, io_group_cache, 0, "io-group-cache", 0,
+			 	"cache the I/O grouping and clustering across designs sharing the space-time and array partitioning")
 ISL_ARG_BOOL(struct autosa_options, io_module_embedding, 0, "io-module-embedding", 0,
 			 	"embed the I/O modules inside PEs if possible")
 ISL_ARG_BOOL(struct autosa_options, isl_sink, 0, "isl-sink", 1,
 			 	"sink time loops using ISL default APIs")
 ISL_ARG_BOOL(struct autosa_options, loop_infinitize, 0, "loop-infinitize", 0,
 			 	"apply loop infinitization optimization (Intel OpenCL only)")
+ISL_ARG_BOOL(struct autosa_options, loop_flatten, 0, "loop-flatten", 0,
+			 	"flatten perfect loop nests around pipelined loops (Xilinx HLS only)")
 ISL_ARG_BOOL(struct autosa_options, local_reduce, 0, "local-reduce", 0,
 			 	"generate non-output-stationary array with local reduction")
+ISL_ARG_BOOL(struct autosa_options, local_array_contraction, 0, "local-array-contraction", 0,
+			 	"contract the PE buffers of arrays local to the program by live ranges")
 ISL_ARG_STR(struct autosa_options, reduce_op, 0, "reduce-op", "op",
 				NULL, "reduction operator (must be used with local-reduce together)")			 
 ISL_ARG_BOOL(struct autosa_options, lower_int_io_L1_buffer, 0, "lower-int-io-L1-buffer", 0,
@@ -142,20 +163,30 @@ ISL_ARG_BOOL(struct autosa_options, non_block_fifo, 0, "non-blocking-fifo", 0,
 			 	"use non-blocking fifo interface")
 ISL_ARG_STR(struct autosa_options, output_dir, 0, "output-dir", "dir", "./autosa.tmp/output",
 				"AutoSA Output directory")
+ISL_ARG_BOOL(struct autosa_options, prune_idle_pe, 0, "prune-idle-pe", 0,
+			 	"prune the code of idle PEs for non-rectangular iteration domains")
 ISL_ARG_BOOL(struct autosa_options, reverse_order, 0, "reverse-order", 1,
 			 	"reverse loop tiling order")				
+ISL_ARG_CHOICE(struct autosa_options, sa_cost_model, 0, "sa-cost-model", sa_cost_model,
+				AUTOSA_SA_COST_HEURISTIC, "cost model used to rank the space-time candidates")
 ISL_ARG_STR(struct autosa_options, sa_sizes, 0, "sa-sizes", "sizes", NULL,
 				"per kernel PE optimization tile sizes")
+ISL_ARG_BOOL(struct autosa_options, sa_skew, 0, "sa-skew", 0,
+			 	"explore skewed space-time transformations")
 ISL_ARG_INT(struct autosa_options, sa_tile_size, 0, "sa-tile-size", "size", 4,
 				"default tile size in PE optmization")
 ISL_ARG_USER_OPT_CHOICE(struct autosa_options, sa_type, 0, "sa-type", sa_type,
 				NULL, AUTOSA_SA_TYPE_ASYNC, AUTOSA_SA_TYPE_ASYNC, "systolic array type")
 ISL_ARG_STR(struct autosa_options, simd_info, 0, "simd-info", "info", NULL,
-				"per kernel SIMD information")
+				"per kernel SIMD information (overrides automatic reduction detection)")
 ISL_ARG_BOOL(struct autosa_options, simd_touch_space, 0, "simd-touch-space", 0,
 				"use space loops as SIMD vectorization loops")
+ISL_ARG_BOOL(struct autosa_options, simd_reduce_tree, 0, "simd-reduce-tree", 0,
+				"combine the SIMD lanes of reduction loops with a balanced reduction tree")
 ISL_ARG_BOOL(struct autosa_options, two_level_buffer, 0, "two-level-buffer", 0,
 			 	"enable two-level buffering in I/O modules")
+ISL_ARG_BOOL(struct autosa_options, three_level_buffer, 0, "three-level-buffer", 0,
+			 	"enable three-level buffering in I/O modules (requires two-level buffering)")
 ISL_ARG_BOOL(struct autosa_options, t2s_tile, 0, "t2s-tile", 0,
 			 	"generate T2S code from tiled code")
 ISL_ARG_INT(struct autosa_options, t2s_tile_phase, 0,
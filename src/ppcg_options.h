@@ -31,6 +31,12 @@ extern "C"
 		int max_sa_dim;
 		/* Systolic array type. */
 		int sa_type;
+		/* Explore skewed space-time transformations. */
+		int sa_skew;
+		/* Cost model used to rank the space-time candidates. */
+		int sa_cost_model;
+		/* Explore alternative schedules in parallel worker processes. */
+		int explore_schedules;
 		/* Universal tile size. */
 		int sa_tile_size;
 		/* Tile sizes for PE optimization. */
@@ -53,14 +59,20 @@ extern "C"
 		int credit_control;
 		/* Enable two-level buffering in I/O modules. */
 		int two_level_buffer;
+		/* Enable three-level buffering (on-chip L3 buffers) in I/O modules. */
+		int three_level_buffer;
 		/* Configuration file. */
 		char *config;
 		/* Output directory. */
 		char *output_dir;
+		/* Write the latency/resource estimation info into a single design summary. */
+		int design_summary;
 		/* SIMD information file. */
 		char *simd_info;
 		/* Generate HLS host instead of OpenCL host. */
 		int hls;
+		/* Hardware information file used in the auto mode. */
+		char *hw_info;
 		/* Use URAM. */
 		int uram;
 		/* Print verbose information. */
@@ -69,8 +81,18 @@ extern "C"
 		int insert_hls_dependence;
 		/* Embed I/O modules inside PEs. */
 		int io_module_embedding;
+		/* Cache the I/O grouping and clustering across design variations. */
+		int io_group_cache;
+		/* Cache the dependence analysis results on disk. */
+		int dep_cache;
+		/* Skew time-iterated stencils using the hybrid tiling bounds. */
+		int hybrid_tile;
+		/* Prune the code of idle PEs for non-rectangular iteration domains. */
+		int prune_idle_pe;
 		/* Enable loop infinitization optimization. Only for Intel. */
 		int loop_infinitize;
+		/* Flatten perfect loop nests around pipelined loops. Only for Xilinx. */
+		int loop_flatten;
 		/* Enable data serialization/deserialization on the host side. */
 		int host_serialize;
 		/* Use non-blocking FIFO access. Note: Not supported. */
@@ -94,6 +116,8 @@ extern "C"
 		int fifo_depth;
 		/* Touch space loops in the SIMD vectorization */
 		int simd_touch_space;
+		/* Combine the SIMD lanes of reduction loops with a balanced adder tree */
+		int simd_reduce_tree;
 		/* Use block sparsity */
 		int block_sparse;
 		/* Block sparse ratio [nonzero, vec_len] */
@@ -102,6 +126,9 @@ extern "C"
 		int hcl;
 		/* Apply array contraction. */
 		int array_contraction;
+		/* Apply array contraction to the arrays local to the program
+		 * without local reduction. */
+		int local_array_contraction;
 		/* Sinking time loops using ISL default APIs. */
 		int isl_sink;
 		/* Reverse the loop tiling order. */
@@ -205,6 +232,9 @@ extern "C"
 #define AUTOSA_SA_TYPE_SYNC 0
 #define AUTOSA_SA_TYPE_ASYNC 1
 
+#define AUTOSA_SA_COST_HEURISTIC 0
+#define AUTOSA_SA_COST_ANALYTICAL 1
+
 	void ppcg_options_set_target_defaults(struct ppcg_options *options);
 
 #ifdef __cplusplus